@@ -26,6 +26,28 @@ internal class LocalSessionController : SessionController
     bool _dataReady = false;
     bool _needsFlash = false;
     RequestIdent _ident = default;
+    // rates tried after the ident, fastest first, when the device has a real UART
+    static readonly uint[] _baudRates = [2000000, 921600, 460800, 230400];
+    const int _crcErrorsToFallBack = 4;   // in one check interval while above the default rate
+    uint _baudCeiling = uint.MaxValue;    // lowered when a rate fails. Kept across reconnects
+    bool _baudTried;
+    bool _baudVerifying;
+    int _crcMark;
+    long _crcMarkTicks;
+    const int _window = 8;                // frames in flight asked for, if the device takes that many
+    bool _windowTried;
+    // CMD_SUBSCRIBE: CMD_DATA is pushed for this screen on a timer instead of
+    // answering a request per sample
+    const int _minPushIntervalMs = 20;
+    int _subscribedScreen = -1;
+    int _pushIntervalMs;
+    long _lastPushTicks;
+    System.Threading.Timer? _pushTimer;
+    // CMD_DATA_DELTA, for devices that take it. A full CMD_DATA goes out first
+    // and then every few seconds, in case the device lost track
+    readonly DataDeltaEncoder _dataDelta = new DataDeltaEncoder();
+    const int _dataKeySeconds = 5;
+    long _dataKeyTicks;
     public LocalSessionController(PortController parent, string portName, string serialNumber,DeviceController? device) : base(parent, portName, serialNumber)
     {
         Device = device;
@@ -71,15 +93,49 @@ internal class LocalSessionController : SessionController
                         }
                     }
                     break;
+                case Command.CmdSubscribe:
+                    {
+                        if (RequestSubscribe.TryRead(e.Data, out var req, out _))
+                        {
+                            _Subscribe(req.ScreenIndex, req.IntervalMS);
+                        }
+                    }
+                    break;
                 case Command.CmdIdent:
-                    RequestIdent.TryRead(e.Data, out _ident, out _);
+                    if (!RequestIdent.TryRead(e.Data, out _ident, out _))
+                    {
+                        // older firmware doesn't send the fields at the end. read them as 0
+                        var padded = new byte[e.Data.Length + RequestIdent.StructMaxSize];
+                        e.Data.CopyTo(padded, 0);
+                        RequestIdent.TryRead(padded, out _ident, out _);
+                    }
                     _gotIdentTicks = Stopwatch.GetTimestamp();
+                    // it may have rebooted
+                    _dataDelta.Reset();
+                    break;
+                case Command.CmdStats:
+                    if (RequestStats.TryRead(e.Data, out var stats, out _))
+                    {
+                        _LogStats(stats);
+                    }
                     break;
 
             }
         }
     }
 
+    // the device's own numbers, sent every few seconds while it's connected
+    void _LogStats(in RequestStats stats)
+    {
+        Debug.WriteLine($"{PortName} ({_ident.Slug}) over {stats.IntervalMS}ms: " +
+            $"{stats.Frames} frames, render {stats.RenderMinUS}/{stats.RenderAvgUS}/{stats.RenderP99US}us min/avg/p99, " +
+            $"{stats.FlushBytes} bytes flushed, {stats.FlushStalls} flush stalls, " +
+            $"UART {stats.Port1.Retransmits} retransmits/{stats.Port1.Nacks} NACKs/{stats.RXOverflows} overflows, " +
+            $"USB {stats.Port2.Retransmits} retransmits/{stats.Port2.Nacks} NACKs, " +
+            $"heap {stats.FreeHeap} free/{stats.LargestFreeBlock} largest, " +
+            $"PSRAM {stats.FreePsram} free/{stats.LargestFreePsram} largest");
+    }
+
     private void _transport_FrameError(object? sender, FrameErrorEventArgs e)
     {
         Disconnect();
@@ -105,6 +161,11 @@ internal class LocalSessionController : SessionController
             _startIdentTicks = 0;
             _gotIdentTicks = 0;
             _needsFlash = false;
+            _baudTried = false;
+            _baudVerifying = false;
+            _windowTried = false;
+            _Subscribe(-1, 0);
+            _dataDelta.Reset();
             _transport.Open();
             Status = SessionStatus.Connecting;
         }
@@ -120,8 +181,160 @@ internal class LocalSessionController : SessionController
         _startIdentTicks = 0;
         _gotIdentTicks = 0;
         _needsFlash = false;
+        _baudTried = false;
+        _baudVerifying = false;
+        _windowTried = false;
+        _Subscribe(-1, 0);
+        _dataDelta.Reset();
         Status = SessionStatus.Closed;
     }
+    void _Subscribe(int screenIndex, int intervalMs)
+    {
+        _subscribedScreen = screenIndex;
+        _pushIntervalMs = Math.Max(intervalMs, _minPushIntervalMs);
+        if (screenIndex < 0)
+        {
+            _pushTimer?.Change(Timeout.Infinite, Timeout.Infinite);
+            return;
+        }
+        _lastPushTicks = 0;
+        _pushTimer ??= new System.Threading.Timer(_pushTimer_Tick, null, Timeout.Infinite, Timeout.Infinite);
+        _pushTimer.Change(0, _pushIntervalMs);
+    }
+    void _pushTimer_Tick(object? state)
+    {
+        if (IsDisposed) return;
+        Post(_Push);
+    }
+    // Pushes when the subscription's interval (or the screen's, if longer) is
+    // up. Only once the last frame is acked, so a device that renders slower
+    // than this is pushed to at its own pace, and always gets the latest values
+    void _Push()
+    {
+        if (IsDisposed || Status != SessionStatus.Busy || !_transport.IsOpen ||
+            _subscribedScreen < 0 || _subscribedScreen != ScreenIndex)
+        {
+            return;
+        }
+        var scr = Screen;
+        if (scr == null)
+        {
+            return;
+        }
+        var intervalMs = Math.Max(_pushIntervalMs, scr.Interval);
+        if (_lastPushTicks != 0 && Stopwatch.GetElapsedTime(_lastPushTicks).TotalMilliseconds < intervalMs)
+        {
+            return;
+        }
+        if (_transport.Backlog > 0)
+        {
+            return;
+        }
+        _lastPushTicks = Stopwatch.GetTimestamp();
+        _SendData(scr);
+    }
+    void _SendData(ScreenController scr)
+    {
+        var args = new ScreenDataEventArgs(
+            ScreenIndex,
+            scr.Top.Value1.Value,
+            scr.Top.Value1.Scaled,
+            scr.Top.Value2.Value,
+            scr.Top.Value2.Scaled,
+            scr.Bottom.Value1.Value,
+            scr.Bottom.Value1.Scaled,
+            scr.Bottom.Value2.Value,
+            scr.Bottom.Value2.Scaled
+        );
+        OnScreenData(args);
+    }
+    // Asks the device to switch to the fastest rate both ends allow, then
+    // idents again at that rate to make sure the link works there
+    bool _TryRaiseBaud()
+    {
+        _baudTried = true;
+        uint rate = 0;
+        foreach (var r in _baudRates)
+        {
+            if (r <= _ident.MaxBaud && r <= _baudCeiling)
+            {
+                rate = r;
+                break;
+            }
+        }
+        if (rate <= EspSerialSession.DefaultBaudRate)
+        {
+            return false;
+        }
+        if (!_SendBaud(rate))
+        {
+            return false;
+        }
+        _gotIdentTicks = 0;
+        _startIdentTicks = Stopwatch.GetTimestamp();
+        _baudVerifying = true;
+        _transport.Send((byte)Command.CmdIdent, Array.Empty<byte>());
+        return true;
+    }
+    bool _SendBaud(uint rate)
+    {
+        var packet = new ResponseBaud() { Baud = rate };
+        Span<byte> tmp = stackalloc byte[ResponseBaud.StructMaxSize];
+        if (!packet.TryWrite(tmp, out var written))
+        {
+            return false;
+        }
+        Debug.WriteLine($"Switching {PortName} to {rate} baud");
+        _transport.SendAndSwitchBaud((byte)Command.CmdBaud, tmp.Slice(0, written), rate);
+        _crcMark = _transport.CrcErrors;
+        _crcMarkTicks = Stopwatch.GetTimestamp();
+        return true;
+    }
+    // Lets frames pipeline instead of each waiting on the last one's ACK.
+    // What's sent after this goes out windowed once the device acks it
+    void _SwitchWindow()
+    {
+        _windowTried = true;
+        var packet = new ResponseWindow() { Size = (byte)Math.Min((int)_ident.MaxWindow, _window) };
+        Span<byte> tmp = stackalloc byte[ResponseWindow.StructMaxSize];
+        if (packet.TryWrite(tmp, out var written))
+        {
+            _transport.SendAndSwitchWindow((byte)Command.CmdWindow, tmp.Slice(0, written), packet.Size);
+        }
+    }
+    // The next rate down from the current one, or the default
+    uint _LowerBaud()
+    {
+        var current = _transport.BaudRate;
+        foreach (var r in _baudRates)
+        {
+            if (r < current)
+            {
+                return r;
+            }
+        }
+        return EspSerialSession.DefaultBaudRate;
+    }
+    // Steps down a rate when CRC errors pile up. The device goes back to the
+    // default by itself if the link gets too bad to carry the request
+    void _CheckBaud()
+    {
+        if (_transport.BaudRate == EspSerialSession.DefaultBaudRate ||
+            Stopwatch.GetElapsedTime(_crcMarkTicks).TotalSeconds < 2)
+        {
+            return;
+        }
+        var errors = _transport.CrcErrors - _crcMark;
+        _crcMark = _transport.CrcErrors;
+        _crcMarkTicks = Stopwatch.GetTimestamp();
+        if (errors >= _crcErrorsToFallBack)
+        {
+            var rate = _LowerBaud();
+            _baudCeiling = rate;
+            Debug.WriteLine($"{errors} CRC errors on {PortName} at {_transport.BaudRate} baud");
+            _SendBaud(rate);
+        }
+    }
     private sealed class InnerOpenFlashProgress : IProgress<int>
     {
         IFlashProgress _inner;
@@ -399,19 +612,35 @@ internal class LocalSessionController : SessionController
         if (Screen != null)
         {
             var packet = _ToResponseData(Screen);
-            Span<byte> tmp = stackalloc byte[ResponseData.StructMaxSize];
-            if (packet.TryWrite(tmp, out _))
+            try
             {
-                try
+                if (_ident.DataDelta &&
+                    Stopwatch.GetElapsedTime(_dataKeyTicks).TotalSeconds < _dataKeySeconds &&
+                    _dataDelta.TryEncode(packet, out var delta))
                 {
-                    _transport.Send((byte)Command.CmdData, tmp);
-                    _dataReady = false;
+                    Span<byte> tmp = stackalloc byte[ResponseDataDelta.StructMaxSize];
+                    if (delta.TryWrite(tmp, out var written))
+                    {
+                        _transport.Send((byte)Command.CmdDataDelta, tmp.Slice(0, written));
+                        _dataReady = false;
+                    }
                 }
-                catch (Win32Exception)
+                else
                 {
-                    Disconnect();
+                    Span<byte> tmp = stackalloc byte[ResponseData.StructMaxSize];
+                    if (packet.TryWrite(tmp, out _))
+                    {
+                        _transport.Send((byte)Command.CmdData, tmp);
+                        _dataDelta.Key(packet);
+                        _dataKeyTicks = Stopwatch.GetTimestamp();
+                        _dataReady = false;
+                    }
                 }
             }
+            catch (Win32Exception)
+            {
+                Disconnect();
+            }
         }
         base.OnScreenData(args);
     }
@@ -499,6 +728,18 @@ internal class LocalSessionController : SessionController
                 } 
                 break;
             case SessionStatus.Busy:
+                if (_transport != null && _transport.IsOpen)
+                {
+                    try
+                    {
+                        _CheckBaud();
+                    }
+                    catch (Win32Exception)
+                    {
+                        Disconnect();
+                        break;
+                    }
+                }
 
                 if (_needScreen > -1 && _transport != null && _transport.IsOpen && Device != null && Device.Screens.Count > 0)
                 {
@@ -513,19 +754,7 @@ internal class LocalSessionController : SessionController
                     var scr = Screen;
                     if (scr != null)
                     {
-                        var args = new ScreenDataEventArgs(
-                            ScreenIndex,
-                            scr.Top.Value1.Value,
-                            scr.Top.Value1.Scaled,
-                            scr.Top.Value2.Value,
-                            scr.Top.Value2.Scaled,
-                            scr.Bottom.Value1.Value,
-                            scr.Bottom.Value1.Scaled,
-                            scr.Bottom.Value2.Value,
-                            scr.Bottom.Value2.Scaled
-                        );
-                        OnScreenData(args);
-
+                        _SendData(scr);
                     }
                 }
                 break;
@@ -538,7 +767,35 @@ internal class LocalSessionController : SessionController
                     }
                     else if (_gotIdentTicks != 0 && !string.IsNullOrEmpty(_ident.Slug))
                     {
-         
+                        if (!_baudTried && _ident.MaxBaud > EspSerialSession.DefaultBaudRate)
+                        {
+                            _ident.Slug = "";
+                            try
+                            {
+                                if (_TryRaiseBaud())
+                                {
+                                    break;
+                                }
+                            }
+                            catch (Win32Exception)
+                            {
+                                Disconnect();
+                                break;
+                            }
+                        }
+                        _baudVerifying = false;
+                        if (!_windowTried && _ident.MaxWindow > 1)
+                        {
+                            try
+                            {
+                                _SwitchWindow();
+                            }
+                            catch (Win32Exception)
+                            {
+                                Disconnect();
+                                break;
+                            }
+                        }
                         var device = Parent.GetDeviceByMac(_ident.MacAddress);
 
                         Id = _ident.ID;
@@ -595,6 +852,24 @@ internal class LocalSessionController : SessionController
                             Status = SessionStatus.Busy;
                         }
                     }
+                    else if (_baudVerifying && Stopwatch.GetElapsedTime(_startIdentTicks).TotalSeconds > 3)
+                    {
+                        // no ident at the new rate. The device has gone back to the
+                        // default by now, and the ident is resent at that rate
+                        Debug.WriteLine($"{PortName} failed at {_transport.BaudRate} baud");
+                        _baudVerifying = false;
+                        _baudCeiling = _LowerBaud();
+                        try
+                        {
+                            _transport.SetBaudRate(EspSerialSession.DefaultBaudRate);
+                        }
+                        catch (Win32Exception)
+                        {
+                            Disconnect();
+                            break;
+                        }
+                        _startIdentTicks = Stopwatch.GetTimestamp();
+                    }
                     else if (TimeSpan.FromTicks(Stopwatch.GetTimestamp() - _startIdentTicks).TotalSeconds > 3)
                     {
                         if (_identRetries > 0)
@@ -637,6 +912,8 @@ internal class LocalSessionController : SessionController
     }
     protected override void OnDispose()
     {
+        _pushTimer?.Dispose();
+        _pushTimer = null;
         _transport?.Close();
     }
 }
@@ -0,0 +1,118 @@
+﻿namespace Espmon;
+
+// Encodes CMD_DATA as CMD_DATA_DELTA, the changes from the last one sent.
+// The format is in common/interface.h. Values are quantized exactly the way
+// the firmware's data_delta.c does it, so both ends always agree on what
+// the next changes are from
+internal sealed class DataDeltaEncoder
+{
+    const int _slots = 4;
+    const long _nan = long.MinValue;
+    const long _limit = 4000000000000000000;
+    readonly long[] _values = new long[_slots];
+    readonly ushort[] _scaled = new ushort[_slots];
+    bool _valid;
+
+    // Until the next Key(), TryEncode() fails
+    public void Reset()
+    {
+        _valid = false;
+    }
+    // Makes a full CMD_DATA, once it's sent, what the next changes are from
+    public void Key(in ResponseData data)
+    {
+        for (int i = 0; i < _slots; ++i)
+        {
+            var v = _Slot(data, i);
+            _values[i] = _QuantizeValue(v.Value);
+            _scaled[i] = _QuantizeScaled(v.Scaled);
+        }
+        _valid = true;
+    }
+    // Encodes data against the last one and assumes it gets sent. False
+    // until a full CMD_DATA has been keyed
+    public bool TryEncode(in ResponseData data, out ResponseDataDelta delta)
+    {
+        delta = default;
+        if (!_valid)
+        {
+            return false;
+        }
+        Span<byte> buf = stackalloc byte[48];
+        int length = 0;
+        byte changed = 0;
+        for (int i = 0; i < _slots; ++i)
+        {
+            var v = _Slot(data, i);
+            var value = _QuantizeValue(v.Value);
+            var scaled = _QuantizeScaled(v.Scaled);
+            if (value != _values[i])
+            {
+                changed |= (byte)(1 << i);
+                // wraps the same as the firmware's unsigned add
+                long d = unchecked(value - _values[i]);
+                ulong zz = unchecked((ulong)((d << 1) ^ (d >> 63)));
+                do
+                {
+                    byte b = (byte)(zz & 0x7F);
+                    zz >>= 7;
+                    if (zz != 0)
+                    {
+                        b |= 0x80;
+                    }
+                    buf[length++] = b;
+                } while (zz != 0);
+                _values[i] = value;
+            }
+            if (scaled != _scaled[i])
+            {
+                changed |= (byte)(1 << (i + 4));
+                buf[length++] = (byte)scaled;
+                buf[length++] = (byte)(scaled >> 8);
+                _scaled[i] = scaled;
+            }
+        }
+        delta.Changed = changed;
+        delta.Deltas = buf.Slice(0, length).ToArray();
+        return true;
+    }
+    static ResponseValue _Slot(in ResponseData data, int index)
+    {
+        return index switch
+        {
+            0 => data.Top.Value1,
+            1 => data.Top.Value2,
+            2 => data.Bottom.Value1,
+            _ => data.Bottom.Value2
+        };
+    }
+    static long _QuantizeValue(float value)
+    {
+        if (float.IsNaN(value))
+        {
+            return _nan;
+        }
+        double d = (double)value * 100.0;
+        if (d >= _limit)
+        {
+            return _limit;
+        }
+        if (d <= -_limit)
+        {
+            return -_limit;
+        }
+        return (long)Math.Round(d, MidpointRounding.AwayFromZero);
+    }
+    static ushort _QuantizeScaled(float scaled)
+    {
+        if (float.IsNaN(scaled) || scaled <= 0f)
+        {
+            return 0;
+        }
+        if (scaled >= 1f)
+        {
+            return 65535;
+        }
+        return (ushort)Math.Round((double)scaled * 65535.0, MidpointRounding.AwayFromZero);
+    }
+}
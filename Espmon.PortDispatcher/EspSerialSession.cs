@@ -148,7 +148,12 @@ internal partial class EspSerialSession : IDisposable
 
     const int FrameHeaderLength = 17;          // 8 marker + 1 seq/type + 4 len + 4 crc
     const int MaxFrameLength = 32768;        // read bound; over this we NACK+resync
-    const int TypeData = 0, TypeAck = 1, TypeNack = 2;
+    // the largest frame the device sends. A length past it is corrupt, and is
+    // caught in the header instead of after reading that many bytes
+    const int MaxReceiveLength = InterfaceMaxSize.Value;
+    const int TypeData = 0, TypeAck = 1, TypeNack = 2, TypeCumulativeAck = 3;
+    public const uint DefaultBaudRate = 115200;   // both ends start here and fall back to it
+    public const int MaxWindow = 32;              // half the 6 bit seq space, for selective repeat
 
     readonly object _arq = new object();   // guards the ARQ state below
     readonly object _sendLock = new object();   // keeps one frame contiguous on the wire
@@ -162,7 +167,25 @@ internal partial class EspSerialSession : IDisposable
     int _ackTimeoutMs;                 // -1 = explicit mode: NACK -> event, no timer, no auto-give-up
     int _maxRetries = 5;
     int _retries;                      // timeout-driven resends so far (NACKs never counted)
-    readonly Queue<(byte cmd, byte[] data)> _sendQueue = new();
+    readonly Queue<(byte cmd, byte[] data, uint baud, int window)> _sendQueue = new();
+    // Window mode, after SendAndSwitchWindow(): up to _window DATA frames in flight,
+    // acked cumulatively by TypeCumulativeAck. A NACK resends just the frame it names,
+    // and frames received past a gap are held until it fills. _retain is the oldest
+    // unacked frame. 1 is stop-and-wait, which every link starts in
+    int _window = 1;
+    byte _txBase;                      // oldest unacked seq
+    int _inFlight;
+    readonly byte[]?[] _outstanding = new byte[]?[64];                  // unacked frames by seq
+    readonly (byte cmd, byte[] data)?[] _held = new (byte, byte[])?[64];  // out of order frames by seq
+    bool _rxNacked;                    // _expectedRxSeq was already asked for
+    // the frame with _switchSeq changes the rate or the window once it's acked.
+    // Nothing else goes out while it's in flight
+    bool _switchPending;
+    byte _switchSeq;
+    uint _switchBaud;
+    int _switchWindow;
+    uint _baudRate = DefaultBaudRate;
+    int _crcErrors;
     System.Threading.Timer? _ackTimer;
 
     public event EventHandler<ResendRequestedEventArgs>? ResendRequested;  // explicit mode only
@@ -367,30 +390,107 @@ internal partial class EspSerialSession : IDisposable
         }
     }
     // Called holding _arq. Stamps seq, builds+retains, arms timer, returns bytes to write.
-    byte[] PrepareTransmit(byte cmd, byte[] payload)
+    byte[] PrepareTransmit(byte cmd, byte[] payload, uint baud, int window)
     {
         _txSeq = (byte)((_txSeq + 1) & 0x3F);
         var frame = BuildDataFrame(cmd, _txSeq, payload);
+        if (_window > 1)
+        {
+            _outstanding[_txSeq] = frame;
+            if (_inFlight++ > 0)
+            {
+                // the timer keeps running for the oldest one
+                if (baud != 0 || window != 0) SetSwitch(baud, window);
+                return frame;
+            }
+            _txBase = _txSeq;
+        }
         _retain = frame;
         _awaiting = true;
         _retries = 0;
         _deliveryNotified = false;
+        if (baud != 0 || window != 0) SetSwitch(baud, window);
         ArmAckTimer();
         return frame;
     }
+    void SetSwitch(uint baud, int window)
+    {
+        _switchPending = true;
+        _switchSeq = _txSeq;
+        _switchBaud = baud;
+        _switchWindow = window;
+    }
+    // Called holding _arq once the switch frame is acked. Returns the rate to change to, or 0
+    uint CompleteSwitch()
+    {
+        _switchPending = false;
+        if (_switchWindow > 1)
+        {
+            // both ends start the window at seq 0
+            _window = _switchWindow;
+            _txSeq = 0x3F;
+            _txBase = 0;
+            _inFlight = 0;
+            _expectedRxSeq = 0;
+            _rxNacked = false;
+            Array.Clear(_outstanding);
+            Array.Clear(_held);
+        }
+        return _switchBaud;
+    }
+    // Called holding _arq
+    bool CanTransmit() => _window > 1 ? !_switchPending && _inFlight < _window : !_awaiting;
+    // Called holding _arq. Starts what the window has room for
+    List<byte[]>? DrainQueue()
+    {
+        List<byte[]>? result = null;
+        while (_sendQueue.Count > 0 && CanTransmit())
+        {
+            var (cmd, data, baud, window) = _sendQueue.Dequeue();
+            (result ??= new List<byte[]>()).Add(PrepareTransmit(cmd, data, baud, window));
+        }
+        return result;
+    }
 
-    public void Send(byte cmd, ReadOnlySpan<byte> data)
+    public void Send(byte cmd, ReadOnlySpan<byte> data) => Send(cmd, data, 0, 0);
+
+    /// <summary>
+    /// Sends a frame, and once the device acks it, switches the port to
+    /// <paramref name="baud"/> before anything else goes out. The device
+    /// changes its rate after sending that ACK, so frames queued behind this
+    /// one go out at the new rate on both ends.
+    /// </summary>
+    public void SendAndSwitchBaud(byte cmd, ReadOnlySpan<byte> data, uint baud)
+    {
+        ArgumentOutOfRangeException.ThrowIfZero(baud, nameof(baud));
+        Send(cmd, data, baud, 0);
+    }
+
+    /// <summary>
+    /// Sends a frame, and once the device acks it, lets up to
+    /// <paramref name="window"/> frames be in flight. The device switches after
+    /// sending that ACK, and both ends restart their sequence numbers at 0.
+    /// </summary>
+    public void SendAndSwitchWindow(byte cmd, ReadOnlySpan<byte> data, int window)
+    {
+        ArgumentOutOfRangeException.ThrowIfLessThan(window, 2, nameof(window));
+        ArgumentOutOfRangeException.ThrowIfGreaterThan(window, MaxWindow, nameof(window));
+        Send(cmd, data, 0, window);
+    }
+
+    void Send(byte cmd, ReadOnlySpan<byte> data, uint baud, int window)
     {
         ArgumentOutOfRangeException.ThrowIfGreaterThan(cmd, 127, nameof(cmd));
         if (cmd < 1) throw new ArgumentOutOfRangeException(nameof(cmd), "cmd must be 1..127");
         if (data.Length > MaxFrameLength) throw new ArgumentOutOfRangeException(nameof(data));
 
-        byte[] copy = data.ToArray();      // stop-and-wait: caller's span need not outlive the call
+        byte[] copy = data.ToArray();      // the frame may be queued: caller's span need not outlive the call
         byte[]? toWrite = null;
         lock (_arq)
         {
-            if (_awaiting) _sendQueue.Enqueue((cmd, copy));   // one in flight; queue the rest
-            else toWrite = PrepareTransmit(cmd, copy);
+            // no room in flight; queue the rest
+            if (_sendQueue.Count > 0 || !CanTransmit()) _sendQueue.Enqueue((cmd, copy, baud, window));
+            else toWrite = PrepareTransmit(cmd, copy, baud, window);
         }
         if (toWrite != null) WriteFrame(toWrite);
     }
@@ -629,33 +729,85 @@ internal partial class EspSerialSession : IDisposable
     }
     void HandleAck(byte seq)
     {
-        byte[]? next = null;
+        List<byte[]>? next;
+        uint baud = 0;
         lock (_arq)
         {
-            if (!_awaiting || seq != _txSeq) return;   // stale/duplicate ack
+            // in window mode this is left over from before the switch
+            if (_window > 1 || !_awaiting || seq != _txSeq) return;   // stale/duplicate ack
             _awaiting = false;
             DisarmAckTimer();
-            if (_sendQueue.Count > 0)
+            if (_switchPending && seq == _switchSeq) baud = CompleteSwitch();
+            next = DrainQueue();
+        }
+        ApplyBaud(baud);
+        if (next != null) foreach (var frame in next) WriteFrame(frame);
+    }
+
+    void HandleCumulativeAck(byte seq)
+    {
+        List<byte[]>? next;
+        uint baud = 0;
+        lock (_arq)
+        {
+            if (_window <= 1 || _inFlight == 0) return;
+            int acked = ((seq - _txBase) & 0x3F) + 1;
+            if (acked > _inFlight) return;             // stale/duplicate ack
+            if (_switchPending && ((_switchSeq - _txBase) & 0x3F) < acked) baud = CompleteSwitch();
+            for (int i = 0; i < acked; ++i) _outstanding[(_txBase + i) & 0x3F] = null;
+            _txBase = (byte)((_txBase + acked) & 0x3F);
+            _inFlight -= acked;
+            _retries = 0;
+            _deliveryNotified = false;
+            if (_inFlight > 0)
+            {
+                _retain = _outstanding[_txBase];
+                ArmAckTimer();                         // restart for the new oldest frame
+            }
+            else
             {
-                var (cmd, data) = _sendQueue.Dequeue();
-                next = PrepareTransmit(cmd, data);
+                _retain = null;
+                _awaiting = false;
+                DisarmAckTimer();
+            }
+            next = DrainQueue();
+        }
+        ApplyBaud(baud);
+        if (next != null) foreach (var frame in next) WriteFrame(frame);
+    }
+
+    void ApplyBaud(uint baud)
+    {
+        if (baud != 0)
+        {
+            try { SetBaudRate(baud); }
+            catch (Win32Exception)
+            {
+                if (!_closing) OnConnectionError(EventArgs.Empty);
             }
         }
-        if (next != null) WriteFrame(next);
     }
 
     void HandleNack(byte seq)
     {
         bool explicitMode; byte cmd, s;
+        byte[]? frame = null;
         lock (_arq)
         {
             if (!_awaiting) return;
+            if (_window > 1)
+            {
+                // selective: resend only the frame asked for
+                if (((seq - _txBase) & 0x3F) < _inFlight) frame = _outstanding[seq];
+                if (frame == null) return;
+            }
             explicitMode = _ackTimeoutMs < 0;
             cmd = (byte)(_retain![0] - 128);
             s = _txSeq;
             // deliberately: no _retries change, no ArmAckTimer() — the running timeout guards termination
         }
-        if (explicitMode) OnResendRequested(new ResendRequestedEventArgs(cmd, s));
+        if (frame != null) WriteFrame(frame);
+        else if (explicitMode) OnResendRequested(new ResendRequestedEventArgs(cmd, s));
         else Resend();
     }
 
@@ -671,7 +823,7 @@ internal partial class EspSerialSession : IDisposable
             if (_retries >= _maxRetries && !_deliveryNotified)
             {
                 _deliveryNotified = true;           // one-shot "not getting through" notice
-                failure = new FrameErrorEventArgs((byte)(_retain![0] - 128), _txSeq, _retries);
+                failure = new FrameErrorEventArgs((byte)(_retain![0] - 128), _window > 1 ? _txBase : _txSeq, _retries);
             }
             ArmAckTimer();                          // never stops on its own; only an ACK or Close() ends it
         }
@@ -689,10 +841,16 @@ internal partial class EspSerialSession : IDisposable
         {
             if (type == TypeAck) HandleAck(seq);
             else if (type == TypeNack) HandleNack(seq);
-            return;                                    // reserved types ignored
+            else if (type == TypeCumulativeAck) HandleCumulativeAck(seq);
+            return;
         }
 
         byte cmd = (byte)(rawCmd - 128);               // DATA frame
+        if (Window > 1)
+        {
+            ReceiveWindowed(cmd, seq, payload);
+            return;
+        }
         byte expected; lock (_arq) expected = _expectedRxSeq;
 
         if (seq == expected)
@@ -710,6 +868,48 @@ internal partial class EspSerialSession : IDisposable
             SendControl(TypeNack, expected);           // gap: ask for what we expect
         }
     }
+    void ReceiveWindowed(byte cmd, byte seq, byte[] payload)
+    {
+        List<FrameReceivedEventArgs>? deliver = null;
+        int reply = -1;
+        byte replySeq = 0;
+        lock (_arq)
+        {
+            int ahead = (seq - _expectedRxSeq) & 0x3F;
+            if (ahead == 0)
+            {
+                // in order, along with whatever was held behind the gap it fills
+                deliver = [new FrameReceivedEventArgs(cmd, payload)];
+                _expectedRxSeq = (byte)((_expectedRxSeq + 1) & 0x3F);
+                while (_held[_expectedRxSeq] is { } held)
+                {
+                    deliver.Add(new FrameReceivedEventArgs(held.cmd, held.data));
+                    _held[_expectedRxSeq] = null;
+                    _expectedRxSeq = (byte)((_expectedRxSeq + 1) & 0x3F);
+                }
+                _rxNacked = false;
+                reply = TypeCumulativeAck;
+                replySeq = (byte)((_expectedRxSeq - 1) & 0x3F);
+            }
+            else if (ahead < _window)
+            {
+                _held[seq] ??= (cmd, payload);         // past a gap: hold it, ask for the gap once
+                if (!_rxNacked)
+                {
+                    _rxNacked = true;
+                    reply = TypeNack;
+                    replySeq = _expectedRxSeq;
+                }
+            }
+            else if (((_expectedRxSeq - seq) & 0x3F) <= _window)
+            {
+                reply = TypeCumulativeAck;             // duplicate (our ack was lost): re-ack only
+                replySeq = (byte)((_expectedRxSeq - 1) & 0x3F);
+            }
+        }
+        if (reply >= 0) SendControl(reply, replySeq);
+        if (deliver != null) foreach (var args in deliver) OnFrameReceived(args);
+    }
     public void Open()
     {
         if (IsOpen) return;
@@ -722,7 +922,14 @@ internal partial class EspSerialSession : IDisposable
             _awaiting = false;
             _retries = 0;
             _sendQueue.Clear();
+            _window = 1;
+            _inFlight = 0;
+            _rxNacked = false;
+            _switchPending = false;
+            Array.Clear(_outstanding);
+            Array.Clear(_held);
         }
+        _crcErrors = 0;
         _ackTimer ??= new System.Threading.Timer(OnAckTimeout, null, Timeout.Infinite, Timeout.Infinite);
         var rawHandle = CreateFile(
                     $@"\\.\{_portName}",
@@ -750,7 +957,7 @@ internal partial class EspSerialSession : IDisposable
             throw new Win32Exception(Marshal.GetLastWin32Error());
         }
 
-        dcb.BaudRate = 115200;
+        dcb.BaudRate = DefaultBaudRate;
         dcb.ByteSize = 8;
         dcb.Parity = 0;
         dcb.StopBits = 0;
@@ -758,6 +965,7 @@ internal partial class EspSerialSession : IDisposable
         {
             throw new Win32Exception(Marshal.GetLastWin32Error());
         }
+        _baudRate = DefaultBaudRate;
 
         if (!SetCommMask(_handle, EV_RLSD))
         {
@@ -817,7 +1025,7 @@ internal partial class EspSerialSession : IDisposable
                         if (_closing) break;
                         int len = mach.Length;
 
-                        if (len < 0 || len > MaxFrameLength)          // CRC-protected, but bound the read
+                        if (len < 0 || len > MaxReceiveLength)        // CRC-protected, but bound the read
                         {
                             SendControl(TypeNack, VolatileExpectedRxSeq());
                             mach.Reset();
@@ -829,6 +1037,7 @@ internal partial class EspSerialSession : IDisposable
 
                         if (Crc32(mach.RawSeqByte, len, payload) != mach.Crc)
                         {
+                            Interlocked.Increment(ref _crcErrors);
                             SendControl(TypeNack, VolatileExpectedRxSeq());   // corrupt: seq untrustworthy
                             mach.Reset();
                             continue;
@@ -957,6 +1166,51 @@ internal partial class EspSerialSession : IDisposable
         _ackTimer = new System.Threading.Timer(OnAckTimeout, null, Timeout.Infinite, Timeout.Infinite);
     }
 
+    /// <summary>
+    /// Changes the port's rate. Takes the send lock, so a frame being written
+    /// finishes at the old rate.
+    /// </summary>
+    public void SetBaudRate(uint baud)
+    {
+        ArgumentOutOfRangeException.ThrowIfZero(baud, nameof(baud));
+        lock (_sendLock)
+        {
+            var handle = _handle;
+            if (handle == null || handle.IsInvalid || handle.IsClosed) return;
+            DCB dcb = default;
+            dcb.DCBlength = (uint)Unsafe.SizeOf<DCB>();
+            if (!GetCommState(handle, ref dcb))
+            {
+                throw new Win32Exception(Marshal.GetLastWin32Error());
+            }
+            dcb.BaudRate = baud;
+            if (!SetCommState(handle, ref dcb))
+            {
+                throw new Win32Exception(Marshal.GetLastWin32Error());
+            }
+            _baudRate = baud;
+        }
+    }
+    public uint BaudRate { get { lock (_sendLock) return _baudRate; } }
+    /// <summary>
+    /// The frames that may be in flight at once. 1 until SendAndSwitchWindow() is acked
+    /// </summary>
+    public int Window { get { lock (_arq) return _window; } }
+    /// <summary>
+    /// Frames sent and not yet acked, plus those queued behind them
+    /// </summary>
+    public int Backlog
+    {
+        get
+        {
+            lock (_arq) return (_window > 1 ? _inFlight : (_awaiting ? 1 : 0)) + _sendQueue.Count;
+        }
+    }
+    /// <summary>
+    /// Frames dropped because their CRC didn't match since the port was opened
+    /// </summary>
+    public int CrcErrors => Volatile.Read(ref _crcErrors);
+
     public int AckTimeout { get { lock (_arq) return _ackTimeoutMs; } set { lock (_arq) _ackTimeoutMs = value; } }
     public int MaxRetries { get { lock (_arq) return _maxRetries; } set { lock (_arq) _maxRetries = value < 0 ? 0 : value; } }
 
@@ -22,6 +22,11 @@ enum Command : byte
     CmdNop = 5,
     CmdClear = 6,
     CmdRefreshScreen = 7,
+    CmdBaud = 8,
+    CmdWindow = 9,
+    CmdSubscribe = 10,
+    CmdDataDelta = 11,
+    CmdStats = 12,
 }
 
 enum InputType : byte
@@ -31,6 +36,12 @@ enum InputType : byte
     InputButton = 2,
 }
 
+[InlineArray(48)]
+struct InterfaceInlineByteLength48
+{
+    private byte _e0;
+}
+
 [InlineArray(12)]
 struct InterfaceInlineByteLength12
 {
@@ -57,7 +68,7 @@ struct InterfaceInlineByteLength64
 
 struct InterfaceMaxSize
 {
-    internal const int Value = 164;
+    internal const int Value = 170;
 }
 
 [StructLayout(LayoutKind.Auto)]
@@ -257,6 +268,98 @@ partial struct ResponseData
     }
 }
 
+[StructLayout(LayoutKind.Auto)]
+partial struct ResponseDataDelta
+{
+    internal const int StructMaxSize = 50;
+
+    internal byte Changed;
+    private InterfaceInlineByteLength48 _deltas;
+    private int _deltasCount;
+    internal byte[] Deltas
+    {
+        get => ((ReadOnlySpan<byte>)_deltas).Slice(0, _deltasCount).ToArray();
+        set { if (value.Length > 48) throw new ArgumentException("value exceeds capacity", nameof(value)); value.CopyTo(((Span<byte>)_deltas)); _deltasCount = value.Length; }
+    }
+    [UnscopedRef] internal ReadOnlySpan<byte> GetDeltasSpan() => ((ReadOnlySpan<byte>)_deltas).Slice(0, _deltasCount);
+
+    internal int SizeOfStruct
+    {
+        get
+        {
+            int size = 0;
+            size += 1;
+            size += 1 + _deltasCount * 1;
+            return size;
+        }
+    }
+
+    internal static bool TryReadCore(ReadOnlySpan<byte> span, out ResponseDataDelta result, out int bytesRead)
+    {
+        result = default;
+        int offset = 0;
+        if (span.Length - offset < 1) { bytesRead = 0; return false; }
+        result.Changed = span[offset];
+        offset += 1;
+        {
+            if (span.Length - offset < 1) { bytesRead = 0; return false; }
+            int _c = (int)(span[offset]); offset += 1;
+            if ((uint)_c > 48) { bytesRead = 0; return false; }
+            for (int i = 0; i < _c; i++)
+            {
+                if (span.Length - offset < 1) { bytesRead = 0; return false; }
+                result._deltas[i] = span[offset];
+                offset += 1;
+            }
+            result._deltasCount = _c;
+        }
+        bytesRead = offset;
+        return true;
+    }
+
+    internal bool TryWriteCore(Span<byte> span, out int bytesWritten)
+    {
+        int offset = 0;
+        if (span.Length - offset < 1) { bytesWritten = 0; return false; }
+        span[offset] = Changed; offset += 1;
+        {
+            int _c = _deltasCount;
+            if ((uint)_c > 48) { bytesWritten = 0; return false; }
+            if (span.Length - offset < 1) { bytesWritten = 0; return false; }
+            span[offset] = (byte)_c; offset += 1;
+            for (int i = 0; i < _c; i++)
+            {
+                if (span.Length - offset < 1) { bytesWritten = 0; return false; }
+                span[offset] = _deltas[i]; offset += 1;
+            }
+        }
+        bytesWritten = offset;
+        return true;
+    }
+
+    internal static bool TryRead(ReadOnlySpan<byte> span, out ResponseDataDelta result, out int bytesRead)
+        => TryReadCore(span, out result, out bytesRead);
+
+    internal bool TryWrite(Span<byte> destination, out int bytesWritten)
+        => TryWriteCore(destination, out bytesWritten);
+
+    internal static bool TryRead(Stream stream, out ResponseDataDelta result, out int bytesRead)
+    {
+        Span<byte> buf = stackalloc byte[StructMaxSize];
+        int n = stream.Read(buf);
+        if (n < StructMaxSize) { result = default; bytesRead = n; return false; }
+        return TryReadCore(buf, out result, out bytesRead);
+    }
+
+    internal bool TryWrite(Stream stream, out int bytesWritten)
+    {
+        Span<byte> buf = stackalloc byte[StructMaxSize];
+        if (!TryWriteCore(buf, out bytesWritten)) return false;
+        stream.Write(buf.Slice(0, bytesWritten));
+        return true;
+    }
+}
+
 [StructLayout(LayoutKind.Auto)]
 partial struct ResponseColor
 {
@@ -779,6 +882,126 @@ partial struct ResponseRefreshScreen
     }
 }
 
+[StructLayout(LayoutKind.Auto)]
+partial struct ResponseBaud
+{
+    internal const int StructMaxSize = 4;
+
+    internal uint Baud;
+
+    internal int SizeOfStruct
+    {
+        get
+        {
+            int size = 0;
+            size += 4;
+            return size;
+        }
+    }
+
+    internal static bool TryReadCore(ReadOnlySpan<byte> span, out ResponseBaud result, out int bytesRead)
+    {
+        result = default;
+        int offset = 0;
+        if (span.Length - offset < 4) { bytesRead = 0; return false; }
+        result.Baud = BinaryPrimitives.ReadUInt32LittleEndian(span.Slice(offset));
+        offset += 4;
+        bytesRead = offset;
+        return true;
+    }
+
+    internal bool TryWriteCore(Span<byte> span, out int bytesWritten)
+    {
+        int offset = 0;
+        if (span.Length - offset < 4) { bytesWritten = 0; return false; }
+        BinaryPrimitives.WriteUInt32LittleEndian(span.Slice(offset), Baud); offset += 4;
+        bytesWritten = offset;
+        return true;
+    }
+
+    internal static bool TryRead(ReadOnlySpan<byte> span, out ResponseBaud result, out int bytesRead)
+        => TryReadCore(span, out result, out bytesRead);
+
+    internal bool TryWrite(Span<byte> destination, out int bytesWritten)
+        => TryWriteCore(destination, out bytesWritten);
+
+    internal static bool TryRead(Stream stream, out ResponseBaud result, out int bytesRead)
+    {
+        Span<byte> buf = stackalloc byte[StructMaxSize];
+        int n = stream.Read(buf);
+        if (n < StructMaxSize) { result = default; bytesRead = n; return false; }
+        return TryReadCore(buf, out result, out bytesRead);
+    }
+
+    internal bool TryWrite(Stream stream, out int bytesWritten)
+    {
+        Span<byte> buf = stackalloc byte[StructMaxSize];
+        if (!TryWriteCore(buf, out bytesWritten)) return false;
+        stream.Write(buf.Slice(0, bytesWritten));
+        return true;
+    }
+}
+
+[StructLayout(LayoutKind.Auto)]
+partial struct ResponseWindow
+{
+    internal const int StructMaxSize = 1;
+
+    internal byte Size;
+
+    internal int SizeOfStruct
+    {
+        get
+        {
+            int size = 0;
+            size += 1;
+            return size;
+        }
+    }
+
+    internal static bool TryReadCore(ReadOnlySpan<byte> span, out ResponseWindow result, out int bytesRead)
+    {
+        result = default;
+        int offset = 0;
+        if (span.Length - offset < 1) { bytesRead = 0; return false; }
+        result.Size = span[offset];
+        offset += 1;
+        bytesRead = offset;
+        return true;
+    }
+
+    internal bool TryWriteCore(Span<byte> span, out int bytesWritten)
+    {
+        int offset = 0;
+        if (span.Length - offset < 1) { bytesWritten = 0; return false; }
+        span[offset] = Size; offset += 1;
+        bytesWritten = offset;
+        return true;
+    }
+
+    internal static bool TryRead(ReadOnlySpan<byte> span, out ResponseWindow result, out int bytesRead)
+        => TryReadCore(span, out result, out bytesRead);
+
+    internal bool TryWrite(Span<byte> destination, out int bytesWritten)
+        => TryWriteCore(destination, out bytesWritten);
+
+    internal static bool TryRead(Stream stream, out ResponseWindow result, out int bytesRead)
+    {
+        Span<byte> buf = stackalloc byte[StructMaxSize];
+        int n = stream.Read(buf);
+        if (n < StructMaxSize) { result = default; bytesRead = n; return false; }
+        return TryReadCore(buf, out result, out bytesRead);
+    }
+
+    internal bool TryWrite(Stream stream, out int bytesWritten)
+    {
+        Span<byte> buf = stackalloc byte[StructMaxSize];
+        if (!TryWriteCore(buf, out bytesWritten)) return false;
+        stream.Write(buf.Slice(0, bytesWritten));
+        return true;
+    }
+}
+
 [StructLayout(LayoutKind.Auto)]
 partial struct RequestData
 {
@@ -1002,10 +1225,77 @@ partial struct RequestSetMode
     }
 }
 
+[StructLayout(LayoutKind.Auto)]
+partial struct RequestSubscribe
+{
+    internal const int StructMaxSize = 3;
+
+    internal sbyte ScreenIndex;
+    internal ushort IntervalMS;
+
+    internal int SizeOfStruct
+    {
+        get
+        {
+            int size = 0;
+            size += 1;
+            size += 2;
+            return size;
+        }
+    }
+
+    internal static bool TryReadCore(ReadOnlySpan<byte> span, out RequestSubscribe result, out int bytesRead)
+    {
+        result = default;
+        int offset = 0;
+        if (span.Length - offset < 1) { bytesRead = 0; return false; }
+        result.ScreenIndex = (sbyte)span[offset];
+        offset += 1;
+        if (span.Length - offset < 2) { bytesRead = 0; return false; }
+        result.IntervalMS = BinaryPrimitives.ReadUInt16LittleEndian(span.Slice(offset));
+        offset += 2;
+        bytesRead = offset;
+        return true;
+    }
+
+    internal bool TryWriteCore(Span<byte> span, out int bytesWritten)
+    {
+        int offset = 0;
+        if (span.Length - offset < 1) { bytesWritten = 0; return false; }
+        span[offset] = (byte)ScreenIndex; offset += 1;
+        if (span.Length - offset < 2) { bytesWritten = 0; return false; }
+        BinaryPrimitives.WriteUInt16LittleEndian(span.Slice(offset), IntervalMS); offset += 2;
+        bytesWritten = offset;
+        return true;
+    }
+
+    internal static bool TryRead(ReadOnlySpan<byte> span, out RequestSubscribe result, out int bytesRead)
+        => TryReadCore(span, out result, out bytesRead);
+
+    internal bool TryWrite(Span<byte> destination, out int bytesWritten)
+        => TryWriteCore(destination, out bytesWritten);
+
+    internal static bool TryRead(Stream stream, out RequestSubscribe result, out int bytesRead)
+    {
+        Span<byte> buf = stackalloc byte[StructMaxSize];
+        int n = stream.Read(buf);
+        if (n < StructMaxSize) { result = default; bytesRead = n; return false; }
+        return TryReadCore(buf, out result, out bytesRead);
+    }
+
+    internal bool TryWrite(Stream stream, out int bytesWritten)
+    {
+        Span<byte> buf = stackalloc byte[StructMaxSize];
+        if (!TryWriteCore(buf, out bytesWritten)) return false;
+        stream.Write(buf.Slice(0, bytesWritten));
+        return true;
+    }
+}
+
 [StructLayout(LayoutKind.Auto)]
 partial struct RequestIdent
 {
-    internal const int StructMaxSize = 164;
+    internal const int StructMaxSize = 170;
 
     internal ushort VersionMajor;
     internal ushort VersionMinor;
@@ -1041,6 +1331,10 @@ partial struct RequestIdent
     internal float Dpi;
     internal float PixelSize;
     internal InputType InputType;
+    internal uint MaxBaud;
+    internal byte MaxWindow;
+    private byte _data_delta;
+    internal bool DataDelta { get => _data_delta != 0; set => _data_delta = value ? (byte)1 : (byte)0; }
 
     internal int SizeOfStruct
     {
@@ -1060,6 +1354,9 @@ partial struct RequestIdent
             size += 4;
             size += 4;
             size += 1;
+            size += 4;
+            size += 1;
+            size += 1;
             return size;
         }
     }
@@ -1118,6 +1415,15 @@ partial struct RequestIdent
         if (span.Length - offset < 1) { bytesRead = 0; return false; }
         result.InputType = (InputType)(span[offset]);
         offset += 1;
+        if (span.Length - offset < 4) { bytesRead = 0; return false; }
+        result.MaxBaud = BinaryPrimitives.ReadUInt32LittleEndian(span.Slice(offset));
+        offset += 4;
+        if (span.Length - offset < 1) { bytesRead = 0; return false; }
+        result.MaxWindow = span[offset];
+        offset += 1;
+        if (span.Length - offset < 1) { bytesRead = 0; return false; }
+        result._data_delta = (byte)(span[offset]);
+        offset += 1;
         bytesRead = offset;
         return true;
     }
@@ -1162,6 +1468,12 @@ partial struct RequestIdent
         BinaryPrimitives.WriteSingleLittleEndian(span.Slice(offset), PixelSize); offset += 4;
         if (span.Length - offset < 1) { bytesWritten = 0; return false; }
         span[offset] = (byte)InputType; offset += 1;
+        if (span.Length - offset < 4) { bytesWritten = 0; return false; }
+        BinaryPrimitives.WriteUInt32LittleEndian(span.Slice(offset), MaxBaud); offset += 4;
+        if (span.Length - offset < 1) { bytesWritten = 0; return false; }
+        span[offset] = MaxWindow; offset += 1;
+        if (span.Length - offset < 1) { bytesWritten = 0; return false; }
+        span[offset] = _data_delta; offset += 1;
         bytesWritten = offset;
         return true;
     }
@@ -1189,4 +1501,220 @@ partial struct RequestIdent
     }
 }
 
+[StructLayout(LayoutKind.Auto)]
+partial struct RequestStatsPort
+{
+    internal const int StructMaxSize = 8;
+
+    internal uint Retransmits;
+    internal uint Nacks;
+
+    internal int SizeOfStruct
+    {
+        get
+        {
+            int size = 0;
+            size += 4;
+            size += 4;
+            return size;
+        }
+    }
+
+    internal static bool TryReadCore(ReadOnlySpan<byte> span, out RequestStatsPort result, out int bytesRead)
+    {
+        result = default;
+        int offset = 0;
+        if (span.Length - offset < 4) { bytesRead = 0; return false; }
+        result.Retransmits = BinaryPrimitives.ReadUInt32LittleEndian(span.Slice(offset));
+        offset += 4;
+        if (span.Length - offset < 4) { bytesRead = 0; return false; }
+        result.Nacks = BinaryPrimitives.ReadUInt32LittleEndian(span.Slice(offset));
+        offset += 4;
+        bytesRead = offset;
+        return true;
+    }
+
+    internal bool TryWriteCore(Span<byte> span, out int bytesWritten)
+    {
+        int offset = 0;
+        if (span.Length - offset < 4) { bytesWritten = 0; return false; }
+        BinaryPrimitives.WriteUInt32LittleEndian(span.Slice(offset), Retransmits); offset += 4;
+        if (span.Length - offset < 4) { bytesWritten = 0; return false; }
+        BinaryPrimitives.WriteUInt32LittleEndian(span.Slice(offset), Nacks); offset += 4;
+        bytesWritten = offset;
+        return true;
+    }
+
+    internal static bool TryRead(ReadOnlySpan<byte> span, out RequestStatsPort result, out int bytesRead)
+        => TryReadCore(span, out result, out bytesRead);
+
+    internal bool TryWrite(Span<byte> destination, out int bytesWritten)
+        => TryWriteCore(destination, out bytesWritten);
+
+    internal static bool TryRead(Stream stream, out RequestStatsPort result, out int bytesRead)
+    {
+        Span<byte> buf = stackalloc byte[StructMaxSize];
+        int n = stream.Read(buf);
+        if (n < StructMaxSize) { result = default; bytesRead = n; return false; }
+        return TryReadCore(buf, out result, out bytesRead);
+    }
+
+    internal bool TryWrite(Stream stream, out int bytesWritten)
+    {
+        Span<byte> buf = stackalloc byte[StructMaxSize];
+        if (!TryWriteCore(buf, out bytesWritten)) return false;
+        stream.Write(buf.Slice(0, bytesWritten));
+        return true;
+    }
+}
+
+[StructLayout(LayoutKind.Auto)]
+partial struct RequestStats
+{
+    internal const int StructMaxSize = 64;
+
+    internal uint IntervalMS;
+    internal uint Frames;
+    internal uint RenderMinUS;
+    internal uint RenderAvgUS;
+    internal uint RenderP99US;
+    internal uint FlushBytes;
+    internal uint FlushStalls;
+    internal RequestStatsPort Port1;
+    internal RequestStatsPort Port2;
+    internal uint RXOverflows;
+    internal uint FreeHeap;
+    internal uint LargestFreeBlock;
+    internal uint FreePsram;
+    internal uint LargestFreePsram;
+
+    internal int SizeOfStruct
+    {
+        get
+        {
+            int size = 0;
+            size += 4;
+            size += 4;
+            size += 4;
+            size += 4;
+            size += 4;
+            size += 4;
+            size += 4;
+            size += Port1.SizeOfStruct;
+            size += Port2.SizeOfStruct;
+            size += 4;
+            size += 4;
+            size += 4;
+            size += 4;
+            size += 4;
+            return size;
+        }
+    }
+
+    internal static bool TryReadCore(ReadOnlySpan<byte> span, out RequestStats result, out int bytesRead)
+    {
+        result = default;
+        int offset = 0;
+        if (span.Length - offset < 4) { bytesRead = 0; return false; }
+        result.IntervalMS = BinaryPrimitives.ReadUInt32LittleEndian(span.Slice(offset));
+        offset += 4;
+        if (span.Length - offset < 4) { bytesRead = 0; return false; }
+        result.Frames = BinaryPrimitives.ReadUInt32LittleEndian(span.Slice(offset));
+        offset += 4;
+        if (span.Length - offset < 4) { bytesRead = 0; return false; }
+        result.RenderMinUS = BinaryPrimitives.ReadUInt32LittleEndian(span.Slice(offset));
+        offset += 4;
+        if (span.Length - offset < 4) { bytesRead = 0; return false; }
+        result.RenderAvgUS = BinaryPrimitives.ReadUInt32LittleEndian(span.Slice(offset));
+        offset += 4;
+        if (span.Length - offset < 4) { bytesRead = 0; return false; }
+        result.RenderP99US = BinaryPrimitives.ReadUInt32LittleEndian(span.Slice(offset));
+        offset += 4;
+        if (span.Length - offset < 4) { bytesRead = 0; return false; }
+        result.FlushBytes = BinaryPrimitives.ReadUInt32LittleEndian(span.Slice(offset));
+        offset += 4;
+        if (span.Length - offset < 4) { bytesRead = 0; return false; }
+        result.FlushStalls = BinaryPrimitives.ReadUInt32LittleEndian(span.Slice(offset));
+        offset += 4;
+        if (!RequestStatsPort.TryReadCore(span.Slice(offset), out result.Port1, out int _n_port1)) { bytesRead = 0; return false; }
+        offset += _n_port1;
+        if (!RequestStatsPort.TryReadCore(span.Slice(offset), out result.Port2, out int _n_port2)) { bytesRead = 0; return false; }
+        offset += _n_port2;
+        if (span.Length - offset < 4) { bytesRead = 0; return false; }
+        result.RXOverflows = BinaryPrimitives.ReadUInt32LittleEndian(span.Slice(offset));
+        offset += 4;
+        if (span.Length - offset < 4) { bytesRead = 0; return false; }
+        result.FreeHeap = BinaryPrimitives.ReadUInt32LittleEndian(span.Slice(offset));
+        offset += 4;
+        if (span.Length - offset < 4) { bytesRead = 0; return false; }
+        result.LargestFreeBlock = BinaryPrimitives.ReadUInt32LittleEndian(span.Slice(offset));
+        offset += 4;
+        if (span.Length - offset < 4) { bytesRead = 0; return false; }
+        result.FreePsram = BinaryPrimitives.ReadUInt32LittleEndian(span.Slice(offset));
+        offset += 4;
+        if (span.Length - offset < 4) { bytesRead = 0; return false; }
+        result.LargestFreePsram = BinaryPrimitives.ReadUInt32LittleEndian(span.Slice(offset));
+        offset += 4;
+        bytesRead = offset;
+        return true;
+    }
+
+    internal bool TryWriteCore(Span<byte> span, out int bytesWritten)
+    {
+        int offset = 0;
+        if (span.Length - offset < 4) { bytesWritten = 0; return false; }
+        BinaryPrimitives.WriteUInt32LittleEndian(span.Slice(offset), IntervalMS); offset += 4;
+        if (span.Length - offset < 4) { bytesWritten = 0; return false; }
+        BinaryPrimitives.WriteUInt32LittleEndian(span.Slice(offset), Frames); offset += 4;
+        if (span.Length - offset < 4) { bytesWritten = 0; return false; }
+        BinaryPrimitives.WriteUInt32LittleEndian(span.Slice(offset), RenderMinUS); offset += 4;
+        if (span.Length - offset < 4) { bytesWritten = 0; return false; }
+        BinaryPrimitives.WriteUInt32LittleEndian(span.Slice(offset), RenderAvgUS); offset += 4;
+        if (span.Length - offset < 4) { bytesWritten = 0; return false; }
+        BinaryPrimitives.WriteUInt32LittleEndian(span.Slice(offset), RenderP99US); offset += 4;
+        if (span.Length - offset < 4) { bytesWritten = 0; return false; }
+        BinaryPrimitives.WriteUInt32LittleEndian(span.Slice(offset), FlushBytes); offset += 4;
+        if (span.Length - offset < 4) { bytesWritten = 0; return false; }
+        BinaryPrimitives.WriteUInt32LittleEndian(span.Slice(offset), FlushStalls); offset += 4;
+        if (!Port1.TryWriteCore(span.Slice(offset), out int _n_port1)) { bytesWritten = 0; return false; }
+        offset += _n_port1;
+        if (!Port2.TryWriteCore(span.Slice(offset), out int _n_port2)) { bytesWritten = 0; return false; }
+        offset += _n_port2;
+        if (span.Length - offset < 4) { bytesWritten = 0; return false; }
+        BinaryPrimitives.WriteUInt32LittleEndian(span.Slice(offset), RXOverflows); offset += 4;
+        if (span.Length - offset < 4) { bytesWritten = 0; return false; }
+        BinaryPrimitives.WriteUInt32LittleEndian(span.Slice(offset), FreeHeap); offset += 4;
+        if (span.Length - offset < 4) { bytesWritten = 0; return false; }
+        BinaryPrimitives.WriteUInt32LittleEndian(span.Slice(offset), LargestFreeBlock); offset += 4;
+        if (span.Length - offset < 4) { bytesWritten = 0; return false; }
+        BinaryPrimitives.WriteUInt32LittleEndian(span.Slice(offset), FreePsram); offset += 4;
+        if (span.Length - offset < 4) { bytesWritten = 0; return false; }
+        BinaryPrimitives.WriteUInt32LittleEndian(span.Slice(offset), LargestFreePsram); offset += 4;
+        bytesWritten = offset;
+        return true;
+    }
+
+    internal static bool TryRead(ReadOnlySpan<byte> span, out RequestStats result, out int bytesRead)
+        => TryReadCore(span, out result, out bytesRead);
+
+    internal bool TryWrite(Span<byte> destination, out int bytesWritten)
+        => TryWriteCore(destination, out bytesWritten);
+
+    internal static bool TryRead(Stream stream, out RequestStats result, out int bytesRead)
+    {
+        Span<byte> buf = stackalloc byte[StructMaxSize];
+        int n = stream.Read(buf);
+        if (n < StructMaxSize) { result = default; bytesRead = n; return false; }
+        return TryReadCore(buf, out result, out bytesRead);
+    }
+
+    internal bool TryWrite(Stream stream, out int bytesWritten)
+    {
+        Span<byte> buf = stackalloc byte[StructMaxSize];
+        if (!TryWriteCore(buf, out bytesWritten)) return false;
+        stream.Write(buf.Slice(0, bytesWritten));
+        return true;
+    }
+}
+
 #nullable restore
\ No newline at end of file
@@ -1,3 +1,4 @@
+using Microsoft.UI.Dispatching;
 using Microsoft.UI.Xaml;
 using Microsoft.UI.Xaml.Controls;
 using Microsoft.UI.Xaml.Input;
@@ -51,13 +52,22 @@ public enum ScreenViewScalingMode
 public partial class ScreenView : Canvas
 {
     private WriteableBitmap? _bitmap;
+    // what libespmon renders into. Pinned, so it's handed over once per bitmap
+    // and only the rows a frame changes are copied out to the bitmap
+    private byte[]? _pixels;
     private Image? _image;
     private IntPtr _handle;
     private Size _lastSize;
     private bool _screenInitialized = false;
     private bool _requiresClear = false;
     private Abi.ResponseScreen _responseScreen = default;
-    private Abi.ResponseData _responseData = default;
+    // data frames that arrived since the last repaint, which go to libespmon
+    // in one UpdateBatch() call. All but the last only go into the history
+    private readonly Abi.ResponseData[] _pendingData = new Abi.ResponseData[16];
+    private readonly Abi.Packet[] _pendingPackets = new Abi.Packet[16];
+    private int _pendingCount = 0;
+    private bool _refreshQueued = false;
+    private readonly Abi.Rect[] _dirties = new Abi.Rect[8];
     private double _lastRasterizationScale = 1.0;
     ScreenDataEventArgs? _lastDataArgs = null;
     public ScreenView()
@@ -140,11 +150,40 @@ public partial class ScreenView : Canvas
     private void Session_ScreenData(object sender, ScreenDataEventArgs args)
     {
         _lastDataArgs = args;
-        RefreshValues();
+        if (_pendingCount == _pendingData.Length)
+        {
+            RefreshValues();
+            if (_pendingCount == _pendingData.Length)
+            {
+                // nowhere to draw them yet, so keep the newest
+                Array.Copy(_pendingData, 1, _pendingData, 0, _pendingCount - 1);
+                --_pendingCount;
+            }
+        }
+        QueueResponseData(args);
+        // repaint once the frames already queued on the dispatcher are in
+        if (!_refreshQueued)
+        {
+            _refreshQueued = DispatcherQueue.TryEnqueue(DispatcherQueuePriority.Low, () =>
+            {
+                _refreshQueued = false;
+                // unless a resize has drawn them already
+                if (_pendingCount > 0)
+                {
+                    RefreshValues();
+                }
+            });
+            if (!_refreshQueued)
+            {
+                RefreshValues();
+            }
+        }
     }
 
     private void Session_ScreenChanged(object sender, ScreenChangedEventArgs args)
     {
+        // the data still queued was for the old screen
+        _pendingCount = 0;
         _screenInitialized = false;
         RefreshScreen();
     }
@@ -304,21 +343,21 @@ public partial class ScreenView : Canvas
         }
     }
 
-    private void BuildResponseData()
+    private void QueueResponseData(ScreenDataEventArgs args)
     {
-        if (_lastDataArgs == null) return;
+        ref Abi.ResponseData data = ref _pendingData[_pendingCount++];
 
-        _responseData.Top.Value1.Value = _lastDataArgs.TopValue1;
-        _responseData.Top.Value1.Scaled = _lastDataArgs.TopScaled1;
+        data.Top.Value1.Value = args.TopValue1;
+        data.Top.Value1.Scaled = args.TopScaled1;
 
-        _responseData.Top.Value2.Value = _lastDataArgs.TopValue2;
-        _responseData.Top.Value2.Scaled = _lastDataArgs.TopScaled2;
+        data.Top.Value2.Value = args.TopValue2;
+        data.Top.Value2.Scaled = args.TopScaled2;
 
-        _responseData.Bottom.Value1.Value = _lastDataArgs.BottomValue1;
-        _responseData.Bottom.Value1.Scaled = _lastDataArgs.BottomScaled1;
+        data.Bottom.Value1.Value = args.BottomValue1;
+        data.Bottom.Value1.Scaled = args.BottomScaled1;
 
-        _responseData.Bottom.Value2.Value = _lastDataArgs.BottomValue2;
-        _responseData.Bottom.Value2.Scaled = _lastDataArgs.BottomScaled2;
+        data.Bottom.Value2.Value = args.BottomValue2;
+        data.Bottom.Value2.Scaled = args.BottomScaled2;
 
     }
     private void ClearScreen()
@@ -330,37 +369,20 @@ public partial class ScreenView : Canvas
     private void RefreshScreen()
     {
         if (_screenInitialized) return;
-        if (_handle == IntPtr.Zero || !EnsureBitmap() || _bitmap == null)
+        if (_handle == IntPtr.Zero || !EnsureBitmap() || _bitmap == null || _pixels == null)
             return;
         Abi.ClearData(_handle);
         BuildResponseScreen();
 
-        uint bufferBytes = (uint)(_bitmap.PixelWidth * _bitmap.PixelHeight * 4);
+        // Update renders into _pixels
+        uint dirtyCount = 0;
+        Abi.Update(_handle, 1, ref _responseScreen, IntPtr.Zero, ref dirtyCount);
 
+        // A new screen repaints everything, so the whole buffer goes to the bitmap
         using (var stream = _bitmap.PixelBuffer.AsStream())
         {
-            unsafe
-            {
-                byte[] buffer = new byte[bufferBytes];
-
-                // Read current bitmap data
-                stream.Seek(0, System.IO.SeekOrigin.Begin);
-                stream.ReadExactly(buffer, 0, (int)bufferBytes);
-
-                fixed (byte* pBuffer = buffer)
-                {
-                    // Set the buffer pointer - Update will render directly into it
-                    Abi.SetTransfer(_handle, (IntPtr)pBuffer, bufferBytes);
-
-                    // Update renders into the buffer
-                    uint dirtyCount = 0;
-                    Abi.Update(_handle, 1, ref _responseScreen, IntPtr.Zero, ref dirtyCount);
-                }
-
-                // Write modified buffer back to bitmap
-                stream.Seek(0, System.IO.SeekOrigin.Begin);
-                stream.Write(buffer, 0, (int)bufferBytes);
-            }
+            stream.Seek(0, System.IO.SeekOrigin.Begin);
+            stream.Write(_pixels, 0, _pixels.Length);
         }
 
         _bitmap.Invalidate();
@@ -377,44 +399,59 @@ public partial class ScreenView : Canvas
             RefreshScreen();
         }
         if (!_screenInitialized) return;
-        BuildResponseData();
-        if (_handle == IntPtr.Zero || _bitmap == null)
+        if (_pendingCount == 0)
+        {
+            // a repaint without new data, after the bitmap was replaced
+            if (_lastDataArgs == null) return;
+            QueueResponseData(_lastDataArgs);
+        }
+        if (_handle == IntPtr.Zero || _bitmap == null || _pixels == null)
         {
             return;
         }
 
-        uint bufferBytes = (uint)(_bitmap.PixelWidth * _bitmap.PixelHeight * 4);
+        if (_requiresClear)
+        {
+            _requiresClear = false;
+            Abi.ClearData(_handle);
+        }
+        // UpdateBatch renders the queued data into _pixels and reports what it changed
+        uint dirtyCount = (uint)_dirties.Length;
+        unsafe
+        {
+            fixed (Abi.ResponseData* pData = _pendingData)
+            fixed (Abi.Rect* pDirties = _dirties)
+            {
+                for (int i = 0; i < _pendingCount; ++i)
+                {
+                    _pendingPackets[i].Cmd = 2;
+                    _pendingPackets[i].Response = (IntPtr)(pData + i);
+                }
+                Abi.UpdateBatch(_handle, _pendingPackets, (uint)_pendingCount, (IntPtr)pDirties, ref dirtyCount);
+            }
+        }
+        _pendingCount = 0;
 
+        // Write only the changed rows of each dirty rect back to the bitmap
         using (var stream = _bitmap.PixelBuffer.AsStream())
         {
-            unsafe
+            int stride = _bitmap.PixelWidth * 4;
+            for (int i = 0; i < dirtyCount; ++i)
             {
-                byte[] buffer = new byte[bufferBytes];
-
-                // Read current bitmap data
-                stream.Seek(0, System.IO.SeekOrigin.Begin);
-                stream.ReadExactly(buffer, 0, (int)bufferBytes);
-                fixed (byte* pBuffer = buffer)
+                var r = _dirties[i];
+                for (int y = r.Y; y < r.Y + r.Height; ++y)
                 {
-                    // Set the buffer pointer - Update will render directly into it
-                    Abi.SetTransfer(_handle, (IntPtr)pBuffer, bufferBytes);
-                    if (_requiresClear && _handle != IntPtr.Zero)
-                    {
-                        _requiresClear = false;
-                        Abi.ClearData(_handle);
-                    }
-                    // Update renders into the buffer
-                    uint dirtyCount = 0;
-                    Abi.Update(_handle, 2, ref _responseData, IntPtr.Zero, ref dirtyCount);
+                    int offset = y * stride + r.X * 4;
+                    stream.Seek(offset, System.IO.SeekOrigin.Begin);
+                    stream.Write(_pixels, offset, r.Width * 4);
                 }
-
-                // Write modified buffer back to bitmap
-                stream.Seek(0, System.IO.SeekOrigin.Begin);
-                stream.Write(buffer, 0, (int)bufferBytes);
             }
         }
 
-        _bitmap.Invalidate();
+        if (dirtyCount > 0)
+        {
+            _bitmap.Invalidate();
+        }
     }
 
     private void Control_SizeChanged(object sender, SizeChangedEventArgs e)
@@ -543,6 +580,9 @@ public partial class ScreenView : Canvas
         if (_handle != IntPtr.Zero)
         {
             Abi.SetDimensions(_handle, (ushort)width, (ushort)height);
+            // the renderer keeps drawing into this until the bitmap is replaced
+            _pixels = GC.AllocateArray<byte>(width * height * 4, pinned: true);
+            Abi.SetTransfer(_handle, Marshal.UnsafeAddrOfPinnedArrayElement(_pixels, 0), (uint)_pixels.Length);
         }
 
         _screenInitialized = false;
@@ -614,18 +654,34 @@ public partial class ScreenView : Canvas
             public ResponseScreenEntry Bottom;
         }
 
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Rect
+        {
+            public int X;
+            public int Y;
+            public int Width;
+            public int Height;
+        }
+
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Packet
+        {
+            public byte Cmd;
+            public IntPtr Response;
+        }
+
         [DllImport("libespmon.dll", CallingConvention = CallingConvention.Cdecl)]
         public static extern IntPtr Create();
 
         [DllImport("libespmon.dll", CallingConvention = CallingConvention.Cdecl)]
         public static extern void Destroy(IntPtr handle);
 
-        [DllImport("libespmon.dll", EntryPoint = "Update", CallingConvention = CallingConvention.Cdecl)]
-        public static extern void Update(IntPtr handle, byte cmd, [In] ref ResponseData response, [In] IntPtr in_dirties_buffer, [In, Out] ref uint in_out_dirties_count);
-
         [DllImport("libespmon.dll", EntryPoint = "Update", CallingConvention = CallingConvention.Cdecl)]
         public static extern void Update(IntPtr handle, byte cmd, [In] ref ResponseScreen response, [In] IntPtr in_dirties_buffer, [In, Out] ref uint in_out_dirties_count);
 
+        [DllImport("libespmon.dll", CallingConvention = CallingConvention.Cdecl)]
+        public static extern void UpdateBatch(IntPtr handle, [In] Packet[] packets, uint packets_count, [In] IntPtr in_dirties_buffer, [In, Out] ref uint in_out_dirties_count);
+
         [DllImport("libespmon.dll", CallingConvention = CallingConvention.Cdecl)]
         public static extern void SetTransfer(IntPtr handle, IntPtr buffer, uint bufferBytes);
 
@@ -11,10 +11,11 @@ Options:
                     strings are length-prefixed on the wire.
   --big-endian      Generate struct read/write methods using big-endian
                     serialization. Without this flag, little-endian is used.
-  --lengths         Treat any size_t field that immediately precedes a fixed
-                    array as the runtime element count for that array. The
-                    count is serialized first (as uint32_t on the wire), then
-                    only that many array elements follow. The count field is
+  --lengths         Treat any size_t, uint8_t, uint16_t or uint32_t field that
+                    immediately precedes a fixed array as the runtime element
+                    count for that array. The count is serialized first, as
+                    its own type (size_t as uint32_t), then only that many
+                    array elements follow. The count field is
                     HIDDEN from the C# API: on write the count is taken from
                     the array property's .Length / .Count; on read it is
                     consumed but discarded (the array's length carries it).
@@ -386,15 +387,26 @@ def parse_struct_body(body, struct_name, all_struct_names, known_enums):
     return fields
 
 
+# The types a --lengths count may have, and the most elements each can count
+LENGTH_COUNT_MAX = {
+    'size_t':   0xFFFFFFFF,
+    'uint8_t':  0xFF,
+    'uint16_t': 0xFFFF,
+    'uint32_t': 0xFFFFFFFF,
+}
+
+
 def apply_lengths_pairing_cs(structs: dict, struct_name: str) -> None:
     """When --lengths is in effect, pair each `size_t name; T arr[N];` pattern
-    so the count drives runtime element count for the array. The count field
+    (or uint8_t/uint16_t/uint32_t name) so the count drives runtime element
+    count for the array. The count field
     is hidden from the C# API (no property emitted). On read, the count is
     consumed from the wire but discarded; the resulting array's length is
     the count. On write, the count is taken from the array's .Length.
 
     Strings (char[]/wchar_t[]) keep their existing length-prefix behavior.
-    The size_t must immediately precede the array.
+    The count must immediately precede the array, and goes on the wire as
+    its own type.
     """
     fields = structs[struct_name]['fields']
     for i in range(len(fields) - 1):
@@ -404,14 +416,17 @@ def apply_lengths_pairing_cs(structs: dict, struct_name: str) -> None:
             continue
         if cur['is_enum']:
             continue
-        if cur['type'] != 'size_t':
+        if cur['type'] not in LENGTH_COUNT_MAX:
             continue
         if nxt['array_len'] is None:
             continue
         # Strings keep their existing length-prefix behavior.
         if nxt['type'] in ('char', 'wchar_t'):
             continue
+        if nxt['array_len'] > LENGTH_COUNT_MAX[cur['type']]:
+            error(f"Struct '{struct_name}', field '{cur['c_name']}': {cur['type']} can't count {nxt['array_len']} elements")
         nxt['length_field'] = cur['c_name']
+        nxt['length_wire_type'] = cur['wire_type']
         cur['is_length_for'] = nxt['c_name']
 
 
@@ -939,10 +954,11 @@ def gen_span_read_core(cs_name, fields, structs, big_endian,
 
         # ----- length-prefixed array -----
         if arr is not None and f.get('length_field') is not None:
-            read_count = bp_read('uint32_t', "span", "offset")
+            lc_wt = f['length_wire_type']; lc_sz = WIRE_TYPE_SIZES[lc_wt]
+            read_count = bp_read(lc_wt, "span", "offset")
             lines.append(f"{indent}{{")
-            lines.append(f"{inner}if (span.Length - offset < 4) {{ bytesRead = 0; return false; }}")
-            lines.append(f"{inner}int _c = (int)({read_count}); offset += 4;")
+            lines.append(f"{inner}if (span.Length - offset < {lc_sz}) {{ bytesRead = 0; return false; }}")
+            lines.append(f"{inner}int _c = (int)({read_count}); offset += {lc_sz};")
             lines.append(f"{inner}if ((uint)_c > {arr}) {{ bytesRead = 0; return false; }}")
             if is_struct_array(f, all_struct_names):
                 nested = to_dotnet_name(wt)
@@ -1086,11 +1102,13 @@ def gen_span_write_core(cs_name, fields, structs, big_endian,
 
         # ----- length-prefixed array -----
         if arr is not None and f.get('length_field') is not None:
+            lc_wt = f['length_wire_type']; lc_sz = WIRE_TYPE_SIZES[lc_wt]
+            lc_val = f"({cs_wire_type(lc_wt)})_c"
             lines.append(f"{indent}{{")
             lines.append(f"{inner}int _c = {stg}Count;")
             lines.append(f"{inner}if ((uint)_c > {arr}) {{ bytesWritten = 0; return false; }}")
-            lines.append(f"{inner}if (span.Length - offset < 4) {{ bytesWritten = 0; return false; }}")
-            lines.append(f"{inner}{bp_write('uint32_t','span','offset','(uint)_c')} offset += 4;")
+            lines.append(f"{inner}if (span.Length - offset < {lc_sz}) {{ bytesWritten = 0; return false; }}")
+            lines.append(f"{inner}{bp_write(lc_wt,'span','offset',lc_val)} offset += {lc_sz};")
             if is_struct_array(f, all_struct_names):
                 nested = to_dotnet_name(wt)
                 lines.append(f"{inner}for (int i = 0; i < _c; i++)")
@@ -1202,10 +1220,11 @@ def gen_size_of_struct_body(fields, structs, prefix="            "):
         stg = f"_{f['c_name']}"
 
         if arr is not None and f.get('length_field') is not None:
+            lc_sz = WIRE_TYPE_SIZES[f['length_wire_type']]
             if is_struct_array(f, all_struct_names):
-                lines.append(f"{prefix}{{ int _c = {stg}Count; size += 4; for (int i = 0; i < _c; i++) size += {stg}[i].SizeOfStruct; }}")
+                lines.append(f"{prefix}{{ int _c = {stg}Count; size += {lc_sz}; for (int i = 0; i < _c; i++) size += {stg}[i].SizeOfStruct; }}")
             else:
-                lines.append(f"{prefix}size += 4 + {stg}Count * {sz};")
+                lines.append(f"{prefix}size += {lc_sz} + {stg}Count * {sz};")
             continue
         if arr is not None and is_char_array(f):
             lp_sz = length_prefix_size(arr)
@@ -3,8 +3,11 @@
 #include <math.h>
 #include <memory.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
+#include <atomic>
+
 #include <gfx.hpp>
 #include <monoxbold.hpp>
 #include <uix.hpp>
@@ -24,6 +27,35 @@ enum struct espmon_hit {
     graph
 };
 
+// What a control drew in on_paint() against what of it went out in a
+// flush. on_paint() runs once per strip or dirty rect the control touches,
+// and anything drawn outside the clip is thrown away, so painted over
+// flushed is the overdraw.
+struct paint_stats {
+    size_t painted;
+    size_t flushed;
+};
+
+// fills rect cropped to the clip, and counts what it fills
+template <typename Destination, typename PixelType>
+void paint_fill(Destination& destination, const gfx::srect16& rect, PixelType color, const gfx::srect16& clip, paint_stats& stats) {
+    if (!rect.intersects(clip)) return;
+    const gfx::srect16 r = rect.crop(clip);
+    gfx::draw::filled_rectangle(destination, r, color);
+    stats.painted += r.area();
+}
+// copies source_rect to dest_rect, the same size and both normalized,
+// cropped to the clip
+template <typename Destination, typename Source>
+void paint_bitmap(Destination& destination, const gfx::srect16& dest_rect, Source& source, const gfx::rect16& source_rect, const gfx::srect16& clip, paint_stats& stats) {
+    if (!dest_rect.intersects(clip)) return;
+    const gfx::srect16 r = dest_rect.crop(clip);
+    const int sx = source_rect.x1 + r.x1 - dest_rect.x1;
+    const int sy = source_rect.y1 + r.y1 - dest_rect.y1;
+    gfx::draw::bitmap(destination, r, source, gfx::rect16(sx, sy, sx + r.width() - 1, sy + r.height() - 1));
+    stats.painted += r.area();
+}
+
 template <typename ControlSurfaceType>
 class vvert_label : public uix::canvas_control<ControlSurfaceType> {
     using base_type = uix::canvas_control<ControlSurfaceType>;
@@ -39,6 +71,7 @@ class vvert_label : public uix::canvas_control<ControlSurfaceType> {
     bool m_label_text_dirty;
     gfx::vector_pixel m_color;
     uix::uix_pixel m_background_color;
+    paint_stats m_stats;
     void build_label_path_untransformed() {
         const float target_width = this->dimensions().height * .7f;
         float fsize = this->dimensions().width;
@@ -58,7 +91,7 @@ class vvert_label : public uix::canvas_control<ControlSurfaceType> {
     }
 
    public:
-    vvert_label() : base_type(), m_label_text_dirty(true) {
+    vvert_label() : base_type(), m_label_text_dirty(true), m_stats({0, 0}) {
         m_label_text.ttf_font = &monoxbold;
         m_label_text.text_sz("Label");
         m_label_text.encoding = &gfx::text_encoding::utf8;
@@ -81,6 +114,14 @@ class vvert_label : public uix::canvas_control<ControlSurfaceType> {
         m_label_text_dirty = true;
         this->invalidate();
     }
+    gfx::stream& font() const {
+        return *m_label_text.ttf_font;
+    }
+    void font(gfx::stream& value) {
+        m_label_text.ttf_font = &value;
+        m_label_text_dirty = true;
+        this->invalidate();
+    }
     uix::uix_pixel color() const {
         uix::uix_pixel result;
         convert(m_color, &result);
@@ -97,6 +138,12 @@ class vvert_label : public uix::canvas_control<ControlSurfaceType> {
         m_background_color = value;
         this->invalidate();
     }
+    const paint_stats& stats() const {
+        return m_stats;
+    }
+    void reset_stats() {
+        m_stats = {0, 0};
+    }
 
    protected:
     virtual void on_before_paint() override {
@@ -106,9 +153,12 @@ class vvert_label : public uix::canvas_control<ControlSurfaceType> {
         }
     }
     virtual void on_paint(control_surface_type& destination, const gfx::srect16& clip) {
+        m_stats.flushed += clip.area();
         if (m_background_color.opacity() != 0) {
-            gfx::draw::filled_rectangle(destination, destination.bounds(), m_background_color);
+            paint_fill(destination, (gfx::srect16)destination.bounds(), m_background_color, clip, m_stats);
         }
+        // the canvas is bound to the whole control, so the text isn't clipped
+        m_stats.painted += destination.bounds().area();
         base_type::on_paint(destination, clip);
     }
     virtual void on_paint(gfx::canvas& destination, const gfx::srect16& clip) override {
@@ -131,24 +181,604 @@ class vvert_label : public uix::canvas_control<ControlSurfaceType> {
     }
 };
 
+// Prerendered alpha masks of the characters the value labels show: digits,
+// '.', '-' and whatever suffix characters are in use. Masks are kept for a
+// few font sizes at a time, so a label blits them rather than shaping and
+// rasterizing the TrueType outlines on every update. Assumes a monospaced
+// font, like monoxbold.
+class glyph_atlas {
+   public:
+    static constexpr const size_t max_chars = 24;
+    static constexpr const size_t max_faces = 4;
+    // the masks for one font size
+    struct face {
+        int font_size;  // 0 if unused
+        // bumped whenever the slot is rebuilt, so users can tell it changed
+        uint32_t serial;
+        uint32_t last_used;
+        uint16_t cell_width;
+        uint16_t cell_height;
+        // the x of the glyph origin within a cell
+        int origin_x;
+        float advance;
+        // ink extents of each glyph relative to its origin
+        float ink_x1[max_chars];
+        float ink_x2[max_chars];
+        // cell_width * cell_height bytes per character, 0-255 coverage
+        uint8_t* masks;
+        const uint8_t* mask(size_t index) const {
+            return masks + index * cell_width * cell_height;
+        }
+    };
+
+   private:
+    static constexpr const char* base_chars = "0123456789.-";
+    gfx::stream* m_font;
+    char m_chars[max_chars + 1];
+    size_t m_char_count;
+    // '0' metrics at size 100 (font_size_ref), used to fit text sizes
+    static constexpr const float font_size_ref = 100.f;
+    float m_ref_ink;
+    float m_ref_advance;
+    bool m_ref_valid;
+    face m_faces[max_faces];
+    uint32_t m_tick;
+    uint32_t m_serial;
+    bool shape(const char* text, float font_size, gfx::canvas_path& path, gfx::rectf* out_bounds) const {
+        gfx::canvas_text_info ti;
+        ti.ttf_font = m_font;
+        ti.ttf_font_face = 0;
+        ti.encoding = &gfx::text_encoding::utf8;
+        ti.text_sz(text);
+        ti.font_size = font_size;
+        if (!path.initialized() && gfx::gfx_result::success != path.initialize()) {
+            return false;
+        }
+        path.clear();
+        if (gfx::gfx_result::success != path.text({0.f, 0.f}, ti)) {
+            return false;
+        }
+        *out_bounds = path.bounds(false);
+        return true;
+    }
+    bool ensure_ref() {
+        if (m_ref_valid) return true;
+        if (m_font == nullptr) return false;
+        gfx::canvas_path path;
+        gfx::rectf one, two;
+        if (!shape("0", font_size_ref, path, &one) || !shape("00", font_size_ref, path, &two)) {
+            return false;
+        }
+        m_ref_ink = one.width();
+        m_ref_advance = two.width() - one.width();
+        m_ref_valid = true;
+        return true;
+    }
+    void release(face& f) {
+        if (f.masks != nullptr) {
+            free(f.masks);
+            f.masks = nullptr;
+        }
+        f.font_size = 0;
+    }
+    bool build(face& f, int font_size) {
+        release(f);
+        gfx::canvas_path path;
+        gfx::rectf b;
+        float x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+        bool any = false;
+        for (size_t i = 0; i < m_char_count; ++i) {
+            const char str[2] = {m_chars[i], 0};
+            if (!shape(str, font_size, path, &b)) return false;
+            f.ink_x1[i] = b.x1;
+            f.ink_x2[i] = b.x2;
+            if (b.width() <= 0.f) continue;
+            if (!any || b.x1 < x1) x1 = b.x1;
+            if (!any || b.x2 > x2) x2 = b.x2;
+            if (!any || b.y1 < y1) y1 = b.y1;
+            if (!any || b.y2 > y2) y2 = b.y2;
+            any = true;
+        }
+        if (!any) return false;
+        f.origin_x = x1 < 0 ? (int)ceilf(-x1) : 0;
+        f.cell_width = (uint16_t)(ceilf(x2) + f.origin_x + 1);
+        const int top = (int)floorf(y1);
+        f.cell_height = (uint16_t)(ceilf(y2) - top + 1);
+        if (!shape("00", font_size, path, &b)) return false;
+        gfx::rectf b0;
+        if (!shape("0", font_size, path, &b0)) return false;
+        f.advance = b.x2 - b0.x2;
+        const size_t cell_size = (size_t)f.cell_width * f.cell_height;
+        f.masks = (uint8_t*)malloc(cell_size * m_char_count);
+        if (f.masks == nullptr) return false;
+        memset(f.masks, 0, cell_size * m_char_count);
+        using mask_t = gfx::bitmap<gfx::gsc_pixel<8>>;
+        gfx::canvas cv(gfx::size16(f.cell_width, f.cell_height));
+        for (size_t i = 0; i < m_char_count; ++i) {
+            const char str[2] = {m_chars[i], 0};
+            if (!shape(str, font_size, path, &b)) {
+                release(f);
+                return false;
+            }
+            mask_t mask(gfx::size16(f.cell_width, f.cell_height), f.masks + i * cell_size);
+            if (gfx::gfx_result::success != cv.initialize() ||
+                gfx::gfx_result::success != gfx::draw::canvas(mask, cv, gfx::point16::zero(), nullptr)) {
+                release(f);
+                return false;
+            }
+            // white over black: each pixel ends up holding the coverage
+            gfx::canvas_style si = cv.style();
+            si.fill_paint_type = gfx::paint_type::solid;
+            si.stroke_paint_type = gfx::paint_type::none;
+            si.fill_color = gfx::vector_pixel(255, 255, 255, 255);
+            cv.style(si);
+            cv.transform(gfx::matrix::create_translate(f.origin_x, -top));
+            cv.path(path);
+            cv.render();
+            cv.clear_path();
+            cv.deinitialize();
+        }
+        f.font_size = font_size;
+        f.serial = ++m_serial;
+        return true;
+    }
+
+   public:
+    glyph_atlas() : m_font(nullptr), m_char_count(0), m_ref_ink(0), m_ref_advance(0), m_ref_valid(false), m_tick(0), m_serial(0) {
+        for (size_t i = 0; i < max_faces; ++i) {
+            m_faces[i].font_size = 0;
+            m_faces[i].serial = 0;
+            m_faces[i].masks = nullptr;
+        }
+        extra_chars(nullptr);
+    }
+    glyph_atlas(const glyph_atlas& rhs) = delete;
+    glyph_atlas& operator=(const glyph_atlas& rhs) = delete;
+    ~glyph_atlas() {
+        clear();
+    }
+    gfx::stream* font() const {
+        return m_font;
+    }
+    void font(gfx::stream& value) {
+        if (m_font != &value) {
+            m_font = &value;
+            m_ref_valid = false;
+            clear();
+        }
+    }
+    // sets the characters held besides digits, '.' and '-'. Only printable
+    // ASCII is kept. Changing them drops the prerendered sizes.
+    void extra_chars(const char* value) {
+        char chars[max_chars + 1];
+        size_t count = strlen(base_chars);
+        memcpy(chars, base_chars, count);
+        while (value != nullptr && *value && count < max_chars) {
+            const char ch = *value++;
+            if (ch >= ' ' && ch <= '~' && nullptr == memchr(chars, ch, count)) {
+                chars[count++] = ch;
+            }
+        }
+        chars[count] = 0;
+        if (count != m_char_count || 0 != memcmp(chars, m_chars, count)) {
+            memcpy(m_chars, chars, count + 1);
+            m_char_count = count;
+            clear();
+        }
+    }
+    // drops all prerendered sizes
+    void clear() {
+        for (size_t i = 0; i < max_faces; ++i) {
+            release(m_faces[i]);
+        }
+    }
+    int index_of(char ch) const {
+        const char* p = (const char*)memchr(m_chars, ch, m_char_count);
+        return p == nullptr ? -1 : (int)(p - m_chars);
+    }
+    bool can_render(const char* text) const {
+        if (m_font == nullptr || text == nullptr || !*text) return false;
+        while (*text) {
+            if (0 > index_of(*text++)) return false;
+        }
+        return true;
+    }
+    // the font size vlabel's fit would arrive at for length characters in a
+    // width x height label, without shaping the text
+    int fit_size(size_t length, int width, int height) {
+        if (length == 0 || !ensure_ref()) return 0;
+        const float target_width = width * .8f;
+        const float ref_width = (length - 1) * m_ref_advance + m_ref_ink;
+        int fsize = height;
+        int result;
+        float w;
+        do {
+            result = fsize;
+            w = ref_width * result / font_size_ref;
+            --fsize;
+        } while (fsize > 0 && w >= target_width);
+        return result;
+    }
+    // returns the masks for a font size, rendering them into the least
+    // recently used slot if needed. nullptr if they couldn't be built
+    const face* acquire(int font_size) {
+        if (font_size <= 0) return nullptr;
+        face* lru = &m_faces[0];
+        for (size_t i = 0; i < max_faces; ++i) {
+            face& f = m_faces[i];
+            if (f.font_size == font_size) {
+                f.last_used = ++m_tick;
+                return &f;
+            }
+            if (f.font_size == 0 || (lru->font_size != 0 && f.last_used < lru->last_used)) {
+                lru = &f;
+            }
+        }
+        if (!build(*lru, font_size)) {
+            release(*lru);
+            return nullptr;
+        }
+        lru->last_used = ++m_tick;
+        return lru;
+    }
+};
+
+// A value label that blits its text from a glyph_atlas when every character
+// is in it, and falls back to the vector label otherwise. Only center_right
+// justification, which the value labels use, takes the fast path.
 template <typename ControlSurfaceType>
+class value_label : public uix::vlabel<ControlSurfaceType> {
+    using base_type = uix::vlabel<ControlSurfaceType>;
+
+   public:
+    using type = value_label;
+    using control_surface_type = ControlSurfaceType;
+
+   private:
+    using pixel_type = typename control_surface_type::pixel_type;
+    using row_bitmap_t = gfx::bitmap<pixel_type, typename control_surface_type::palette_type>;
+    static constexpr const size_t max_length = 16;
+    glyph_atlas* m_atlas;
+    const char* m_text_sz;
+    uix::uix_pixel m_blend_color;
+    // fast path layout, from on_before_paint
+    bool m_fast;
+    int m_font_size;
+    uint32_t m_serial;
+    const glyph_atlas::face* m_face;
+    size_t m_length;
+    uint8_t m_glyphs[max_length];
+    int16_t m_cell_x[max_length];
+    int m_text_x1, m_text_x2, m_text_y;
+    // color for each coverage value, for the current foreground/background
+    pixel_type m_lut[256];
+    gfx::rgba_pixel<32> m_lut_fg, m_lut_bg;
+    bool m_lut_valid;
+    // one row of coverage, and the same row in native pixels
+    uint8_t* m_row;
+    size_t m_row_width;
+    paint_stats m_stats;
+    void release_row() {
+        if (m_row != nullptr) {
+            free(m_row);
+            m_row = nullptr;
+        }
+        m_row_width = 0;
+    }
+    bool ensure_row(size_t width) {
+        if (m_row != nullptr && m_row_width >= width) return true;
+        release_row();
+        m_row = (uint8_t*)malloc(width + row_bitmap_t::sizeof_buffer(gfx::size16(width, 1)));
+        if (m_row == nullptr) return false;
+        m_row_width = width;
+        return true;
+    }
+    bool layout() {
+        m_face = nullptr;
+        if (m_atlas == nullptr || m_text_sz == nullptr || this->text_justify() != uix::uix_justify::center_right) return false;
+        if (this->border_width() != 0.f || this->font_size() > 0.f) return false;
+        m_length = strlen(m_text_sz);
+        if (m_length == 0 || m_length > max_length || !m_atlas->can_render(m_text_sz)) return false;
+        const int w = this->dimensions().width, h = this->dimensions().height;
+        m_font_size = m_atlas->fit_size(m_length, w, h);
+        m_face = m_atlas->acquire(m_font_size);
+        if (m_face == nullptr) return false;
+        m_serial = m_face->serial;
+        for (size_t i = 0; i < m_length; ++i) {
+            m_glyphs[i] = (uint8_t)m_atlas->index_of(m_text_sz[i]);
+        }
+        // same placement as vlabel: the ink is right aligned leaving a fifth
+        // of its width, and vertically centered
+        const float ink_x1 = m_face->ink_x1[m_glyphs[0]];
+        const float ink_x2 = (m_length - 1) * m_face->advance + m_face->ink_x2[m_glyphs[m_length - 1]];
+        const int text_width = (int)(ink_x2 - ink_x1);
+        const float x = w - text_width * 1.2f;
+        m_text_x1 = w;
+        m_text_x2 = -1;
+        for (size_t i = 0; i < m_length; ++i) {
+            m_cell_x[i] = (int16_t)lroundf(x + i * m_face->advance) - m_face->origin_x;
+            if (m_cell_x[i] < m_text_x1) m_text_x1 = m_cell_x[i];
+            if (m_cell_x[i] + m_face->cell_width - 1 > m_text_x2) m_text_x2 = m_cell_x[i] + m_face->cell_width - 1;
+        }
+        m_text_x1 = gfx::math::clamp(0, m_text_x1, w - 1);
+        m_text_x2 = gfx::math::clamp(0, m_text_x2, w - 1);
+        m_text_y = (h - m_face->cell_height) / 2;
+        return m_text_x2 >= m_text_x1 && ensure_row(m_text_x2 - m_text_x1 + 1);
+    }
+    void update_lut(gfx::rgba_pixel<32> fg, gfx::rgba_pixel<32> bg) {
+        if (m_lut_valid && fg == m_lut_fg && bg == m_lut_bg) return;
+        for (int a = 0; a < 256; ++a) {
+            gfx::convert(fg.blend(bg, a / 255.f), &m_lut[a]);
+        }
+        m_lut_fg = fg;
+        m_lut_bg = bg;
+        m_lut_valid = true;
+    }
+
+   public:
+    value_label() : base_type(), m_atlas(nullptr), m_text_sz(nullptr), m_blend_color(gfx::color<uix::uix_pixel>::black), m_fast(false), m_face(nullptr), m_lut_valid(false), m_row(nullptr), m_row_width(0), m_stats({0, 0}) {
+    }
+    value_label(const value_label& rhs) = delete;
+    value_label& operator=(const value_label& rhs) = delete;
+    virtual ~value_label() {
+        release_row();
+    }
+    glyph_atlas* atlas() const {
+        return m_atlas;
+    }
+    void atlas(glyph_atlas* value) {
+        m_atlas = value;
+        this->invalidate();
+    }
+    // what the glyphs are blended over when there's no background color.
+    // Should match whatever is behind the label.
+    uix::uix_pixel blend_color() const {
+        return m_blend_color;
+    }
+    void blend_color(uix::uix_pixel value) {
+        m_blend_color = value;
+        this->invalidate();
+    }
+    using base_type::text;
+    void text(gfx::text_handle text, size_t text_byte_count) {
+        // not necessarily terminated, so it always takes the vector path
+        m_text_sz = nullptr;
+        base_type::text(text, text_byte_count);
+    }
+    void text(const char* sz) {
+        m_text_sz = sz;
+        base_type::text(sz);
+    }
+    const paint_stats& stats() const {
+        return m_stats;
+    }
+    void reset_stats() {
+        m_stats = {0, 0};
+    }
+
+   protected:
+    virtual void on_after_resize() override {
+        base_type::on_after_resize();
+        release_row();
+    }
+    virtual void on_before_paint() override {
+        m_fast = layout();
+        if (!m_fast) {
+            base_type::on_before_paint();
+        }
+    }
+    virtual void on_paint(control_surface_type& destination, const gfx::srect16& clip) override {
+        m_stats.flushed += clip.area();
+        if (m_fast && (m_face->font_size != m_font_size || m_face->serial != m_serial)) {
+            // another label pushed our size out of the atlas
+            m_fast = layout();
+            if (!m_fast) {
+                base_type::on_before_paint();
+            }
+        }
+        if (!m_fast) {
+            // vlabel draws the whole control whatever the clip
+            m_stats.painted += destination.bounds().area();
+            base_type::on_paint(destination, clip);
+            return;
+        }
+        gfx::rgba_pixel<32> bg = m_blend_color;
+        if (this->background_color().opacity() != 0) {
+            bg = this->background_color();
+            paint_fill(destination, (gfx::srect16)destination.bounds(), bg, clip, m_stats);
+        }
+        update_lut(this->color(), bg);
+        const glyph_atlas::face& f = *m_face;
+        const int row_width = m_text_x2 - m_text_x1 + 1;
+        uint8_t* coverage = m_row;
+        row_bitmap_t row(gfx::size16(row_width, 1), m_row + m_row_width, this->palette());
+        // only the rows and columns of the text inside the clip
+        const int y1 = gfx::math::max_(m_text_y, (int)clip.y1);
+        const int y2 = gfx::math::min_(m_text_y + f.cell_height - 1, (int)clip.y2);
+        const int x1 = gfx::math::max_(0, clip.x1 - m_text_x1);
+        const int x2 = gfx::math::min_(row_width - 1, clip.x2 - m_text_x1);
+        if (x2 < x1) return;
+        for (int y = y1; y <= y2; ++y) {
+            const int cy = y - m_text_y;
+            memset(coverage, 0, row_width);
+            for (size_t i = 0; i < m_length; ++i) {
+                const int cell_x = m_cell_x[i] - m_text_x1;
+                if (cell_x > x2 || cell_x + f.cell_width - 1 < x1) continue;
+                const uint8_t* src = f.mask(m_glyphs[i]) + cy * f.cell_width;
+                for (int cx = 0; cx < f.cell_width; ++cx) {
+                    const int x = m_cell_x[i] + cx - m_text_x1;
+                    // neighboring cells can overlap by a pixel
+                    if (x >= 0 && x < row_width && src[cx] > coverage[x]) {
+                        coverage[x] = src[cx];
+                    }
+                }
+            }
+            for (int x = x1; x <= x2; ++x) {
+                row.point(gfx::point16(x, 0), m_lut[coverage[x]]);
+            }
+            gfx::draw::bitmap(destination, gfx::srect16(m_text_x1 + x1, y, m_text_x1 + x2, y), row, gfx::rect16(x1, 0, x2, 0));
+            m_stats.painted += x2 - x1 + 1;
+        }
+    }
+};
+
+// Collects polyline vertices into a caller supplied buffer. Exact
+// duplicates are dropped, and the interior of a horizontal run is extended
+// rather than adding a vertex. Vertices past the capacity are dropped.
+class polyline_builder {
+    gfx::spoint16* m_points;
+    size_t m_capacity;
+    size_t m_size;
+
+   public:
+    polyline_builder(gfx::spoint16* points, size_t capacity) : m_points(points), m_capacity(capacity), m_size(0) {
+    }
+    void add(int x, int y) {
+        const gfx::spoint16 p(x, y);
+        if (m_size > 0 && p.x == m_points[m_size - 1].x && p.y == m_points[m_size - 1].y) return;
+        if (m_size >= 2 && m_points[m_size - 1].y == p.y && m_points[m_size - 2].y == p.y) {
+            m_points[m_size - 1] = p;
+            return;
+        }
+        if (m_size >= m_capacity) return;
+        m_points[m_size++] = p;
+    }
+    size_t size() const {
+        return m_size;
+    }
+    void clear() {
+        m_size = 0;
+    }
+    gfx::spath16 path() const {
+        return gfx::spath16(m_size, m_points);
+    }
+};
+
+// Builds polylines out of only the segments that come within margin of
+// the clip. Each run of them goes to draw(path) as its own polyline, so a
+// segment that can't reach the clip isn't stroked. A cap or join more than
+// margin outside the clip can't reach it either, so what lands inside the
+// clip is the same as stroking the whole line.
+class clipped_polyline {
+    polyline_builder m_points;
+    gfx::srect16 m_clip;
+    int m_margin;
+    paint_stats& m_stats;
+    bool m_started;
+    gfx::spoint16 m_last;
+
+   public:
+    clipped_polyline(gfx::spoint16* points, size_t capacity, const gfx::srect16& clip, int margin, paint_stats& stats) : m_points(points, capacity), m_clip(clip), m_margin(margin), m_stats(stats), m_started(false) {
+    }
+    template <typename Draw>
+    void add(int x, int y, Draw draw) {
+        const gfx::spoint16 p(x, y);
+        if (m_started) {
+            const gfx::srect16 seg = gfx::srect16(m_last, p).normalize().inflate(m_margin, m_margin);
+            if (seg.intersects(m_clip)) {
+                if (m_points.size() == 0) {
+                    m_points.add(m_last.x, m_last.y);
+                }
+                m_points.add(x, y);
+                // what the stroke can cover, as far as the clip goes
+                m_stats.painted += seg.crop(m_clip).area();
+            } else {
+                finish(draw);
+            }
+        }
+        m_started = true;
+        m_last = p;
+    }
+    template <typename Draw>
+    void finish(Draw draw) {
+        if (m_points.size() >= 2) {
+            draw(m_points.path());
+        }
+        m_points.clear();
+    }
+};
+
+// Walks samples first..last of a history buffer and passes sink(x, value)
+// at most two samples per column: the lowest and the highest, in the order
+// they occurred. Peaks survive however deep the history is, and the vertex
+// count is bounded by the plotted width rather than the depth. x_of(j)
+// maps sample j to its column, and must not decrease as j increases.
+template <typename BufferType, typename XMap, typename Sink>
+void decimate_history(const BufferType& buffer, size_t first, size_t last, XMap x_of, Sink sink) {
+    if (last < first || last >= buffer.size()) return;
+    int col = x_of(first);
+    size_t lo = first, hi = first;
+    uint8_t lo_v = *buffer.peek(first), hi_v = lo_v;
+    for (size_t j = first + 1; j <= last + 1; ++j) {
+        int x = 0;
+        uint8_t v = 0;
+        if (j <= last) {
+            x = x_of(j);
+            v = *buffer.peek(j);
+            if (x == col) {
+                if (v < lo_v) {
+                    lo = j;
+                    lo_v = v;
+                } else if (v > hi_v) {
+                    hi = j;
+                    hi_v = v;
+                }
+                continue;
+            }
+        }
+        if (lo == hi) {
+            sink(col, lo_v);
+        } else if (lo < hi) {
+            sink(col, lo_v);
+            sink(col, hi_v);
+        } else {
+            sink(col, hi_v);
+            sink(col, lo_v);
+        }
+        col = x;
+        lo = hi = j;
+        lo_v = hi_v = v;
+    }
+}
+
+template <typename ControlSurfaceType, size_t HistorySize = 100>
 class graph : public uix::control<ControlSurfaceType> {
     using base_type = uix::control<ControlSurfaceType>;
+    static_assert(HistorySize > 1, "HistorySize must be at least 2");
 
    public:
     using type = graph;
     using control_surface_type = ControlSurfaceType;
-    using buffer_type = data::circular_buffer<uint8_t, 100>;
+    using buffer_type = data::circular_buffer<uint8_t, HistorySize>;
 
    private:
+    using pixel_type = typename control_surface_type::pixel_type;
+    using plot_bitmap_t = gfx::bitmap<pixel_type, typename control_surface_type::palette_type>;
     struct data_line {
         uix::uix_pixel color;
         buffer_type* buffer;
         data_line* next;
+        // samples added, and the buffer size, as of the last plot update
+        size_t added;
+        size_t plotted;
     };
     gfx::mask_draw_cache* m_draw_cache;
     gfx::spoint16* m_point_buffer;
+    size_t m_point_buffer_size;
     data_line* m_first;
+    uix::uix_pixel m_background_color;
+    // scrolling mode keeps the area inside the border in an offscreen plot
+    // that gets shifted left as samples arrive, so only the newest segments
+    // and the uncovered columns are drawn
+    bool m_is_scrolling;
+    uint8_t* m_plot;
+    gfx::size16 m_plot_size;
+    bool m_plot_valid;
+    // set when the plot couldn't be allocated, so it isn't retried every frame
+    bool m_plot_failed;
+    // samples scrolled so far, modulo the vertical grid spacing
+    int m_plot_phase;
+    paint_stats m_stats;
     void clear_lines() {
         data_line* entry = m_first;
         while (entry != nullptr) {
@@ -158,17 +788,53 @@ class graph : public uix::control<ControlSurfaceType> {
         }
         m_first = nullptr;
     }
+    void release_plot() {
+        if (m_plot != nullptr) {
+            free(m_plot);
+            m_plot = nullptr;
+        }
+        m_plot_valid = false;
+    }
 
    public:
-    graph() : base_type(), m_draw_cache(nullptr), m_point_buffer(nullptr), m_first(nullptr) {
+    graph() : base_type(), m_draw_cache(nullptr), m_point_buffer(nullptr), m_point_buffer_size(0), m_first(nullptr), m_background_color(gfx::color<uix::uix_pixel>::black), m_is_scrolling(false), m_plot(nullptr), m_plot_valid(false), m_plot_failed(false), m_plot_phase(0), m_stats({0, 0}) {
     }
+    graph(const graph& rhs) = delete;
+    graph& operator=(const graph& rhs) = delete;
     virtual ~graph() {
         clear_lines();
+        release_plot();
     }
     void remove_lines() {
         clear_lines();
+        m_plot_valid = false;
         this->invalidate();
     }
+    // the color behind the plot in scrolling mode. Should match the screen.
+    uix::uix_pixel background_color() const {
+        return m_background_color;
+    }
+    void background_color(uix::uix_pixel value) {
+        if (m_background_color != value) {
+            m_background_color = value;
+            m_plot_valid = false;
+            this->invalidate();
+        }
+    }
+    bool is_scrolling() const {
+        return m_is_scrolling;
+    }
+    // scrolling mode needs a native bitmap the size of the graph, so it's
+    // meant for devices with the RAM to spare
+    void is_scrolling(bool value) {
+        if (m_is_scrolling != value) {
+            m_is_scrolling = value;
+            m_plot_failed = false;
+            m_plot_phase = 0;
+            release_plot();
+            this->invalidate();
+        }
+    }
     bool has_lines() const {
         return m_first != nullptr;
     }
@@ -182,7 +848,10 @@ class graph : public uix::control<ControlSurfaceType> {
             n->color = color;
             n->buffer = buffer;
             n->next = nullptr;
+            n->added = 0;
+            n->plotted = 0;
             m_first = n;
+            m_plot_valid = false;
             return 1;
         }
         size_t result = 0;
@@ -197,12 +866,15 @@ class graph : public uix::control<ControlSurfaceType> {
                 n->color = color;
                 n->buffer = buffer;
                 n->next = nullptr;
+                n->added = 0;
+                n->plotted = 0;
                 entry->next = n;
                 break;
             }
             entry = n;
             ++result;
         }
+        m_plot_valid = false;
         this->invalidate();
         return result + 1;
     }
@@ -230,8 +902,11 @@ class graph : public uix::control<ControlSurfaceType> {
                 return false;
             }
         }
-        entry->color = color;
-        this->invalidate();
+        if (entry->color != color) {
+            entry->color = color;
+            m_plot_valid = false;
+            this->invalidate();
+        }
         return true;
     }
     bool add_data(size_t line_index, float value) {
@@ -244,6 +919,7 @@ class graph : public uix::control<ControlSurfaceType> {
                     entry->buffer->get(&tmp);
                 }
                 entry->buffer->put(v);
+                ++entry->added;
                 this->invalidate();
                 return true;
             }
@@ -254,7 +930,11 @@ class graph : public uix::control<ControlSurfaceType> {
     void clear_data() {
         for (data_line* entry = m_first; entry != nullptr; entry = entry->next) {
             entry->buffer->clear();
+            entry->added = 0;
+            entry->plotted = 0;
         }
+        m_plot_phase = 0;
+        m_plot_valid = false;
         this->invalidate();
     }
     const buffer_type* buffer(size_t index) const {
@@ -276,8 +956,22 @@ class graph : public uix::control<ControlSurfaceType> {
     gfx::spoint16* point_buffer() {
         return m_point_buffer;
     }
-    void point_buffer(gfx::spoint16* value) {
+    size_t point_buffer_size() const {
+        return m_point_buffer_size;
+    }
+    // the polylines are decimated to at most two vertices per column, so
+    // size this to twice the width rather than to the history depth
+    void point_buffer(gfx::spoint16* value, size_t size) {
         m_point_buffer = value;
+        m_point_buffer_size = value != nullptr ? size : 0;
+    }
+    // what's drawn to the display. Drawing into the scrolling plot isn't
+    // counted, only blitting it
+    const paint_stats& stats() const {
+        return m_stats;
+    }
+    void reset_stats() {
+        m_stats = {0, 0};
     }
 
    private:  // draw helpers
@@ -290,11 +984,6 @@ class graph : public uix::control<ControlSurfaceType> {
         if (cap <= 1) return 0;
         return (j * (aw - 1)) / (cap - 1);
     }
-    // ceil of j*(aw-1)/(cap-1)
-    static int sample_x_ceil(int j, int aw, int cap) {
-        if (cap <= 1) return 0;
-        return (j * (aw - 1) + (cap - 2)) / (cap - 1);
-    }
     // floor of (255-v)*(ah-1)/255: y offset from ay1 (non-negative)
     static int value_y_floor(uint8_t v, int ah) {
         return ((255 - (int)v) * (ah - 1)) / 255;
@@ -307,14 +996,239 @@ class graph : public uix::control<ControlSurfaceType> {
     static int value_y_round(uint8_t v, int ah) {
         return ((255 - (int)v) * (ah - 1) + 127) / 255;
     }
+    // scrolling mode uses a whole pixel step per sample so the plot can be
+    // shifted without resampling. The newest sample of a full buffer lands on
+    // the right edge, and the remainder of the width is left of the oldest,
+    // so the history should be sized so that (capacity-1) divides (aw-1).
+    static int scroll_step(int aw) {
+        const int cap = (int)buffer_type::capacity;
+        if (cap <= 1) return aw;
+        return (aw - 1) / (cap - 1);
+    }
+    static int scroll_origin(int aw) {
+        return aw - 1 - ((int)buffer_type::capacity - 1) * scroll_step(aw);
+    }
+    // widest blank band scrolling tolerates before falling back to stretching
+    static constexpr const int scroll_max_origin = 2;
+    // the vertical grid is drawn every this many samples and scrolls with them
+    static int scroll_grid_every() {
+        const int every = (int)buffer_type::capacity / 10;
+        return every < 1 ? 1 : every;
+    }
+    // clears columns x1..x2 of the plot and redraws the horizontal grid over them
+    void clear_plot_columns(plot_bitmap_t& plot, int x1, int x2) {
+        if (x2 < x1) return;
+        const int ah = (int)plot.dimensions().height;
+        pixel_type bg;
+        gfx::convert(m_background_color, &bg);
+        plot.fill(gfx::rect16(x1, 0, x2, ah - 1), bg);
+        auto px = gfx::color<pixel_type>::gray;
+        for (int k = 0; k <= 10; ++k) {
+            int y = grid_offset(ah - 1, k);
+            gfx::draw::line(plot, gfx::srect16(x1, y, x2, y), px);
+        }
+    }
+    // draws the vertical grid lines that fall on samples j1..j2
+    void plot_vertical_grid(plot_bitmap_t& plot, int j1, int j2) {
+        const int aw = (int)plot.dimensions().width;
+        const int ah = (int)plot.dimensions().height;
+        const int every = scroll_grid_every();
+        auto px = gfx::color<pixel_type>::gray;
+        for (int j = j1; j <= j2; ++j) {
+            if (((j + m_plot_phase) % every) == 0) {
+                int x = scroll_origin(aw) + j * scroll_step(aw);
+                gfx::draw::line(plot, gfx::srect16(x, 0, x, ah - 1), px);
+            }
+        }
+    }
+    // draws samples j1..j2 of a line into the w x h area at (x0, y0), only
+    // as far as it reaches the clip. x_of maps a sample index to a column
+    // within the area
+    template <typename Destination, typename XMap>
+    void draw_samples(Destination& destination, data_line& line, size_t j1, size_t j2, int x0, int y0, int w, int h, XMap x_of, const gfx::srect16& clip, paint_stats& stats) {
+        if (m_point_buffer == nullptr) {
+            // blocky lines
+            if (j1 == j2) {
+                if (j1 == 0) {
+                    int xi = x0 + x_of(0);
+                    int yi = y0 + value_y_round(*line.buffer->peek(0), h);
+                    paint_fill(destination, gfx::srect16(xi, yi, xi, yi), line.color, clip, stats);
+                }
+                return;
+            }
+            const int x2 = x0 + w - 1, y2 = y0 + h - 1;
+            bool first = true;
+            int px = 0;
+            uint8_t pv = 0;
+            decimate_history(*line.buffer, j1, j2, x_of, [&](int x, uint8_t v) {
+                if (!first) {
+                    // Main rect: floor left corner, ceil right (point -> next), so a
+                    // small diagonal is still a whole rect.
+                    const int mx0 = x0 + px, my0 = y0 + value_y_floor(pv, h);
+                    const int mx1 = x0 + x, my1 = y0 + value_y_ceil(v, h);
+                    paint_fill(destination, gfx::srect16(mx0, my0, mx1, my1), line.color, clip, stats);
+                    // (1,1) offset copy so a flat run is 2px; clamped off the border.
+                    paint_fill(destination,
+                               gfx::srect16(gfx::math::min_(mx0 + 1, x2),
+                                            gfx::math::min_(my0 + 1, y2),
+                                            gfx::math::min_(mx1 + 1, x2),
+                                            gfx::math::min_(my1 + 1, y2)),
+                               line.color, clip, stats);
+                }
+                first = false;
+                px = x;
+                pv = v;
+            });
+            return;
+        }
+        // smooth lines
+        if (j2 <= j1) return;
+        const int thickness = this->dimensions().height / 30;
+        // Opaque, mixed with the background the way the translucent stroke
+        // was. The scrolling plot draws new segments over the end cap of the
+        // old ones, and a translucent stroke would blend that joint twice
+        const uix::uix_pixel color = line.color.blend(m_background_color, 192 / 255.f);
+        auto draw = [&](const gfx::spath16& path) {
+            gfx::draw::aa_polyline(destination, path, color,
+                                   thickness,
+                                   gfx::line_cap::round, gfx::line_join::round,
+                                   4, m_draw_cache);
+        };
+        // half the stroke, and a pixel each for rounding and antialiasing
+        clipped_polyline points(m_point_buffer, m_point_buffer_size, clip, thickness / 2 + 2, stats);
+        decimate_history(*line.buffer, j1, j2, x_of, [&](int x, uint8_t v) {
+            points.add(x0 + gfx::math::clamp(0, x, w - 1), y0 + value_y_round(v, h), draw);
+        });
+        points.finish(draw);
+    }
+    // draws the segments of a line between samples j1 and j2 into the plot
+    void plot_line(plot_bitmap_t& plot, data_line& line, size_t j1, size_t j2) {
+        const int aw = (int)plot.dimensions().width;
+        const int ah = (int)plot.dimensions().height;
+        const int step = scroll_step(aw);
+        const int origin = scroll_origin(aw);
+        // the plot is offscreen, so it isn't counted
+        paint_stats offscreen = {0, 0};
+        draw_samples(plot, line, j1, j2, 0, 0, aw, ah, [origin, step](size_t j) {
+            return origin + (int)j * step;
+        }, (gfx::srect16)plot.bounds(), offscreen);
+    }
+    void render_plot(plot_bitmap_t& plot) {
+        const int aw = (int)plot.dimensions().width;
+        clear_plot_columns(plot, 0, aw - 1);
+        plot_vertical_grid(plot, 0, (int)buffer_type::capacity - 1);
+        for (data_line* entry = m_first; entry != nullptr; entry = entry->next) {
+            const size_t n = entry->buffer->size();
+            if (n) {
+                plot_line(plot, *entry, 0, n - 1);
+            }
+        }
+    }
+    // moves the plot left by count samples and clears what that uncovers.
+    // returns false if it can't be shifted and needs a full render instead
+    bool shift_plot(plot_bitmap_t& plot, size_t count) {
+        if (pixel_type::bit_depth % 8) return false;
+        const int aw = (int)plot.dimensions().width;
+        const int cap = (int)buffer_type::capacity;
+        const int shift = (int)count * scroll_step(aw);
+        if ((int)count >= cap || shift >= aw) return false;
+        const size_t bytes = shift * (pixel_type::bit_depth / 8);
+        // shifting the whole buffer wraps the start of each row onto the end
+        // of the previous one, but those columns are cleared below anyway
+        memmove(m_plot, m_plot + bytes, plot_bitmap_t::sizeof_buffer(m_plot_size) - bytes);
+        m_plot_phase = (m_plot_phase + (int)count) % scroll_grid_every();
+        clear_plot_columns(plot, 0, scroll_origin(aw) - 1);
+        clear_plot_columns(plot, aw - shift, aw - 1);
+        plot_vertical_grid(plot, cap - (int)count, cap - 1);
+        return true;
+    }
+    // brings the plot up to date with the data added since the last update
+    void update_plot() {
+        const gfx::ssize16 d = this->dimensions();
+        if (d.width < 3 || d.height < 3 || scroll_step(d.width - 2) < 1 ||
+            scroll_origin(d.width - 2) > scroll_max_origin) {
+            // too narrow for a whole pixel per sample, or the whole steps
+            // would leave a blank band left of the oldest sample
+            release_plot();
+            return;
+        }
+        const gfx::size16 size(d.width - 2, d.height - 2);
+        if (m_plot == nullptr || m_plot_size != size) {
+            release_plot();
+            if (m_plot_failed) return;
+            m_plot = (uint8_t*)malloc(plot_bitmap_t::sizeof_buffer(size));
+            if (m_plot == nullptr) {
+                // paint directly instead
+                m_plot_failed = true;
+                return;
+            }
+            m_plot_size = size;
+        }
+        plot_bitmap_t plot(size, m_plot, this->palette());
+        // the incremental paths need every line to have moved in lockstep
+        const int cap = (int)buffer_type::capacity;
+        bool lockstep = true;
+        size_t added = 0, plotted = 0;
+        if (m_first != nullptr) {
+            added = m_first->added;
+            plotted = m_first->plotted;
+        }
+        for (data_line* entry = m_first; entry != nullptr; entry = entry->next) {
+            if (entry->added != added || entry->plotted != plotted) {
+                lockstep = false;
+            }
+        }
+        if (!m_plot_valid || !lockstep) {
+            render_plot(plot);
+        } else if (added > 0) {
+            if (plotted + added <= (size_t)cap) {
+                // still filling: the new segments go on the end
+                for (data_line* entry = m_first; entry != nullptr; entry = entry->next) {
+                    plot_line(plot, *entry, plotted ? plotted - 1 : 0, entry->buffer->size() - 1);
+                }
+            } else if (plotted == (size_t)cap && shift_plot(plot, added)) {
+                for (data_line* entry = m_first; entry != nullptr; entry = entry->next) {
+                    plot_line(plot, *entry, cap - 1 - added, cap - 1);
+                }
+            } else {
+                render_plot(plot);
+            }
+        }
+        for (data_line* entry = m_first; entry != nullptr; entry = entry->next) {
+            entry->added = 0;
+            entry->plotted = entry->buffer->size();
+        }
+        m_plot_valid = true;
+    }
 
    protected:
+    virtual void on_after_resize() override {
+        m_plot_failed = false;
+        release_plot();
+    }
+    virtual void on_before_paint() override {
+        // on_paint() may run once per strip, so the plot is brought up to
+        // date once per frame here
+        if (m_is_scrolling) {
+            update_plot();
+        }
+    }
     void on_paint(control_surface_type& destination, const gfx::srect16& clip) {
-        using pixel_type = typename control_surface_type::pixel_type;
+        m_stats.flushed += clip.area();
         gfx::srect16 b = (gfx::srect16)destination.bounds();
         auto px = gfx::color<pixel_type>::gray;
 
-        gfx::draw::rectangle(destination, b, px);
+        // the border, a side at a time so each is cropped to the clip
+        paint_fill(destination, gfx::srect16(b.x1, b.y1, b.x2, b.y1), px, clip, m_stats);
+        paint_fill(destination, gfx::srect16(b.x1, b.y2, b.x2, b.y2), px, clip, m_stats);
+        paint_fill(destination, gfx::srect16(b.x1, b.y1 + 1, b.x1, b.y2 - 1), px, clip, m_stats);
+        paint_fill(destination, gfx::srect16(b.x2, b.y1 + 1, b.x2, b.y2 - 1), px, clip, m_stats);
+
+        if (m_is_scrolling && m_plot != nullptr && m_plot_valid) {
+            plot_bitmap_t plot(m_plot_size, m_plot, this->palette());
+            paint_bitmap(destination, gfx::srect16(b.x1 + 1, b.y1 + 1, b.x2 - 1, b.y2 - 1), plot, plot.bounds(), clip, m_stats);
+            return;
+        }
 
         const gfx::srect16 area(b.x1 + 1, b.y1 + 1, b.x2 - 1, b.y2 - 1);
         const int ax1 = area.x1, ay1 = area.y1, ax2 = area.x2, ay2 = area.y2;
@@ -324,11 +1238,11 @@ class graph : public uix::control<ControlSurfaceType> {
 
         for (int k = 0; k <= 10; ++k) {
             int x = ax1 + grid_offset(aw - 1, k);
-            gfx::draw::line(destination, gfx::srect16(x, ay1, x, ay2), px);
+            paint_fill(destination, gfx::srect16(x, ay1, x, ay2), px, clip, m_stats);
         }
         for (int k = 0; k <= 10; ++k) {
             int y = ay1 + grid_offset(ah - 1, k);
-            gfx::draw::line(destination, gfx::srect16(ax1, y, ax2, y), px);
+            paint_fill(destination, gfx::srect16(ax1, y, ax2, y), px, clip, m_stats);
         }
 
         // Fixed step so a full buffer spans ax1..ax2 with the last sample on ax2.
@@ -337,92 +1251,17 @@ class graph : public uix::control<ControlSurfaceType> {
         for (data_line* entry = m_first; entry != nullptr; entry = entry->next) {
             const size_t n = entry->buffer->size();
             if (!n) continue;
-
             // peek(0) = oldest at ax1; index grows rightward. When size == capacity
             // the newest (peek(n-1)) lands on ax2. x offset for sample j is
             // j*(aw-1)/(cap-1); y offset for value v is (255-v)*(ah-1)/255.
-            // blocky lines
-            if (m_point_buffer == nullptr) {
-                if (n == 1) {
-                    int yi = ay1 + value_y_round(*entry->buffer->peek(0), ah);
-                    gfx::draw::filled_rectangle(destination,
-                                                gfx::srect16(ax1, yi, ax1, yi), entry->color);
-                    continue;
-                }
-
-                for (size_t j = 1; j < n; ++j) {
-                    uint8_t pv = *entry->buffer->peek(j - 1);
-                    uint8_t cv = *entry->buffer->peek(j);
-
-                    // Main rect: floor left corner, ceil right (point -> next), so a
-                    // small diagonal is still a whole rect. Clamp into the area.
-                    int mx0 = ax1 + sample_x_floor((int)(j - 1), aw, cap);
-                    if (mx0 < ax1) mx0 = ax1;
-                    int my0 = ay1 + value_y_floor(pv, ah);
-                    int mx1 = ax1 + sample_x_ceil((int)j, aw, cap);
-                    if (mx1 > ax2) mx1 = ax2;
-                    int my1 = ay1 + value_y_ceil(cv, ah);
-                    gfx::draw::filled_rectangle(destination,
-                                                gfx::srect16(mx0, my0, mx1, my1), entry->color);
-
-                    // (1,1) offset copy so a flat run is 2px; clamped off the border.
-                    int ox0 = mx0 + 1;
-                    if (ox0 > ax2) ox0 = ax2;
-                    int oy0 = my0 + 1;
-                    if (oy0 > ay2) oy0 = ay2;
-                    int ox1 = mx1 + 1;
-                    if (ox1 > ax2) ox1 = ax2;
-                    int oy1 = my1 + 1;
-                    if (oy1 > ay2) oy1 = ay2;
-                    gfx::draw::filled_rectangle(destination,
-                                                gfx::srect16(ox0, oy0, ox1, oy1), entry->color);
-                }
-            } else {
-                // smooth lines
-                if (n < 2) continue;
-
-                const int bx2 = (int)destination.bounds().x2;
-                const int by2 = (int)destination.bounds().y2;
-
-                uint8_t pv = *entry->buffer->peek(0);
-                int mx0 = ax1 + sample_x_floor(0, aw, cap);
-                if (mx0 < ax1) mx0 = ax1;
-                int my0 = ay1 + value_y_floor(pv, ah);
-                m_point_buffer[0] = gfx::spoint16(gfx::math::clamp(mx0, 0, bx2),
-                                                  gfx::math::clamp(my0, 0, by2));
-                size_t k = 1;  // number of points kept
-
-                for (size_t j = 1; j < n; ++j) {
-                    uint8_t cv = *entry->buffer->peek(j);
-                    int mx1 = ax1 + sample_x_ceil((int)j, aw, cap);
-                    if (mx1 > ax2) mx1 = ax2;
-                    int my1 = ay1 + value_y_ceil(cv, ah);
-                    const gfx::spoint16 p(gfx::math::clamp(mx1, 0, bx2),
-                                          gfx::math::clamp(my1, 0, by2));
-
-                    // exact duplicate (can happen when aw < cap): drop it
-                    if (p.x == m_point_buffer[k - 1].x && p.y == m_point_buffer[k - 1].y) continue;
-
-                    // interior of a horizontal run: extend the run rather than adding a vertex
-                    if (k >= 2 && m_point_buffer[k - 1].y == p.y && m_point_buffer[k - 2].y == p.y) {
-                        m_point_buffer[k - 1] = p;
-                    } else {
-                        m_point_buffer[k++] = p;
-                    }
-                }
-
-                if (k < 2) continue;
-                gfx::spath16 path(k, m_point_buffer);
-                gfx::draw::aa_polyline(destination, path, entry->color.opacity8(192),
-                                       this->dimensions().height / 30,
-                                       gfx::line_cap::round, gfx::line_join::round,
-                                       4, m_draw_cache);
-            }
+            draw_samples(destination, *entry, 0, n - 1, ax1, ay1, aw, ah, [aw, cap](size_t j) {
+                return sample_x_floor((int)j, aw, cap);
+            }, clip, m_stats);
         }
     }
 };
 
-template <typename ControlSurfaceType>
+template <typename ControlSurfaceType, size_t HistorySize = 100>
 class bar : public uix::control<ControlSurfaceType> {
     using base_type = uix::control<ControlSurfaceType>;
     using uix_color_t = gfx::color<uix::uix_pixel>;
@@ -430,19 +1269,27 @@ class bar : public uix::control<ControlSurfaceType> {
    public:
     using type = bar;
     using control_surface_type = ControlSurfaceType;
+    using buffer_type = data::circular_buffer<uint8_t, HistorySize>;
 
    private:
     uix::uix_pixel m_color;
     uix::uix_pixel m_back_color;
     bool m_is_gradient;
     float m_value;
-    const data::circular_buffer<uint8_t, 100>* m_buffer;
+    const buffer_type* m_buffer;
     bool m_dark_mode;
     gfx::mask_draw_cache* m_draw_cache;
     gfx::spoint16* m_point_buffer;
-    
+    size_t m_point_buffer_size;
+    // the gradient strip, prerendered in the native format. row 0 is the
+    // filled part, row 1 the dimmed tail already blended with the background
+    uint8_t* m_gradient;
+    int m_gradient_width;
+    typename control_surface_type::pixel_type m_gradient_bg;
+    paint_stats m_stats;
+
    public:
-    bar() : base_type(), m_is_gradient(false), m_value(0), m_buffer(nullptr), m_dark_mode(true), m_draw_cache(nullptr),m_point_buffer(nullptr) {
+    bar() : base_type(), m_is_gradient(false), m_value(0), m_buffer(nullptr), m_dark_mode(true), m_draw_cache(nullptr), m_point_buffer(nullptr), m_point_buffer_size(0), m_gradient(nullptr), m_gradient_width(0), m_stats({0, 0}) {
         static constexpr const gfx::rgb_pixel<24> px(0, 255, 0);
         static constexpr const gfx::rgb_pixel<24> black(0, 0, 0);
         convert(px, &m_color);
@@ -451,7 +1298,10 @@ class bar : public uix::control<ControlSurfaceType> {
         m_back_color = m_color.blend(px2, .125f);
     }
 
+    bar(const bar& rhs) = delete;
+    bar& operator=(const bar& rhs) = delete;
     virtual ~bar() {
+        release_gradient();
     }
     float value() const {
         return m_value;
@@ -459,9 +1309,24 @@ class bar : public uix::control<ControlSurfaceType> {
     void value(float value) {
         value = gfx::math::clamp(0.f, value, 1.f);
         if (value != m_value) {
+            // only the filled width shows, so the same width needs no repaint
+            const bool repaint = !is_same_extent(value);
             m_value = value;
-            this->invalidate();
+            if (repaint) {
+                this->invalidate();
+            }
+        }
+    }
+    // indicates whether value would paint the bar the same as the current one
+    bool is_same_extent(float value) const {
+        value = gfx::math::clamp(0.f, value, 1.f);
+        if ((value > 0.f) != (m_value > 0.f)) {
+            return false;
         }
+        // the two ways on_paint() rounds the filled width
+        const float w = this->dimensions().width;
+        return roundf(value * w - 1) == roundf(m_value * w - 1) &&
+               lroundf(value * w) == lroundf(m_value * w);
     }
 
     void clear() {
@@ -476,6 +1341,9 @@ class bar : public uix::control<ControlSurfaceType> {
     void is_gradient(bool value) {
         if (value != m_is_gradient) {
             m_is_gradient = value;
+            if (!value) {
+                release_gradient();
+            }
             this->invalidate();
         }
     }
@@ -488,10 +1356,10 @@ class bar : public uix::control<ControlSurfaceType> {
             this->invalidate();
         }
     }
-    const data::circular_buffer<uint8_t, 100>* graph_buffer() const {
+    const buffer_type* graph_buffer() const {
         return m_buffer;
     }
-    void graph_buffer(const data::circular_buffer<uint8_t, 100>* value) {
+    void graph_buffer(const buffer_type* value) {
         if (m_buffer != value) {
             m_buffer = value;
             this->invalidate();
@@ -524,11 +1392,114 @@ class bar : public uix::control<ControlSurfaceType> {
     gfx::spoint16* point_buffer() {
         return m_point_buffer;
     }
-    void point_buffer(gfx::spoint16* value) {
+    size_t point_buffer_size() const {
+        return m_point_buffer_size;
+    }
+    // at most two vertices per column are used, as with the graph
+    void point_buffer(gfx::spoint16* value, size_t size) {
         m_point_buffer = value;
+        m_point_buffer_size = value != nullptr ? size : 0;
+    }
+    const paint_stats& stats() const {
+        return m_stats;
+    }
+    void reset_stats() {
+        m_stats = {0, 0};
     }
 
    private:  // draw helpers
+    using gradient_bitmap_t = gfx::bitmap<typename control_surface_type::pixel_type, typename control_surface_type::palette_type>;
+    void release_gradient() {
+        if (m_gradient != nullptr) {
+            free(m_gradient);
+            m_gradient = nullptr;
+        }
+        m_gradient_width = 0;
+    }
+    // Renders the red to green gradient into the strip. Only needed when the
+    // width or the background changes.
+    bool build_gradient(int width, typename control_surface_type::pixel_type scr_bg) {
+        if (m_gradient == nullptr || m_gradient_width != width) {
+            release_gradient();
+            m_gradient = (uint8_t*)malloc(gradient_bitmap_t::sizeof_buffer(gfx::size16(width, 2)));
+            if (m_gradient == nullptr) {
+                return false;
+            }
+        } else if (m_gradient_bg == scr_bg) {
+            return true;
+        }
+        m_gradient_width = width;
+        m_gradient_bg = scr_bg;
+        gradient_bitmap_t strip(gfx::size16(width, 2), m_gradient, this->palette());
+        // two reference points for the ends of the graph
+        gfx::hsva_pixel<32> px = gfx::color<gfx::hsva_pixel<32>>::red;
+        gfx::hsva_pixel<32> px2 = gfx::color<gfx::hsva_pixel<32>>::green;
+        auto h1 = px.channel<gfx::channel_name::H>();
+        auto h2 = px2.channel<gfx::channel_name::H>();
+        h2 -= 24;
+        // the actual range we're drawing
+        auto range = abs(h2 - h1) + 1;
+        // the width of each gradient segment
+        int w = (int)ceilf(width / (float)range) + 1;
+        // the step of each segment - default 1
+        int s = 1;
+        // if the gradient is larger than the control
+        if (width < range) {
+            // change the segment to width 1
+            w = 1;
+            // and make its step larger
+            s = range / (float)width;
+        }
+        int x = 0;
+        // c is the current color offset
+        // it increases by s (step)
+        int c = 0;
+        // for each color in the range
+        for (auto j = 0; j < range && x < width; ++j) {
+            // adjust the H value (inverted and offset)
+            px.channel<gfx::channel_name::H>(range - c - 1 + h1);
+            typename control_surface_type::pixel_type filled;
+            gfx::convert(px, &filled);
+            // the part past the value is drawn at 95/255 opacity
+            typename control_surface_type::pixel_type dimmed = filled.blend(scr_bg, 95 / 255.f);
+            const int x2 = gfx::math::min_(x + w, width) - 1;
+            strip.fill(gfx::rect16(x, 0, x2, 0), filled);
+            strip.fill(gfx::rect16(x, 1, x2, 1), dimmed);
+            // increment
+            x += w;
+            c += s;
+        }
+        return true;
+    }
+    // Copies the gradient strip into the rows below the bar that are inside
+    // the clip. Columns up to and including split come from the filled row,
+    // the rest from the dimmed one.
+    void paint_gradient(control_surface_type& destination, int y1, int split, typename control_surface_type::pixel_type scr_bg, const gfx::srect16& clip) {
+        const int width = (int)destination.dimensions().width;
+        const int y2 = (int)destination.dimensions().height - 1;
+        if (y1 > y2 || width < 1) return;
+        if (!build_gradient(width, scr_bg)) {
+            // out of memory: flat colors rather than nothing
+            if (split >= 0) {
+                paint_fill(destination, gfx::srect16(0, y1, split, y2), m_color, clip, m_stats);
+            }
+            if (split < width - 1) {
+                paint_fill(destination, gfx::srect16(split + 1, y1, width - 1, y2), m_back_color, clip, m_stats);
+            }
+            return;
+        }
+        gradient_bitmap_t strip(gfx::size16(width, 2), m_gradient, this->palette());
+        const int ry1 = gfx::math::max_(y1, (int)clip.y1);
+        const int ry2 = gfx::math::min_(y2, (int)clip.y2);
+        for (int y = ry1; y <= ry2; ++y) {
+            if (split >= 0) {
+                paint_bitmap(destination, gfx::srect16(0, y, split, y), strip, gfx::rect16(0, 0, split, 0), clip, m_stats);
+            }
+            if (split < width - 1) {
+                paint_bitmap(destination, gfx::srect16(split + 1, y, width - 1, y), strip, gfx::rect16(split + 1, 1, width - 1, 1), clip, m_stats);
+            }
+        }
+    }
     // round-to-nearest of j*(w-1)/(cap-1) - the x for sample j
     static int spark_x(int j, int w, int cap) {
         if (cap <= 1 || w <= 1) return 0;
@@ -542,38 +1513,33 @@ class bar : public uix::control<ControlSurfaceType> {
     // horizontal window [x_from,x_to]. Where the window boundary cuts a
     // segment, an interpolated vertex is manufactured on the boundary so
     // that two adjacent windows share an identical endpoint and meet
-    // without a visible gap. Uses the same point reduction as the graph.
-    void render_spark(control_surface_type& destination, int x_from, int x_to, int y_end, uix::uix_pixel color, float thickness) {
+    // without a visible gap. The history is decimated like the graph's.
+    // Segments that can't reach the paint clip are left out.
+    void render_spark(control_surface_type& destination, int x_from, int x_to, int y_end, uix::uix_pixel color, float thickness, const gfx::srect16& clip) {
         if (m_buffer == nullptr || m_point_buffer == nullptr) return;
         if (x_to <= x_from) return;
-        using buffer_t = data::circular_buffer<uint8_t, 100>;
-        const int cap = (int)buffer_t::capacity;
+        const int cap = (int)buffer_type::capacity;
         const int w = (int)destination.dimensions().width;
         const int bx2 = (int)destination.bounds().x2;
         const int by2 = (int)destination.bounds().y2;
         const size_t n = m_buffer->size();
         if (n < 2) return;
-        // the shared point buffer is sized to the data capacity
-        const size_t max_points = (size_t)cap;
-        size_t k = 0;  // number of points kept
+        // butt caps so the two halves abut at the split instead of
+        // overshooting it and bleeding the wrong color past the bar edge
+        auto draw = [&](const gfx::spath16& path) {
+            gfx::draw::aa_polyline(destination, path, color, thickness,
+                                   gfx::line_cap::butt, gfx::line_join::round,
+                                   4, m_draw_cache);
+        };
+        clipped_polyline points(m_point_buffer, m_point_buffer_size, clip, (int)ceilf(thickness / 2) + 2, m_stats);
         auto emit = [&](int ex, int ey) {
-            const gfx::spoint16 p(gfx::math::clamp(ex, 0, bx2),
-                                  gfx::math::clamp(ey, 0, by2));
-            // exact duplicate (can happen when w < cap): drop it
-            if (k > 0 && p.x == m_point_buffer[k - 1].x && p.y == m_point_buffer[k - 1].y) return;
-            // interior of a horizontal run: extend the run rather than adding a vertex
-            if (k >= 2 && m_point_buffer[k - 1].y == p.y && m_point_buffer[k - 2].y == p.y) {
-                m_point_buffer[k - 1] = p;
-                return;
-            }
-            if (k >= max_points) return;
-            m_point_buffer[k++] = p;
+            points.add(gfx::math::clamp(ex, 0, bx2), gfx::math::clamp(ey, 0, by2), draw);
         };
+        bool first = true;
         int lx = 0, ly = 0;
-        for (size_t j = 0; j < n; ++j) {
-            const int x = spark_x((int)j, w, cap);
-            const int y = spark_y(*m_buffer->peek(j), y_end);
-            if (j > 0 && x > lx) {
+        decimate_history(*m_buffer, 0, n - 1, [w, cap](size_t j) { return spark_x((int)j, w, cap); }, [&](int x, uint8_t v) {
+            const int y = spark_y(v, y_end);
+            if (!first && x > lx) {
                 // segment enters the window: manufacture the left endpoint
                 if (lx < x_from && x >= x_from) {
                     emit(x_from, ly + ((y - ly) * (x_from - lx)) / (x - lx));
@@ -586,124 +1552,57 @@ class bar : public uix::control<ControlSurfaceType> {
             if (x >= x_from && x <= x_to) {
                 emit(x, y);
             }
+            first = false;
             lx = x;
             ly = y;
-        }
-        if (k < 2) return;
-        gfx::spath16 path(k, m_point_buffer);
-        // butt caps so the two halves abut at the split instead of
-        // overshooting it and bleeding the wrong color past the bar edge
-        gfx::draw::aa_polyline(destination, path, color, thickness,
-                               gfx::line_cap::butt, gfx::line_join::round,
-                               4, m_draw_cache);
+        });
+        points.finish(draw);
     }
 
    protected:
     virtual void on_paint(control_surface_type& destination, const gfx::srect16& clip) {
+        m_stats.flushed += clip.area();
+        // the screen background. The clip has been filled with it and nothing
+        // else yet, while (0, 0) may be outside the strip being drawn
         typename control_surface_type::pixel_type scr_bg;
-        destination.point({0, 0}, &scr_bg);
+        destination.point(gfx::point16(clip.x1, clip.y1), &scr_bg);
         uint16_t x_end = roundf(m_value * destination.dimensions().width - 1);
         uint16_t y_end = destination.dimensions().height - 1;
         if (m_is_gradient) {
             y_end = destination.dimensions().height * .6666;
-            // two reference points for the ends of the graph
-            gfx::hsva_pixel<32> px = gfx::color<gfx::hsva_pixel<32>>::red;
-            gfx::hsva_pixel<32> px2 = gfx::color<gfx::hsva_pixel<32>>::green;
-            auto h1 = px.channel<gfx::channel_name::H>();
-            auto h2 = px2.channel<gfx::channel_name::H>();
-            h2 -= 24;
-            // the actual range we're drawing
-            auto range = abs(h2 - h1) + 1;
-            // the width of each gradient segment
-            int w = (int)ceilf(destination.dimensions().width /
-                               (float)range) +
-                    1;
-            // the step of each segment - default 1
-            int s = 1;
-            // if the gradient is larger than the control
-            if (destination.dimensions().width < range) {
-                // change the segment to width 1
-                w = 1;
-                // and make its step larger
-                s = range / (float)destination.dimensions().width;
-            }
-            int x = 0;
-            // c is the current color offset
-            // it increases by s (step)
-            int c = 0;
-            // for each color in the range
-            for (auto j = 0; j < range; ++j) {
-                // adjust the H value (inverted and offset)
-                px.channel<gfx::channel_name::H>(range - c - 1 + h1);
-                // if we're drawing the filled part
-                // it's fully opaque
-                // otherwise it's semi-transparent
-                int sw = w;
-                int diff = 0;
-                if (m_value == 0 || x > x_end) {
-                    px.channel<gfx::channel_name::A>(95);
-                    if ((x - w) <= x_end) {
-                        sw = x_end - x + 1;
-                        diff = w - sw;
-                    }
-                } else {
-                    px.channel<gfx::channel_name::A>(255);
-                }
-                // create the rect for our segment
-                gfx::srect16 r(x, y_end + 1, x + sw, destination.dimensions().height - 1);
-
-                // black out the area underneath so alpha blending
-                // works correctly
-                gfx::draw::filled_rectangle(destination,
-                                            r,
-                                            scr_bg);
-                // draw the segment
-                gfx::draw::filled_rectangle(destination,
-                                            r,
-                                            px);
-                if (diff > 0) {
-                    r = gfx::srect16(x + sw, y_end + 1, x + w, destination.dimensions().height - 1);
-                    gfx::draw::filled_rectangle(destination,
-                                                r,
-                                                scr_bg);
-                    // draw the segment
-                    gfx::draw::filled_rectangle(destination,
-                                                r,
-                                                px);
-                }
-                // increment
-                x += w;
-                c += s;
-            }
+            // the last filled column, or -1 for none. computed signed since
+            // x_end is unsigned and wraps when the value rounds to nothing
+            int split = (m_value > 0.f) ? (int)roundf(m_value * destination.dimensions().width - 1) : -1;
+            if (split > destination.dimensions().width - 1) split = destination.dimensions().width - 1;
+            paint_gradient(destination, y_end + 1, split, scr_bg, clip);
         }
         if (m_value > 0) {
             // bar rectangles
-            gfx::draw::filled_rectangle(destination, gfx::srect16(0, 0, x_end, y_end), m_color);
-            gfx::draw::filled_rectangle(destination, gfx::srect16(x_end + 1, 0, destination.dimensions().width - 1, y_end), m_back_color);
+            paint_fill(destination, gfx::srect16(0, 0, x_end, y_end), m_color, clip, m_stats);
+            paint_fill(destination, gfx::srect16(x_end + 1, 0, destination.dimensions().width - 1, y_end), m_back_color, clip, m_stats);
         } else {
-            gfx::draw::filled_rectangle(destination, gfx::srect16(0, 0, destination.dimensions().width - 1, y_end), m_back_color);
+            paint_fill(destination, gfx::srect16(0, 0, destination.dimensions().width - 1, y_end), m_back_color, clip, m_stats);
         }
         if (m_buffer != nullptr) {
             if(m_point_buffer==nullptr) {
                 if (m_buffer->size() > 0) {
-                    float x_step = (destination.dimensions().width - 1) / (float)(data::circular_buffer<uint8_t, 100>::capacity - 1);
-                    float x = x_step;
-                    uint8_t initial = 255 - *m_buffer->peek(0);
-                    gfx::point16 opt(0, initial * (y_end) / 255);
-                    size_t i = 1;
+                    const int w = (int)destination.dimensions().width;
+                    const int cap = (int)buffer_type::capacity;
+                    bool first = true;
+                    gfx::point16 opt;
                     auto px = (m_value == 0) ? m_color : m_dark_mode ? uix_color_t::black
                                                                     : uix_color_t::white;
-                    while (i < m_buffer->size()) {
-                        uint8_t v = 255 - *m_buffer->peek(i);
-                        gfx::point16 pt(x, v * (y_end) / 255);
-                        gfx::draw::filled_rectangle(destination, gfx::rect16(opt, pt), px);
-                        if (x > x_end) {
-                            px = m_color;
+                    decimate_history(*m_buffer, 0, m_buffer->size() - 1, [w, cap](size_t j) { return spark_x((int)j, w, cap); }, [&](int x, uint8_t v) {
+                        gfx::point16 pt(x, (255 - v) * (y_end) / 255);
+                        if (!first) {
+                            paint_fill(destination, (gfx::srect16)gfx::rect16(opt, pt), px, clip, m_stats);
+                            if (x > x_end) {
+                                px = m_color;
+                            }
                         }
+                        first = false;
                         opt = pt;
-                        x += x_step;
-                        ++i;
-                    }
+                    });
                 }
             } else {
                 // smooth lines
@@ -721,11 +1620,11 @@ class bar : public uix::control<ControlSurfaceType> {
                     const uix::uix_pixel over_px = m_dark_mode ? uix_color_t::black : uix_color_t::white;
                     // over the filled part: inverse of the bar color
                     if (split > 0) {
-                        render_spark(destination, 0, split, (int)y_end, over_px, thickness);
+                        render_spark(destination, 0, split, (int)y_end, over_px, thickness, clip);
                     }
                     // past it: the bar color, starting on the shared vertex
                     if (split < w - 1) {
-                        render_spark(destination, split < 0 ? 0 : split, w - 1, (int)y_end, m_color, thickness);
+                        render_spark(destination, split < 0 ? 0 : split, w - 1, (int)y_end, m_color, thickness, clip);
                     }
                 }
             }
@@ -733,8 +1632,210 @@ class bar : public uix::control<ControlSurfaceType> {
     }
 };
 
-template <typename BitmapType, uint8_t HorizontalAlignment = 1, uint8_t VerticalAlignment = 1>
+// Ranges of rows, kept sorted and merged where they touch. Past the
+// capacity, the two with the smallest gap between them are merged.
+class row_spans {
+    static constexpr const size_t capacity = 8;
+    int16_t m_y1[capacity + 1];
+    int16_t m_y2[capacity + 1];
+    size_t m_size;
+
+   public:
+    row_spans() : m_size(0) {
+    }
+    size_t size() const {
+        return m_size;
+    }
+    int y1(size_t index) const {
+        return m_y1[index];
+    }
+    int y2(size_t index) const {
+        return m_y2[index];
+    }
+    void clear() {
+        m_size = 0;
+    }
+    void add(int y1, int y2) {
+        size_t i = 0;
+        while (i < m_size && m_y1[i] < y1) ++i;
+        for (size_t j = m_size; j > i; --j) {
+            m_y1[j] = m_y1[j - 1];
+            m_y2[j] = m_y2[j - 1];
+        }
+        m_y1[i] = y1;
+        m_y2[i] = y2;
+        ++m_size;
+        // merge what overlaps or abuts
+        size_t out = 0;
+        for (size_t j = 1; j < m_size; ++j) {
+            if (m_y1[j] <= m_y2[out] + 1) {
+                if (m_y2[j] > m_y2[out]) m_y2[out] = m_y2[j];
+            } else {
+                ++out;
+                m_y1[out] = m_y1[j];
+                m_y2[out] = m_y2[j];
+            }
+        }
+        m_size = out + 1;
+        if (m_size > capacity) {
+            size_t best = 0;
+            for (size_t j = 1; j + 1 < m_size; ++j) {
+                if (m_y1[j + 1] - m_y2[j] < m_y1[best + 1] - m_y2[best]) best = j;
+            }
+            m_y2[best] = m_y2[best + 1];
+            for (size_t j = best + 1; j + 1 < m_size; ++j) {
+                m_y1[j] = m_y1[j + 1];
+                m_y2[j] = m_y2[j + 1];
+            }
+            --m_size;
+        }
+    }
+};
+
+// The rectangles a frame changed. One inside another is dropped, and past
+// the capacity a new one is merged into whichever grows the least.
+class damage_list {
+    static constexpr const size_t capacity = 16;
+    gfx::rect16 m_rects[capacity];
+    size_t m_size;
+
+   public:
+    damage_list() : m_size(0) {
+    }
+    size_t size() const {
+        return m_size;
+    }
+    const gfx::rect16& operator[](size_t index) const {
+        return m_rects[index];
+    }
+    void clear() {
+        m_size = 0;
+    }
+    void add(const gfx::rect16& rect) {
+        for (size_t i = 0; i < m_size; ++i) {
+            if (m_rects[i].contains(rect)) return;
+        }
+        if (m_size < capacity) {
+            m_rects[m_size++] = rect;
+            return;
+        }
+        size_t best = 0;
+        size_t best_growth = (size_t)-1;
+        for (size_t i = 0; i < m_size; ++i) {
+            const size_t growth = m_rects[i].merge(rect).area() - m_rects[i].area();
+            if (growth < best_growth) {
+                best = i;
+                best_growth = growth;
+            }
+        }
+        m_rects[best] = m_rects[best].merge(rect);
+    }
+};
+
+// Covers the screen behind every other control and draws nothing. The
+// screen paints it along with each dirty rect, so it sees everything a
+// frame changes, including what only the background shows through.
+template <typename ControlSurfaceType>
+class dirty_tracker : public uix::control<ControlSurfaceType> {
+    using base_type = uix::control<ControlSurfaceType>;
+
+   public:
+    using type = dirty_tracker;
+    using control_surface_type = ControlSurfaceType;
+
+   private:
+    damage_list* m_damage;
+
+   public:
+    dirty_tracker() : base_type(), m_damage(nullptr) {
+    }
+    dirty_tracker(const dirty_tracker& rhs) = delete;
+    dirty_tracker& operator=(const dirty_tracker& rhs) = delete;
+    // where the painted rects go
+    void damage(damage_list* value) {
+        m_damage = value;
+    }
+
+   protected:
+    virtual void on_paint(control_surface_type& destination, const gfx::srect16& clip) override {
+        if (m_damage != nullptr) {
+            // the tracker is at (0, 0), so the clip is in screen coordinates
+            m_damage->add((gfx::rect16)clip);
+        }
+    }
+};
+
+// A static index of up to 32 rectangles for finding the ones under a point
+// or a rect. The height is cut into bands, and each band keeps a mask of the
+// rectangles that cross it, so a query only tests those in the bands it
+// spans. Bit i is rectangle i, so a mask walked from the low bit up is in
+// the order the rectangles were given. Rebuild it when any of them move.
+template <size_t Bands = 16>
+class rect_index {
+    static_assert(Bands > 0, "Bands must be at least 1");
+    const gfx::srect16* m_rects;
+    size_t m_count;
+    int m_band_height;
+    uint32_t m_bands[Bands];
+    int band_of(int y) const {
+        return gfx::math::clamp(0, y / m_band_height, (int)Bands - 1);
+    }
+
+   public:
+    rect_index() : m_rects(nullptr), m_count(0), m_band_height(1) {
+        memset(m_bands, 0, sizeof(m_bands));
+    }
+    // rects must outlive the index. Those past the 32nd aren't indexed
+    void build(const gfx::srect16* rects, size_t count, int height) {
+        m_rects = rects;
+        m_count = count < 32 ? count : 32;
+        m_band_height = height > (int)Bands ? (height + (int)Bands - 1) / (int)Bands : 1;
+        memset(m_bands, 0, sizeof(m_bands));
+        for (size_t i = 0; i < m_count; ++i) {
+            const gfx::srect16& r = rects[i];
+            const int b2 = band_of(r.bottom());
+            for (int b = band_of(r.top()); b <= b2; ++b) {
+                m_bands[b] |= (uint32_t)1 << i;
+            }
+        }
+    }
+    // the rectangles that intersect rect
+    uint32_t query(const gfx::srect16& rect) const {
+        if (m_count == 0) return 0;
+        uint32_t candidates = 0;
+        const int b2 = band_of(rect.bottom());
+        for (int b = band_of(rect.top()); b <= b2; ++b) {
+            candidates |= m_bands[b];
+        }
+        uint32_t result = 0;
+        for (size_t i = 0; i < m_count && (candidates >> i); ++i) {
+            if (((candidates >> i) & 1) && m_rects[i].intersects(rect)) {
+                result |= (uint32_t)1 << i;
+            }
+        }
+        return result;
+    }
+    // the first rectangle that contains pt, or -1
+    int first(gfx::spoint16 pt) const {
+        if (m_count == 0) return -1;
+        const uint32_t candidates = m_bands[band_of(pt.y)];
+        for (size_t i = 0; i < m_count && (candidates >> i); ++i) {
+            if (((candidates >> i) & 1) && m_rects[i].intersects(pt)) {
+                return (int)i;
+            }
+        }
+        return -1;
+    }
+};
+
+// HistorySize is how many samples the graph and the sparklines keep
+template <typename BitmapType, uint8_t HorizontalAlignment = 1, uint8_t VerticalAlignment = 1, size_t HistorySize = 100>
 class espmon {
+   public:
+    // the most set_transfer_buffers() will use
+    static constexpr const size_t max_transfer_buffers = 8;
+
+   private:
     using pixel_t = typename BitmapType::pixel_type;
     using palette_t = typename BitmapType::palette_type;
     using screen_t = uix::screen_ex<BitmapType, HorizontalAlignment, VerticalAlignment>;
@@ -742,13 +1843,16 @@ class espmon {
     using color_t = gfx::color<typename BitmapType::pixel_type>;
     using uix_color_t = gfx::color<uix::uix_pixel>;
     using vcolor_t = gfx::color<gfx::vector_pixel>;
-    using bar_t = bar<typename screen_t::control_surface_type>;
+    using bar_t = bar<typename screen_t::control_surface_type, HistorySize>;
     using vert_label_t = vvert_label<typename screen_t::control_surface_type>;
     using label_t = uix::vlabel<typename screen_t::control_surface_type>;
-    using graph_t = graph<typename screen_t::control_surface_type>;
+    using value_label_t = value_label<typename screen_t::control_surface_type>;
+    using graph_t = graph<typename screen_t::control_surface_type, HistorySize>;
     using graph_buffer_t = typename graph_t::buffer_type;
+    using dirty_tracker_t = dirty_tracker<typename screen_t::control_surface_type>;
     static constexpr const size_t hit_boxes_size = ((size_t)espmon_hit::graph) + 1;
     gfx::srect16 m_hit_boxes[hit_boxes_size];
+    rect_index<> m_hit_index;
     uix::display m_display;
     gfx::const_buffer_stream m_font;
     bool m_has_graph;
@@ -763,7 +1867,9 @@ class espmon {
         char suffix_buffer[12];
         bar_t bar;
         size_t index;
-        label_t label;
+        // how many of the newest sparkline samples have the newest value
+        size_t spark_run;
+        value_label_t label;
         vert_label_t vsuffix;
     } value_entry_t;
     typedef struct {
@@ -777,20 +1883,154 @@ class espmon {
     screen_entry_t m_bottom;
     label_t m_disconnected_label;
     int8_t m_screen_index = -1;
+    // data frames that left the display untouched, and labels and bars
+    // within data frames that didn't need repainting
+    size_t m_skipped_frames;
+    size_t m_skipped_fields;
+    // data frames that only went into the graph
+    size_t m_folded_frames;
+    // transfers that had to finish before the display could go on. A
+    // transfer is counted once however many update() calls wait on it
+    size_t m_flush_stalls;
+    // transfer_complete() calls, so a wait can be matched to its transfer.
+    // Bumped from the transfer's ISR while the display reads it
+    std::atomic<uint32_t> m_transfers;
+    uint32_t m_stalled_transfer;
+    uint32_t m_overlapped_transfer;
+    // partial mode with two buffers renders one tile while a transfer is in flight
+    bool m_overlap;
+    // Partial mode with more than two transfer buffers. The screen is given
+    // one at a time as if it were the only one, and each flush moves it on to
+    // the next. Transfers complete in the order they were started, so the
+    // next one is free once fewer than all of them are in flight
+    uint8_t* m_transfer_buffers[max_transfer_buffers];
+    size_t m_transfer_buffer_count;
+    size_t m_next_transfer_buffer;
+    uint32_t m_transfers_started;
+    // Direct mode with two framebuffers. The screen is given one at a time
+    // as if it were the only one, and the rows the last frame changed are
+    // copied over from the other one before the next frame is drawn,
+    // rather than the screen repainting them
+    uint8_t* m_frame_buffers[2];
+    size_t m_back_buffer;
+    bool m_flip_pending;
+    row_spans m_flushed_rows;
+    // in direct mode, what the frame being drawn has changed so far
+    bool m_is_direct;
+    damage_list m_painted;
+    row_spans m_copied_rows;
+    dirty_tracker_t m_tracker;
+    dirty_tracker_t m_disconnected_tracker;
+    uix::screen_base::on_flush_callback_type m_flush_callback;
+    void* m_flush_state;
     graph_buffer_t m_buffers[4];
-    gfx::spoint16 m_points[graph_buffer_t::capacity];
+    // polyline vertices, two per column of the display
+    gfx::spoint16* m_points;
+    size_t m_points_size;
     gfx::mask_draw_cache m_draw_cache;
+    glyph_atlas m_glyphs;
     graph_t m_graph;
 
+    static void reset_entry_stats(screen_entry_t& entry) {
+        entry.label.reset_stats();
+        entry.value1.label.reset_stats();
+        entry.value1.vsuffix.reset_stats();
+        entry.value1.bar.reset_stats();
+        entry.value2.label.reset_stats();
+        entry.value2.vsuffix.reset_stats();
+        entry.value2.bar.reset_stats();
+    }
+    static paint_stats value_stats(const value_entry_t& value) {
+        const paint_stats& label = value.label.stats();
+        const paint_stats& suffix = value.vsuffix.stats();
+        return {label.painted + suffix.painted, label.flushed + suffix.flushed};
+    }
+    static void on_flush(const uix::rect16& bounds, const void* bmp, void* state) {
+        espmon* ths = (espmon*)state;
+        // counted first, in case the transfer completes inside the callback
+        ++ths->m_transfers_started;
+        if (ths->m_flush_callback != nullptr) {
+            ths->m_flush_callback(bounds, bmp, ths->m_flush_state);
+        }
+        if (ths->m_transfer_buffer_count != 0) {
+            ths->next_transfer_buffer();
+        }
+        if (ths->m_frame_buffers[1] != nullptr) {
+            // what this frame painted is stale in the other framebuffer
+            ths->m_flushed_rows.clear();
+            for (size_t i = 0; i < ths->m_painted.size(); ++i) {
+                ths->m_flushed_rows.add(ths->m_painted[i].y1, ths->m_painted[i].y2);
+            }
+            ths->m_flip_pending = true;
+        }
+        ths->m_painted.clear();
+        ths->m_copied_rows.clear();
+    }
+    // Moves the screen to the framebuffer that isn't being scanned out, and
+    // brings it up to date by copying the rows the last frame changed from
+    // the one that is. Only once the swap has landed.
+    void flip_frame_buffers() {
+        const uint8_t* front = m_frame_buffers[m_back_buffer];
+        m_back_buffer ^= 1;
+        uint8_t* back = m_frame_buffers[m_back_buffer];
+        const size_t row_bits = (size_t)m_display_size.width * pixel_t::bit_depth;
+        for (size_t i = 0; i < m_flushed_rows.size(); ++i) {
+            // whole bytes. Outside the rows both buffers are the same
+            const size_t offset = (m_flushed_rows.y1(i) * row_bits) / 8;
+            const size_t end = ((m_flushed_rows.y2(i) + 1) * row_bits + 7) / 8;
+            memcpy(back + offset, front + offset, end - offset);
+            m_copied_rows.add(m_flushed_rows.y1(i), m_flushed_rows.y2(i));
+        }
+        m_flushed_rows.clear();
+        m_display.buffer1(back);
+        m_display.active_screen().buffer1(back);
+        m_flip_pending = false;
+    }
+    bool transfer_buffers_busy() const {
+        return m_transfer_buffer_count != 0 && m_transfers_started - m_transfers.load() >= m_transfer_buffer_count;
+    }
+    // Moves the screen on to the next transfer buffer, and lets it render
+    // into it right away unless that one is still being transferred. If it
+    // is, the next transfer_complete() frees it
+    void next_transfer_buffer() {
+        m_next_transfer_buffer = (m_next_transfer_buffer + 1) % m_transfer_buffer_count;
+        uint8_t* next = m_transfer_buffers[m_next_transfer_buffer];
+        m_display.buffer1(next);
+        m_display.active_screen().buffer1(next);
+        if (!transfer_buffers_busy()) {
+            m_display.flush_complete();
+        }
+    }
     void refresh_display(bool full = true) {
         while (m_display.dirty()) {
-            m_display.update();
+            // a screen that was just made active doesn't know its buffer is
+            // still being transferred
+            const bool busy = transfer_buffers_busy();
+            if (busy || m_display.flushing()) {
+                const uint32_t transfers = m_transfers.load();
+                if (m_overlap && m_overlapped_transfer != transfers) {
+                    m_overlapped_transfer = transfers;
+                } else if (m_stalled_transfer != transfers) {
+                    m_stalled_transfer = transfers;
+                    ++m_flush_stalls;
+                }
+            } else if (m_flip_pending) {
+                flip_frame_buffers();
+            }
+            if (!busy) {
+                m_display.update();
+            }
             if (!full) {
                 break;
             }
         }
     }
     void init_disconnected_screen() {
+        m_disconnected_screen.unregister_controls();
+        // always first, so set_transfer() can turn tracking on after this
+        m_disconnected_tracker.bounds(m_disconnected_screen.bounds());
+        m_disconnected_tracker.damage(m_is_direct ? &m_painted : nullptr);
+        m_disconnected_screen.register_control(m_disconnected_tracker);
         m_disconnected_label.bounds(gfx::srect16(0, 0, m_disconnected_screen.dimensions().width / 2, m_disconnected_screen.dimensions().width / 8).center(m_disconnected_screen.bounds()));
         uix::uix_pixel bg = uix_color_t::black;
         m_disconnected_label.font(m_top.value1.label.font());
@@ -802,14 +2042,18 @@ class espmon {
     }
     void init_screen() {
         m_screen.unregister_controls();
+        m_tracker.bounds(m_screen.bounds());
+        m_tracker.damage(m_is_direct ? &m_painted : nullptr);
+        m_screen.register_control(m_tracker);
         int section_height_divisor = m_has_graph ? 4 : 2;
         m_screen.background_color(color_t::black);
         if (m_has_graph) {
             uix::srect16 b = m_screen.bounds();
             b.y1 = m_screen.dimensions().height / 2 + 1;
             m_graph.bounds(b);
-            m_graph.point_buffer(m_points);
+            m_graph.point_buffer(m_points, m_points_size);
             m_graph.draw_cache(&m_draw_cache);
+            m_graph.background_color(uix_color_t::black);
             m_hit_boxes[(size_t)espmon_hit::graph] = m_graph.bounds();
             if (!m_graph.has_lines()) {
                 m_graph.add_line(uix_color_t::green, &m_buffers[0]);
@@ -823,6 +2067,7 @@ class espmon {
         m_top.label.text("---");
         m_top.label.background_color(uix_color_t::black);
         m_top.label.color(uix_color_t::white);
+        m_top.label.font(m_font);
         m_screen.register_control(m_top.label);
         gfx::srect16 b = m_top.label.bounds();
         int16_t sh = m_screen.dimensions().height / section_height_divisor;
@@ -837,7 +2082,7 @@ class espmon {
         gfx::srect16 vb(b.x2 + 2, b.y1, b.x2 + 1 + (m_screen.dimensions().width / 5), b.height() / 2 + b.y1);
         m_top.value1.label.bounds(vb);
         m_hit_boxes[(size_t)espmon_hit::top_value1] = m_top.value1.label.bounds();
-        m_top.value1.label.font(monoxbold);
+        m_top.value1.label.font(m_font);
         m_top.value1.label.color(uix_color_t::white);
         m_top.value1.label.text_justify(uix::uix_justify::center_right);
         strcpy(m_top.value1.value_buffer, "---");
@@ -849,6 +2094,7 @@ class espmon {
         m_top.value1.vsuffix.color(m_top.value1.label.color());
         m_top.value1.vsuffix.background_color(uix_color_t::black);
         m_top.value1.vsuffix.visible(false);
+        m_top.value1.vsuffix.font(m_font);
         m_screen.register_control(m_top.value1.vsuffix);
 
         b = m_top.value1.label.bounds();
@@ -867,6 +2113,7 @@ class espmon {
         m_top.value2.vsuffix.color(m_top.value2.label.color());
         m_top.value2.vsuffix.background_color(uix_color_t::black);
         m_top.value2.vsuffix.visible(false);
+        m_top.value2.vsuffix.font(m_font);
         m_screen.register_control(m_top.value2.vsuffix);
 
         b = m_top.value1.label.bounds();
@@ -874,12 +2121,12 @@ class espmon {
         b.x2 = m_screen.dimensions().width - 1;
         b.y2 -= 2;
         m_top.value1.bar.bounds(b);
-        m_top.value1.bar.point_buffer(m_points);
+        m_top.value1.bar.point_buffer(m_points, m_points_size);
         m_top.value1.bar.draw_cache(&m_draw_cache);
         m_hit_boxes[(size_t)espmon_hit::top_value1_bar] = m_top.value1.bar.bounds();
         m_top.value1.bar.back_color(uix_color_t::black);
         if (!m_has_graph) {
-            m_top.value1.bar.point_buffer(m_points);
+            m_top.value1.bar.point_buffer(m_points, m_points_size);
             m_top.value1.bar.draw_cache(&m_draw_cache);
             m_top.value1.bar.graph_buffer(&m_buffers[0]);
         }
@@ -894,7 +2141,7 @@ class espmon {
         m_hit_boxes[(size_t)espmon_hit::top_value2_bar] = m_top.value2.bar.bounds();
         auto px = uix_color_t::white;
         if (!m_has_graph) {
-            m_top.value2.bar.point_buffer(m_points);
+            m_top.value2.bar.point_buffer(m_points, m_points_size);
             m_top.value2.bar.draw_cache(&m_draw_cache);
             m_top.value2.bar.graph_buffer(&m_buffers[1]);
         }
@@ -908,6 +2155,7 @@ class espmon {
         m_bottom.label.color(uix_color_t::white);
         m_bottom.label.background_color(uix_color_t::black);
         m_bottom.label.text("---");
+        m_bottom.label.font(m_font);
         m_screen.register_control(m_bottom.label);
         m_bottom.value1.label.bounds(m_top.value1.label.bounds().offset(0, m_screen.dimensions().height / section_height_divisor));
         m_hit_boxes[(size_t)espmon_hit::bottom_value1] = m_bottom.value1.label.bounds();
@@ -933,6 +2181,7 @@ class espmon {
         m_bottom.value1.vsuffix.color(m_bottom.value1.label.color());
         m_bottom.value1.vsuffix.background_color(uix_color_t::black);
         m_bottom.value1.vsuffix.visible(false);
+        m_bottom.value1.vsuffix.font(m_font);
         m_screen.register_control(m_bottom.value1.vsuffix);
 
         m_screen.register_control(m_bottom.value1.label);
@@ -951,6 +2200,7 @@ class espmon {
         m_bottom.value2.vsuffix.color(m_bottom.value2.label.color());
         m_bottom.value2.vsuffix.background_color(uix_color_t::black);
         m_bottom.value2.vsuffix.visible(false);
+        m_bottom.value2.vsuffix.font(m_font);
         m_screen.register_control(m_bottom.value2.vsuffix);
 
         b = m_bottom.value1.label.bounds();
@@ -962,7 +2212,7 @@ class espmon {
         m_hit_boxes[(size_t)espmon_hit::bottom_value1_bar] = m_bottom.value1.bar.bounds();
         if (!m_has_graph) {
             m_bottom.value1.bar.graph_buffer(&m_buffers[2]);
-            m_bottom.value1.bar.point_buffer(m_points);
+            m_bottom.value1.bar.point_buffer(m_points, m_points_size);
             m_bottom.value1.bar.draw_cache(&m_draw_cache);
         }
         m_bottom.value1.bar.color(m_has_graph ? m_graph.get_line(2) : uix_color_t::white);
@@ -978,7 +2228,7 @@ class espmon {
         
         if(!m_has_graph) {
             m_bottom.value2.bar.graph_buffer(&m_buffers[3]);
-            m_bottom.value2.bar.point_buffer(m_points);
+            m_bottom.value2.bar.point_buffer(m_points, m_points_size);
             m_bottom.value2.bar.draw_cache(&m_draw_cache);
         }
         
@@ -995,10 +2245,91 @@ class espmon {
         if (m_has_graph) {
             m_screen.register_control(m_graph);
         }
+        // the value labels blit prerendered glyphs. Sizes rendered for the
+        // old layout won't be used again
+        m_glyphs.font(m_font);
+        m_glyphs.clear();
+        m_top.value1.label.atlas(&m_glyphs);
+        m_top.value2.label.atlas(&m_glyphs);
+        m_bottom.value1.label.atlas(&m_glyphs);
+        m_bottom.value2.label.atlas(&m_glyphs);
+        // without the graph, its box is left over from an old layout
+        m_hit_index.build(m_hit_boxes, hit_boxes_size - (!m_has_graph), m_screen.dimensions().height);
         m_display.active_screen(m_screen);
         m_is_screen_populated = false;
     }
+    // suffixes that aren't drawn vertically are part of the value text, so
+    // their characters have to be in the atlas
+    void update_glyph_chars() {
+        const value_entry_t* entries[] = {&m_top.value1, &m_top.value2, &m_bottom.value1, &m_bottom.value2};
+        char chars[sizeof(entries) / sizeof(entries[0]) * sizeof(entries[0]->suffix_buffer) + 1];
+        size_t len = 0;
+        for (const value_entry_t* entry : entries) {
+            if (!entry->vsuffix.visible()) {
+                const size_t l = strnlen(entry->suffix_buffer, sizeof(entry->suffix_buffer));
+                memcpy(chars + len, entry->suffix_buffer, l);
+                len += l;
+            }
+        }
+        chars[len] = 0;
+        m_glyphs.extra_chars(chars);
+    }
+    // applies one value of a data frame. The label and the bar are only
+    // invalidated if what they show changed
+    void set_value_entry(value_entry_t& entry, size_t index, const response_value_t& rvalue) {
+        float v = rvalue.scaled;
+        if (isnan(v)) {
+            v = 0.f;
+        }
+        bool spark_changed = false;
+        if (m_has_graph) {
+            m_graph.add_data(index, v);
+        } else if (entry.bar.graph_buffer() != nullptr) {
+            spark_changed = add_spark_data(entry, index, v);
+        }
+        char text[sizeof(entry.value_buffer)];
+        format_float(rvalue.value, text, sizeof(text));
+        if (!entry.vsuffix.visible()) {
+            size_t len = strlen(text);
+            strncpy(text + len, entry.suffix_buffer, sizeof(text) - len);
+        }
+        if (0 != memcmp(text, entry.value_buffer, sizeof(text))) {
+            memcpy(entry.value_buffer, text, sizeof(text));
+            entry.label.text(entry.value_buffer);
+        } else {
+            ++m_skipped_fields;
+        }
+        const bool same_bar = entry.bar.is_same_extent(v);
+        entry.bar.value(v);
+        if (spark_changed) {
+            entry.bar.invalidate();
+        } else if (same_bar) {
+            ++m_skipped_fields;
+        }
+    }
+    // feeds a bar's sparkline when there's no graph to do it. The line only
+    // looks different afterward unless the whole history is that one value
+    bool add_spark_data(value_entry_t& entry, size_t index, float value) {
+        graph_buffer_t& buffer = m_buffers[index];
+        const uint8_t v = gfx::math::clamp(0.f, value, 1.f) * 255;
+        const uint8_t* newest = buffer.empty() ? nullptr : buffer.peek(buffer.size() - 1);
+        if (newest != nullptr && *newest == v) {
+            if (entry.spark_run <= buffer.capacity) ++entry.spark_run;
+        } else {
+            entry.spark_run = 1;
+        }
+        if (buffer.size() == buffer.capacity) {
+            uint8_t tmp;
+            buffer.get(&tmp);
+        }
+        buffer.put(v);
+        return entry.spark_run <= buffer.capacity;
+    }
 
+    static size_t font_data_size() {
+        static const size_t result = (size_t)monoxbold.seek(0, gfx::seek_origin::end);
+        return result;
+    }
     static uix::uix_pixel to_color(const response_color_t& col) {
         return uix::uix_pixel(col.r, col.g, col.b, col.a);
     }
@@ -1044,7 +2375,9 @@ class espmon {
     void set_screen_value_entry(value_entry_t& entry, size_t index, bool vert, const response_screen_value_entry_t& rentry) {
         entry.index = index;
         entry.bar.value(0);
-        entry.label.text("---");
+        // through the buffer, so the next data frame compares against it
+        strcpy(entry.value_buffer, "---");
+        entry.label.text(entry.value_buffer);
         strncpy(entry.suffix_buffer, rentry.suffix, sizeof(entry.suffix_buffer) - 1);
         if (vert) {
             gfx::srect16 b = entry.label.bounds();
@@ -1095,6 +2428,37 @@ class espmon {
         m_is_monochrome = false;
         m_is_screen_populated = false;
         m_screen_index = -1;
+        m_points = nullptr;
+        m_points_size = 0;
+        m_skipped_frames = 0;
+        m_skipped_fields = 0;
+        m_top.value1.spark_run = 0;
+        m_top.value2.spark_run = 0;
+        m_bottom.value1.spark_run = 0;
+        m_bottom.value2.spark_run = 0;
+        m_folded_frames = 0;
+        m_flush_stalls = 0;
+        m_transfers = 0;
+        m_stalled_transfer = ~0u;
+        m_overlapped_transfer = ~0u;
+        m_overlap = false;
+        m_transfer_buffer_count = 0;
+        m_next_transfer_buffer = 0;
+        m_transfers_started = 0;
+        m_frame_buffers[0] = nullptr;
+        m_frame_buffers[1] = nullptr;
+        m_back_buffer = 0;
+        m_flip_pending = false;
+        m_is_direct = false;
+        m_flush_callback = nullptr;
+        m_flush_state = nullptr;
+    }
+    espmon(const espmon& rhs) = delete;
+    espmon& operator=(const espmon& rhs) = delete;
+    ~espmon() {
+        if (m_points != nullptr) {
+            free(m_points);
+        }
     }
     // application defined use
     void* user_ctx;
@@ -1116,6 +2480,14 @@ class espmon {
             m_screen.invalidate();
         }
     }
+    // scroll the graph from an offscreen copy instead of redrawing it every
+    // sample. Costs a native bitmap the size of the graph.
+    bool graph_scrolling() const {
+        return m_graph.is_scrolling();
+    }
+    void graph_scrolling(bool value) {
+        m_graph.is_scrolling(value);
+    }
     bool is_monochrome() const {
         return m_is_monochrome;
     }
@@ -1128,12 +2500,8 @@ class espmon {
         }
     }
     espmon_hit hit_test(gfx::spoint16 pt) {
-        for (size_t i = 0; i < hit_boxes_size - (!has_graph()); ++i) {
-            if (m_hit_boxes[i].intersects(pt)) {
-                return (espmon_hit)i;
-            }
-        }
-        return espmon_hit::none;
+        const int i = m_hit_index.first(pt);
+        return i < 0 ? espmon_hit::none : (espmon_hit)i;
     }
     void dimensions(gfx::size16 dimensions) {
         if (dimensions != m_display_size) {
@@ -1141,6 +2509,16 @@ class espmon {
             m_screen.unregister_controls();
             m_screen.dimensions((gfx::ssize16)dimensions);
             m_draw_cache.ensure((size_t)dimensions.width);
+            if (m_points != nullptr) {
+                free(m_points);
+            }
+            // the decimated polylines never need more than two vertices per
+            // column. Without them the lines are drawn blocky instead.
+            m_points_size = (size_t)dimensions.width * 2 + 2;
+            m_points = (gfx::spoint16*)malloc(m_points_size * sizeof(gfx::spoint16));
+            if (m_points == nullptr) {
+                m_points_size = 0;
+            }
             m_display_size = dimensions;
             init_screen();
             m_is_screen_populated = false;
@@ -1158,7 +2536,12 @@ class espmon {
     uix::size16 dimensions() const {
         return m_display_size;
     }
-    void transfer_complete() { m_display.flush_complete(); }
+    // Counted before the screen is let go on, so with a ring of transfer
+    // buffers it never sees a buffer free that the count says is busy
+    void transfer_complete() {
+        m_transfers.fetch_add(1);
+        m_display.flush_complete();
+    }
     void disconnect() {
         m_is_connected = false;
         m_display.active_screen(m_disconnected_screen);
@@ -1172,15 +2555,77 @@ class espmon {
     bool is_dirty() const {
         return m_display.dirty();
     }
+    // data frames that changed nothing on the display
+    size_t skipped_frames() const {
+        return m_skipped_frames;
+    }
+    // labels and bars (four of each per data frame) that were left alone
+    // because their text or filled width didn't change
+    size_t skipped_fields() const {
+        return m_skipped_fields;
+    }
+    // data frames passed to fold_data()
+    size_t folded_frames() const {
+        return m_folded_frames;
+    }
+    // times refresh() had to wait on transfer_complete() before it could go on
+    size_t flush_stalls() const {
+        return m_flush_stalls;
+    }
+    // what a control drew against what of it was flushed, since
+    // reset_paint_stats(). A value counts its suffix label too. The labels
+    // shown horizontally aren't counted
+    paint_stats control_stats(espmon_hit control) const {
+        switch (control) {
+            case espmon_hit::top_label:
+                return m_top.label.stats();
+            case espmon_hit::top_value1:
+                return value_stats(m_top.value1);
+            case espmon_hit::top_value1_bar:
+                return m_top.value1.bar.stats();
+            case espmon_hit::top_value2:
+                return value_stats(m_top.value2);
+            case espmon_hit::top_value2_bar:
+                return m_top.value2.bar.stats();
+            case espmon_hit::bottom_label:
+                return m_bottom.label.stats();
+            case espmon_hit::bottom_value1:
+                return value_stats(m_bottom.value1);
+            case espmon_hit::bottom_value1_bar:
+                return m_bottom.value1.bar.stats();
+            case espmon_hit::bottom_value2:
+                return value_stats(m_bottom.value2);
+            case espmon_hit::bottom_value2_bar:
+                return m_bottom.value2.bar.stats();
+            case espmon_hit::graph:
+                return m_graph.stats();
+            default:
+                return {0, 0};
+        }
+    }
+    void reset_paint_stats() {
+        reset_entry_stats(m_top);
+        reset_entry_stats(m_bottom);
+        m_graph.reset_stats();
+    }
     void clear_data() {
         m_graph.clear_data();
+        if (!m_has_graph) {
+            // the sparklines' histories aren't the graph's
+            for (graph_buffer_t& buffer : m_buffers) {
+                buffer.clear();
+            }
+            m_top.value1.spark_run = 0;
+            m_top.value2.spark_run = 0;
+            m_bottom.value1.spark_run = 0;
+            m_bottom.value2.spark_run = 0;
+        }
         m_top.value1.bar.clear();
         m_top.value2.bar.clear();
         m_bottom.value1.bar.clear();
         m_bottom.value2.bar.clear();
     }
     void accept_packet(command_t cmd, const response_t& resp, bool refresh = true) {
-        float v;
         if (!m_is_connected) {
             m_display.active_screen(m_screen);
             m_is_connected = true;
@@ -1215,6 +2660,7 @@ class espmon {
             set_screen_entry(m_bottom, scr.bottom);
             set_screen_value_entry(m_bottom.value1, 2, is_vert && (vert[2] > 1), scr.bottom.value1);
             set_screen_value_entry(m_bottom.value2, 3, is_vert && (vert[3] > 1), scr.bottom.value2);
+            update_glyph_chars();
 
             set_gradients(scr);
             if (!m_is_screen_populated) {
@@ -1234,66 +2680,14 @@ class espmon {
         }
         if (cmd == CMD_DATA) {  // screen data
             const response_data_t& data = resp.data;
-            v = data.top.value1.scaled;
-            if (isnan(v)) {
-                v = 0.f;
-            }
-            if (m_has_graph) {
-                m_graph.add_data(0, v);
-            }
-            format_float(data.top.value1.value, m_top.value1.value_buffer, sizeof(m_top.value1.value_buffer));
-            if (!m_top.value1.vsuffix.visible()) {
-                size_t len = strlen(m_top.value1.value_buffer);
-                strncpy(m_top.value1.value_buffer + len, m_top.value1.suffix_buffer, sizeof(m_top.value1.value_buffer) - len);
-            }
-            m_top.value1.label.text(m_top.value1.value_buffer);
-            m_top.value1.bar.value(v);
-            m_top.value1.bar.invalidate();
-            v = data.top.value2.scaled;
-            if (isnan(v)) {
-                v = 0.f;
-            }
-            if (m_has_graph) {
-                m_graph.add_data(1, v);
-            }
-            format_float(data.top.value2.value, m_top.value2.value_buffer, sizeof(m_top.value2.value_buffer));
-            if (!m_top.value2.vsuffix.visible()) {
-                size_t len = strlen(m_top.value2.value_buffer);
-                strncpy(m_top.value2.value_buffer + len, m_top.value2.suffix_buffer, sizeof(m_top.value2.value_buffer) - len);
-            }
-            m_top.value2.label.text(m_top.value2.value_buffer);
-            m_top.value2.bar.value(v);
-            m_top.value2.bar.invalidate();
-            v = data.bottom.value1.scaled;
-            if (isnan(v)) {
-                v = 0.f;
+            const bool was_dirty = m_display.dirty();
+            set_value_entry(m_top.value1, 0, data.top.value1);
+            set_value_entry(m_top.value2, 1, data.top.value2);
+            set_value_entry(m_bottom.value1, 2, data.bottom.value1);
+            set_value_entry(m_bottom.value2, 3, data.bottom.value2);
+            if (!was_dirty && !m_display.dirty()) {
+                ++m_skipped_frames;
             }
-            if (m_has_graph) {
-                m_graph.add_data(2, v);
-            }
-            format_float(data.bottom.value1.value, m_bottom.value1.value_buffer, sizeof(m_bottom.value1.value_buffer));
-            if (!m_bottom.value1.vsuffix.visible()) {
-                size_t len = strlen(m_bottom.value1.value_buffer);
-                strncpy(m_bottom.value1.value_buffer + len, m_bottom.value1.suffix_buffer, sizeof(m_bottom.value1.value_buffer) - len);
-            }
-            m_bottom.value1.label.text(m_bottom.value1.value_buffer);
-            m_bottom.value1.bar.value(v);
-            m_bottom.value1.bar.invalidate();
-            v = data.bottom.value2.scaled;
-            if (isnan(v)) {
-                v = 0.f;
-            }
-            if (m_has_graph) {
-                m_graph.add_data(3, v);
-            }
-            format_float(data.bottom.value2.value, m_bottom.value2.value_buffer, sizeof(m_bottom.value2.value_buffer));
-            if (!m_bottom.value2.vsuffix.visible()) {
-                size_t len = strlen(m_bottom.value2.value_buffer);
-                strncpy(m_bottom.value2.value_buffer + len, m_bottom.value2.suffix_buffer, sizeof(m_bottom.value2.value_buffer) - len);
-            }
-            m_bottom.value2.label.text(m_bottom.value2.value_buffer);
-            m_bottom.value2.bar.value(v);
-            m_bottom.value2.bar.invalidate();
             if (refresh) {
                 refresh_display();
             }
@@ -1305,22 +2699,105 @@ class espmon {
             }
         }
     }
+    // adds a data frame to the graph's history, or to the sparklines' on
+    // boards without one, and nothing else, for a frame a later one replaces
+    // before the display is next painted. The labels and the bars' fill only
+    // ever show the latest, so there's no point in updating them
+    void fold_data(const response_data_t& data) {
+        ++m_folded_frames;
+        const response_value_t* values[] = {&data.top.value1, &data.top.value2, &data.bottom.value1, &data.bottom.value2};
+        value_entry_t* entries[] = {&m_top.value1, &m_top.value2, &m_bottom.value1, &m_bottom.value2};
+        for (size_t i = 0; i < 4; ++i) {
+            float v = values[i]->scaled;
+            if (isnan(v)) {
+                v = 0.f;
+            }
+            if (m_has_graph) {
+                m_graph.add_data(i, v);
+            } else if (entries[i]->bar.graph_buffer() != nullptr && add_spark_data(*entries[i], i, v)) {
+                entries[i]->bar.invalidate();
+            }
+        }
+    }
+    // the samples kept for value index (0-3), which the graph draws, or the
+    // bar's sparkline on boards without one
+    const graph_buffer_t& history(size_t index) const {
+        return m_buffers[index];
+    }
     void set_flush_callback(uix::screen_base::on_flush_callback_type flush_callback, void* flush_state = nullptr) {
-        m_display.on_flush_callback(flush_callback, flush_state);
+        m_flush_callback = flush_callback;
+        m_flush_state = flush_state;
+        m_display.on_flush_callback(on_flush, this);
         m_display.active_screen(m_screen);
     }
+    // In direct mode, the rects the frame being flushed painted, in screen
+    // coordinates. The flush itself always covers the whole screen. Only
+    // valid during the flush callback
+    const damage_list& frame_rects() const {
+        return m_painted;
+    }
+    // With two framebuffers, the rows copied in from the other one before
+    // the frame being flushed was painted. Only valid during the flush callback
+    const row_spans& frame_copied_rows() const {
+        return m_copied_rows;
+    }
+    // In direct mode, buffer2 is a second framebuffer the panel swaps to
+    // once it's flushed. Call this before the display is first updated
     void set_transfer(uix::screen_update_mode update_mode, uint8_t* buffer1, size_t buffer_size, uint8_t* buffer2 = nullptr) {
         m_display.update_mode(update_mode);
         m_display.buffer_size(buffer_size);
         m_display.buffer1(buffer1);
-        m_display.buffer2(buffer2);
+        m_frame_buffers[0] = nullptr;
+        m_frame_buffers[1] = nullptr;
+        m_back_buffer = 0;
+        m_flip_pending = false;
+        m_flushed_rows.clear();
+        m_is_direct = update_mode == uix::screen_update_mode::direct;
+        m_tracker.damage(m_is_direct ? &m_painted : nullptr);
+        m_disconnected_tracker.damage(m_is_direct ? &m_painted : nullptr);
+        m_painted.clear();
+        m_copied_rows.clear();
+        if (update_mode == uix::screen_update_mode::direct && buffer2 != nullptr) {
+            m_frame_buffers[0] = buffer1;
+            m_frame_buffers[1] = buffer2;
+            m_display.buffer2(nullptr);
+        } else {
+            m_display.buffer2(buffer2);
+        }
+        m_overlap = update_mode == uix::screen_update_mode::partial && buffer2 != nullptr;
+        m_transfer_buffer_count = 0;
+        m_next_transfer_buffer = 0;
+        m_transfers_started = m_transfers.load();
         if (m_is_connected) {
             m_display.active_screen(m_screen);
         } else {
             m_display.active_screen(m_disconnected_screen);
         }
     }
+    // Partial mode with count transfer buffers of buffer_size bytes each,
+    // up to max_transfer_buffers, so the display can render up to count - 1
+    // tiles ahead of the transfers. Each flush must complete with
+    // transfer_complete() in the order it was made. Call this before
+    // initialize()
+    void set_transfer_buffers(uint8_t* const* buffers, size_t count, size_t buffer_size) {
+        if (count > max_transfer_buffers) {
+            count = max_transfer_buffers;
+        }
+        if (count < 3) {
+            // the screen handles two itself
+            set_transfer(uix::screen_update_mode::partial, buffers[0], buffer_size, count > 1 ? buffers[1] : nullptr);
+            return;
+        }
+        set_transfer(uix::screen_update_mode::partial, buffers[0], buffer_size);
+        for (size_t i = 0; i < count; ++i) {
+            m_transfer_buffers[i] = buffers[i];
+        }
+        m_transfer_buffer_count = count;
+    }
     void initialize() {
+        // a stream of our own over the shared font data, so instances don't
+        // fight over its read position when they render on different threads
+        m_font.set(monoxbold.handle(), font_data_size());
         init_screen();
         init_disconnected_screen();
         m_is_connected = false;
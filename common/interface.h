@@ -2,6 +2,7 @@
 #define INTERFACE_H
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -16,7 +17,12 @@ typedef enum {
     CMD_IDENT,
     CMD_NOP,
     CMD_CLEAR,
-    CMD_REFRESH_SCREEN
+    CMD_REFRESH_SCREEN,
+    CMD_BAUD,
+    CMD_WINDOW,
+    CMD_SUBSCRIBE,
+    CMD_DATA_DELTA,
+    CMD_STATS
 } command_t;
 typedef enum {
     INPUT_NONE = 0,
@@ -39,6 +45,19 @@ typedef struct { // 32 bytes
     response_value_entry_t bottom;
 } response_data_t;
 
+// CMD_DATA_DELTA carries a CMD_DATA as the changes from the last one sent, for
+// devices that set data_delta in their ident. For each slot (top value1,
+// top value2, bottom value1, bottom value2) deltas holds, in order:
+// if bit n of changed is set, the change in value in hundredths, as a zigzag
+// LEB128 varint, then if bit n+4 is set, the scaled value as a little endian
+// uint16_t (0-65535 for 0-1). Slots without their bits set are unchanged.
+// A full CMD_DATA resets what the changes are from. See data_delta.h
+typedef struct { // 2 to 50 bytes on the wire
+    uint8_t changed;
+    uint8_t length; // one byte on the wire, as the deltas never reach 256
+    uint8_t deltas[48];
+} response_data_delta_t;
+
 typedef struct { // 4 bytes on the wire
     uint8_t a;
     uint8_t r;
@@ -81,12 +100,23 @@ typedef struct {
 
 } response_refresh_screen_t;
 
+typedef struct { // 4 bytes on the wire
+    uint32_t baud; // the rate the device switches to once it has acked this
+} response_baud_t;
+
+typedef struct { // 1 byte on the wire
+    uint8_t size; // frames in flight once the device has acked this. see frame_window.h
+} response_window_t;
+
 typedef union {
     response_data_t data;
     response_screen_t screen;
     response_clear_t clear;
     response_ident_t ident;
     response_refresh_screen_t refresh_screen;
+    response_baud_t baud;
+    response_window_t window;
+    response_data_delta_t data_delta;
 } response_t;
 
 typedef struct {
@@ -105,7 +135,12 @@ typedef struct {
     int8_t mode;
 } request_set_mode_t;
 
-typedef struct { // 162 bytes on the wire
+typedef struct { // 3 bytes on the wire
+    int8_t screen_index; // -1 stops the pushes
+    uint16_t interval_ms; // the shortest time between CMD_DATA pushes the device wants
+} request_subscribe_t;
+
+typedef struct { // 168 bytes on the wire
     uint16_t version_major;
     uint16_t version_minor;
     uint64_t build;
@@ -119,7 +154,34 @@ typedef struct { // 162 bytes on the wire
     float dpi;
     float pixel_size; // in millimeters
     input_type_t input_type;
+    uint32_t max_baud; // highest rate CMD_BAUD accepts. 0 if the link can't change rate (USB CDC/JTAG)
+    uint8_t max_window; // most frames in flight CMD_WINDOW accepts. 0 or 1 for stop-and-wait only
+    bool data_delta; // takes CMD_DATA_DELTA
 } request_ident_t;
+
+typedef struct { // 8 bytes on the wire
+    uint32_t retransmits; // frames the device sent again, for a NACK or a missed ACK
+    uint32_t nacks; // NACKs the device sent, for frames lost or corrupted on the way in
+} request_stats_port_t;
+
+// CMD_STATS is sent unasked every few seconds while the link is up. The host
+// doesn't answer it. Counts are since the last one. Heap sizes are as of sending
+typedef struct { // 64 bytes on the wire
+    uint32_t interval_ms; // how long the counts cover
+    uint32_t frames; // frames rendered
+    uint32_t render_min_us;
+    uint32_t render_avg_us;
+    uint32_t render_p99_us;
+    uint32_t flush_bytes; // pixel data handed to the display
+    uint32_t flush_stalls; // times rendering waited on a transfer to finish
+    request_stats_port_t port1; // the UART
+    request_stats_port_t port2; // USB Serial/JTAG, where there is one
+    uint32_t rx_overflows; // times the UART dropped received bytes
+    uint32_t free_heap;
+    uint32_t largest_free_block;
+    uint32_t free_psram; // 0 without PSRAM
+    uint32_t largest_free_psram;
+} request_stats_t;
 #ifdef __cplusplus
 }
 #endif
@@ -45,7 +45,7 @@ $buffersTargetPath = Join-Path $buffersTargetPath "main"
 
 #./nanopb_generator/nanopb_generator.py -I ../common espmon.proto -D ../common
 Write-Host "Generating htcw_buffers code" -ForegroundColor Gray
-& python.exe $buffersGenPath --buffers --out $buffersTargetPath $interfacePath
+& python.exe $buffersGenPath --buffers --lengths --out $buffersTargetPath $interfacePath
 
 # Read boards.json
 $boardsJsonPath = Join-Path $PSScriptRoot "boards.json"
@@ -3,7 +3,7 @@
 buffers_gen_c.py - Parse wire structs from a C header and generate
                    read/write functions for each struct.
 
-Usage: python buffers_gen_c.py [--fixed] [--big-endian] [--prefix <pfx>] [--buffers] [--out <dir>] <header.h>
+Usage: python buffers_gen_c.py [--fixed] [--big-endian] [--lengths] [--prefix <pfx>] [--buffers] [--out <dir>] <header.h>
 
 Options:
   --fixed           Use fixed-size serialization for arrays and strings
@@ -11,6 +11,13 @@ Options:
                    arrays/strings are length-prefixed on the wire.
   --big-endian     Generate struct read/write functions using big-endian
                    serialization. Without this flag, little-endian is used.
+  --lengths        Treat any size_t, uint8_t, uint16_t or uint32_t field that
+                   immediately precedes a fixed array as the runtime element
+                   count for that array. The count is serialized first, as
+                   its own type (size_t as uint32_t), then only that many
+                   array elements follow. Matches --lengths in
+                   buffers_gen_cs12.py. Strings (char[] / wchar_t[]) are
+                   unaffected. Mutually exclusive with --fixed.
   --prefix <pfx>   Prepend <pfx> to every generated function name and
                    per-struct #define (not to the MAX_SIZE define).
   --buffers        Also emit buffers.h / buffers.c support files.
@@ -20,6 +27,9 @@ Outputs:
   <stem>_buffers.h   - declarations for all read/write functions
   <stem>_buffers.c   - implementations
 
+Each struct also gets <struct>_read_span(s, data, length), which decodes
+from a contiguous buffer instead of through a read callback.
+
 Function naming:
   - Typedef names ending in _t have _t stripped
   - struct name precedes _read / _write (no LE/BE suffix)
@@ -302,7 +312,42 @@ TYPEDEF_RE = re.compile(
 )
 
 
-def parse_header(text: str) -> dict:
+# The types a --lengths count may have, and the most elements each can count
+LENGTH_COUNT_MAX = {
+    'size_t':   0xFFFFFFFF,
+    'uint8_t':  0xFF,
+    'uint16_t': 0xFFFF,
+    'uint32_t': 0xFFFFFFFF,
+}
+
+
+def apply_lengths_pairing(structs: dict, struct_name: str) -> None:
+    """When --lengths is in effect, pair each `size_t name; T arr[N];` pattern
+    (or uint8_t/uint16_t/uint32_t name) so the count drives the runtime
+    element count for the array.
+    Strings (char[]/wchar_t[]) keep their existing length-prefix behavior.
+    The count must immediately precede the array, and goes on the wire as
+    its own type.
+    """
+    fields = structs[struct_name]['fields']
+    for i in range(len(fields) - 1):
+        cur = fields[i]
+        nxt = fields[i + 1]
+        if cur['array_len'] is not None or cur['is_enum']:
+            continue
+        if cur['type'] not in LENGTH_COUNT_MAX:
+            continue
+        if nxt['array_len'] is None:
+            continue
+        if nxt['type'] in ('char', 'wchar_t'):
+            continue
+        if nxt['array_len'] > LENGTH_COUNT_MAX[cur['type']]:
+            error(f"Struct '{struct_name}', field '{cur['name']}': {cur['type']} can't count {nxt['array_len']} elements")
+        nxt['length_field'] = cur['name']
+        cur['is_length_for'] = nxt['name']
+
+
+def parse_header(text: str, lengths_mode: bool = False) -> dict:
     text = strip_comments(text)
     text = strip_preprocessor(text)
 
@@ -330,6 +375,10 @@ def parse_header(text: str) -> dict:
             seen.add(f['name'])
         structs[name] = {"fields": fields}
 
+    if lengths_mode:
+        for name in structs:
+            apply_lengths_pairing(structs, name)
+
     return structs
 
 # ---------------------------------------------------------------------------
@@ -453,7 +502,21 @@ def gen_write_fn(prefix, struct_name, fields, all_struct_names, fixed_mode=True,
         lines.append("    int res;")
         lines.append("    int total = 0;")
         for i, f in enumerate(fields):
-            if f['array_len'] is not None:
+            if f.get('is_length_for') is not None:
+                # --lengths count: bounded by its array, its own type on the wire
+                arr_len = next(a['array_len'] for a in fields if a['name'] == f['is_length_for'])
+                lt = f['wire_type']
+                lines.append(f"    if(s->{f['name']} > {arr_len}) {{ return BUFFERS_ERROR_EOF; }}")
+                lines.append(f"    res = buffers_write_{lt}{endian_suffix_for_type(lt, endian_suffix)}(({lt})s->{f['name']}, on_write, on_write_state);")
+                lines.append("    if(res < 0) { return res; }")
+                lines.append("    total += res;")
+            elif f.get('length_field') is not None:
+                # --lengths array: only the counted elements
+                lines.append(f"    for(int i = 0; i < (int)s->{f['length_field']}; ++i) {{")
+                stmts = gen_write_call(prefix, f, f"s->{f['name']}[i]", all_struct_names, indent="        ", endian_suffix=endian_suffix)
+                lines.extend(stmts)
+                lines.append("    }")
+            elif f['array_len'] is not None:
                 is_string = _field_is_string(f)
                 if fixed_mode or not is_string:
                     # Fixed mode, or non-string array in variable mode:
@@ -503,7 +566,19 @@ def gen_size_fn(prefix, struct_name, fields, all_struct_names):
         return "\n".join(lines)
     lines.append("    size_t size = 0;")
     for f in fields:
-        if f['array_len'] is not None:
+        if f.get('is_length_for') is not None:
+            lines.append(f"    size += {WIRE_TYPE_SIZES[f['wire_type']]};")
+        elif f.get('length_field') is not None:
+            wt = f['wire_type']
+            if wt in all_struct_names:
+                nested_size_fn = size_fn_name(prefix, wt)
+                lines.append(f"    for(int i = 0; i < (int)s->{f['length_field']}; ++i) {{")
+                lines.append(f"        size += {nested_size_fn}(&s->{f['name']}[i]);")
+                lines.append(f"    }}")
+            else:
+                elem_sz = WIRE_TYPE_SIZES.get(wt, 0)
+                lines.append(f"    size += s->{f['length_field']} * {elem_sz};")
+        elif f['array_len'] is not None:
             is_string = _field_is_string(f)
             wt = f['wire_type']
 
@@ -570,7 +645,23 @@ def gen_read_fn(prefix, struct_name, fields, all_struct_names, fixed_mode=True,
         lines.append("    int res;")
         lines.append("    int bytes_read = 0;")
         for i, f in enumerate(fields):
-            if f['array_len'] is not None:
+            if f.get('is_length_for') is not None:
+                arr_len = next(a['array_len'] for a in fields if a['name'] == f['is_length_for'])
+                lt = f['wire_type']
+                lines.append(f"    {{")
+                lines.append(f"        {lt} _len_{f['name']};")
+                lines.append(f"        res = buffers_read_{lt}{endian_suffix_for_type(lt, endian_suffix)}(&_len_{f['name']}, on_read, on_read_state, &bytes_read);")
+                lines.append(f"        if(res < 0) {{ return res; }}")
+                lines.append(f"        if(_len_{f['name']} > {arr_len}) {{ return BUFFERS_ERROR_EOF; }}")
+                cast = f"({f['type']})" if f['type'] != lt else ""
+                lines.append(f"        s->{f['name']} = {cast}_len_{f['name']};")
+                lines.append(f"    }}")
+            elif f.get('length_field') is not None:
+                lines.append(f"    for(int i = 0; i < (int)s->{f['length_field']}; ++i) {{")
+                stmts = gen_read_call(prefix, f, f"s->{f['name']}[i]", all_struct_names, indent="        ", endian_suffix=endian_suffix)
+                lines.extend(stmts)
+                lines.append("    }")
+            elif f['array_len'] is not None:
                 is_string = _field_is_string(f)
                 if fixed_mode or not is_string:
                     # Fixed mode, or non-string array in variable mode:
@@ -607,6 +698,234 @@ def gen_read_fn(prefix, struct_name, fields, all_struct_names, fixed_mode=True,
 
 
 
+# ---------------------------------------------------------------------------
+# Span decoding
+#
+# <struct>_read_span() decodes straight from a contiguous buffer instead of
+# pulling each byte through a callback. Consecutive fixed size fields are
+# bounds checked together, so a struct with no strings or counted arrays is
+# checked once. Structs like that also get an unchecked static _load() that
+# nested fields and array elements use once their caller has checked.
+# ---------------------------------------------------------------------------
+
+
+def read_span_fn_name(user_prefix, struct_name):
+    return f"{user_prefix}{type_fn_suffix(struct_name)}_read_span"
+
+
+def load_fn_name(user_prefix, struct_name):
+    return f"{user_prefix}{type_fn_suffix(struct_name)}_load"
+
+
+def struct_is_fixed(struct_name, structs, fixed_mode):
+    """True if every instance of the struct has the same wire size."""
+    for f in structs[struct_name]['fields']:
+        if f.get('length_field') is not None:
+            return False
+        if _field_is_string(f) and not fixed_mode:
+            return False
+        if f['wire_type'] in structs and not struct_is_fixed(f['wire_type'], structs, fixed_mode):
+            return False
+    return True
+
+
+def span_plus(lhs, rhs):
+    """lhs + rhs, leaving out a zero."""
+    if rhs == 0:
+        return lhs
+    if lhs == 0:
+        return rhs
+    return f"{lhs} + {rhs}"
+
+
+def span_times(count, size):
+    """count * size, leaving out a size of one."""
+    return count if size == 1 else f"{count} * {size}"
+
+
+def span_load_expr(f, off, endian_suffix):
+    """A C expression that loads a single element of field f at p[off]."""
+    t = f['type']
+    wt = f['wire_type']
+    if t == 'bool':
+        return f"(p[{off}] ? 1 : 0)"
+    if wt in SINGLE_BYTE_WIRE_TYPES:
+        expr = f"p[{off}]" if wt == 'uint8_t' else f"(int8_t)p[{off}]"
+    else:
+        sfx = endian_suffix_for_type(wt, endian_suffix)
+        expr = f"buffers_load_{wt}{sfx}({span_plus('p', off)})"
+    if t != wt:
+        expr = f"({t}){expr}"
+    return expr
+
+
+def span_element_size(f, structs, fixed_mode):
+    wt = f['wire_type']
+    if wt in structs:
+        return struct_wire_size(wt, structs, fixed_mode=fixed_mode)
+    return WIRE_TYPE_SIZES[wt]
+
+
+def gen_span_fixed_field(prefix, f, structs, off, indent, fixed_mode, endian_suffix):
+    """Loads a fixed size field at p[off]. Returns (lines, wire size)."""
+    lines = []
+    wt = f['wire_type']
+    name = f['name']
+    esz = span_element_size(f, structs, fixed_mode)
+    if f['array_len'] is None:
+        if wt in structs:
+            lines.append(f"{indent}{load_fn_name(prefix, wt)}(&s->{name}, {span_plus('p', off)});")
+        else:
+            lines.append(f"{indent}s->{name} = {span_load_expr(f, off, endian_suffix)};")
+        return lines, esz
+    n = f['array_len']
+    elem = span_plus(off, span_times('i', esz))
+    if wt in structs:
+        lines.append(f"{indent}for(int i = 0; i < {n}; ++i) {{")
+        lines.append(f"{indent}    {load_fn_name(prefix, wt)}(&s->{name}[i], p + {elem});")
+        lines.append(f"{indent}}}")
+    elif wt in SINGLE_BYTE_WIRE_TYPES and f['type'] != 'bool':
+        lines.append(f"{indent}memcpy(s->{name}, {span_plus('p', off)}, {n});")
+    else:
+        lines.append(f"{indent}for(int i = 0; i < {n}; ++i) {{")
+        lines.append(f"{indent}    s->{name}[i] = {span_load_expr(f, elem, endian_suffix)};")
+        lines.append(f"{indent}}}")
+    return lines, esz * n
+
+
+def gen_load_fn(prefix, struct_name, structs, fixed_mode, endian_suffix):
+    fn = load_fn_name(prefix, struct_name)
+    fields = structs[struct_name]['fields']
+    lines = [f"static void {fn}({struct_name}* s, const uint8_t* p) {{"]
+    off = 0
+    for f in fields:
+        stmts, size = gen_span_fixed_field(prefix, f, structs, off, "    ", fixed_mode, endian_suffix)
+        lines.extend(stmts)
+        off += size
+    lines.append("}")
+    return "\n".join(lines)
+
+
+def gen_read_span_fn(prefix, struct_name, structs, fixed_mode, endian_suffix):
+    fn = read_span_fn_name(prefix, struct_name)
+    fields = structs[struct_name]['fields']
+    lines = [f"int {fn}({struct_name}* s, const void* data, size_t length) {{"]
+    if struct_is_fixed(struct_name, structs, fixed_mode):
+        size = struct_wire_size(struct_name, structs, fixed_mode=fixed_mode)
+        if size == 0:
+            lines.append("    (void)s; (void)data; (void)length;")
+            lines.append("    return 0;")
+        else:
+            lines.append(f"    if(length < {size}) {{ return BUFFERS_ERROR_EOF; }}")
+            lines.append(f"    {load_fn_name(prefix, struct_name)}(s, (const uint8_t*)data);")
+            lines.append(f"    return {size};")
+        lines.append("}")
+        return "\n".join(lines)
+
+    lines.append("    const uint8_t* p = (const uint8_t*)data;")
+    lines.append("    size_t pos = 0;")
+    for f in fields:
+        if _field_is_string(f) or f.get('length_field') is not None:
+            lines.append(f"    size_t _len_{f['name']};")
+    if any(f['wire_type'] in structs and not struct_is_fixed(f['wire_type'], structs, fixed_mode) for f in fields):
+        lines.append("    int res;")
+
+    # a run of fixed size fields, checked together
+    run = []
+    run_size = [0]
+
+    def flush_run():
+        if not run:
+            return
+        lines.append(f"    if(length - pos < {run_size[0]}) {{ return BUFFERS_ERROR_EOF; }}")
+        lines.extend(run)
+        lines.append(f"    pos += {run_size[0]};")
+        run.clear()
+        run_size[0] = 0
+
+    for f in fields:
+        wt = f['wire_type']
+        name = f['name']
+        if f.get('is_length_for') is not None:
+            # the count of the array that follows
+            arr = f['is_length_for']
+            run.append(f"    _len_{arr} = {span_load_expr(dict(f, type=wt), span_plus('pos', run_size[0]), endian_suffix)};")
+            run.append(f"    s->{name} = _len_{arr};")
+            run_size[0] += WIRE_TYPE_SIZES[wt]
+            continue
+        if f.get('length_field') is not None:
+            flush_run()
+            n = f['array_len']
+            esz = span_element_size(f, structs, fixed_mode)
+            lines.append(f"    if(_len_{name} > {n}) {{ return BUFFERS_ERROR_EOF; }}")
+            if wt in structs and not struct_is_fixed(wt, structs, fixed_mode):
+                lines.append(f"    for(size_t i = 0; i < _len_{name}; ++i) {{")
+                lines.append(f"        res = {read_span_fn_name(prefix, wt)}(&s->{name}[i], p + pos, length - pos);")
+                lines.append(f"        if(res < 0) {{ return res; }}")
+                lines.append(f"        pos += res;")
+                lines.append(f"    }}")
+                continue
+            lines.append(f"    if(length - pos < {span_times('_len_' + name, esz)}) {{ return BUFFERS_ERROR_EOF; }}")
+            elem = f"pos + {span_times('i', esz)}"
+            if wt in structs:
+                lines.append(f"    for(size_t i = 0; i < _len_{name}; ++i) {{")
+                lines.append(f"        {load_fn_name(prefix, wt)}(&s->{name}[i], p + {elem});")
+                lines.append(f"    }}")
+            elif wt in SINGLE_BYTE_WIRE_TYPES and f['type'] != 'bool':
+                lines.append(f"    memcpy(s->{name}, p + pos, _len_{name});")
+            else:
+                lines.append(f"    for(size_t i = 0; i < _len_{name}; ++i) {{")
+                lines.append(f"        s->{name}[i] = {span_load_expr(f, elem, endian_suffix)};")
+                lines.append(f"    }}")
+            lines.append(f"    pos += {span_times('_len_' + name, esz)};")
+            continue
+        if _field_is_string(f) and not fixed_mode:
+            # the length prefix goes in the run. the characters don't
+            n = f['array_len']
+            lp = length_prefix_type(n)
+            at = span_plus('pos', run_size[0])
+            if lp == 'uint8_t':
+                run.append(f"    _len_{name} = p[{at}];")
+            else:
+                run.append(f"    _len_{name} = buffers_load_{lp}{endian_suffix_for_type(lp, endian_suffix)}(p + {at});")
+            run_size[0] += WIRE_TYPE_SIZES[lp]
+            flush_run()
+            esz = WIRE_TYPE_SIZES[wt]
+            lines.append(f"    if(_len_{name} > {n} || length - pos < {span_times('_len_' + name, esz)}) {{ return BUFFERS_ERROR_EOF; }}")
+            if f['type'] == 'char':
+                lines.append(f"    memcpy(s->{name}, p + pos, _len_{name});")
+            else:
+                lines.append(f"    for(size_t i = 0; i < _len_{name}; ++i) {{")
+                lines.append(f"        s->{name}[i] = {span_load_expr(f, 'pos + ' + span_times('i', esz), endian_suffix)};")
+                lines.append(f"    }}")
+            null_lit = "L'\\0'" if f['type'] == 'wchar_t' else "'\\0'"
+            lines.append(f"    if(_len_{name} < {n}) {{")
+            lines.append(f"        s->{name}[_len_{name}] = {null_lit};")
+            lines.append(f"    }}")
+            lines.append(f"    pos += {span_times('_len_' + name, esz)};")
+            continue
+        if wt in structs and not struct_is_fixed(wt, structs, fixed_mode):
+            flush_run()
+            count = f['array_len']
+            target = f"&s->{name}[i]" if count is not None else f"&s->{name}"
+            ind = "    "
+            if count is not None:
+                lines.append(f"    for(int i = 0; i < {count}; ++i) {{")
+                ind = "        "
+            lines.append(f"{ind}res = {read_span_fn_name(prefix, wt)}({target}, p + pos, length - pos);")
+            lines.append(f"{ind}if(res < 0) {{ return res; }}")
+            lines.append(f"{ind}pos += res;")
+            if count is not None:
+                lines.append("    }")
+            continue
+        stmts, size = gen_span_fixed_field(prefix, f, structs, span_plus('pos', run_size[0]), "    ", fixed_mode, endian_suffix)
+        run.extend(stmts)
+        run_size[0] += size
+    flush_run()
+    lines.append("    return (int)pos;")
+    lines.append("}")
+    return "\n".join(lines)
+
 
 def generate_h(header_path, user_prefix, structs, fixed_mode=True):
     stem = os.path.splitext(os.path.basename(header_path))[0]
@@ -635,6 +954,7 @@ def generate_h(header_path, user_prefix, structs, fixed_mode=True):
     for struct_name in structs:
         lines.append(f"int {read_fn_name(user_prefix, struct_name)}({struct_name}* s, buffers_read_callback_t on_read, void* on_read_state);")
         lines.append(f"int {write_fn_name(user_prefix, struct_name)}(const {struct_name}* s, buffers_write_callback_t on_write, void* on_write_state);")
+        lines.append(f"int {read_span_fn_name(user_prefix, struct_name)}({struct_name}* s, const void* data, size_t length);")
         if not fixed_mode:
             lines.append(f"size_t {size_fn_name(user_prefix, struct_name)}(const {struct_name}* s);")
         lines.append("")
@@ -670,6 +990,11 @@ def generate_c(header_path, user_prefix, structs, fixed_mode=True, endian_suffix
         if not fixed_mode:
             lines.append(gen_size_fn(user_prefix, struct_name, info['fields'], all_struct_names))
             lines.append("")
+        if info['fields'] and struct_is_fixed(struct_name, structs, fixed_mode):
+            lines.append(gen_load_fn(user_prefix, struct_name, structs, fixed_mode, endian_suffix))
+            lines.append("")
+        lines.append(gen_read_span_fn(user_prefix, struct_name, structs, fixed_mode, endian_suffix))
+        lines.append("")
     return "\n".join(lines)
 
 
@@ -782,6 +1107,40 @@ int buffers_write_int64_t_be (int64_t  value, buffers_write_callback_t cb, void*
 int buffers_write_float_be   (float    value, buffers_write_callback_t cb, void* state);
 int buffers_write_double_be  (double   value, buffers_write_callback_t cb, void* state);
 
+/* -------------------------------------------------------------------------
+ * Loads from a buffer the caller has already bounds checked, for the
+ * generated _read_span functions. Assembled from bytes, so they work at any
+ * alignment (Xtensa faults on unaligned loads). Where unaligned loads are
+ * fine the compiler folds them into one.
+ * ------------------------------------------------------------------------- */
+static inline uint16_t buffers_load_uint16_t_le(const uint8_t* p) {
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8)); }
+static inline uint32_t buffers_load_uint32_t_le(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+static inline uint64_t buffers_load_uint64_t_le(const uint8_t* p) {
+    return (uint64_t)buffers_load_uint32_t_le(p) | ((uint64_t)buffers_load_uint32_t_le(p + 4) << 32); }
+static inline int16_t buffers_load_int16_t_le(const uint8_t* p) { return (int16_t)buffers_load_uint16_t_le(p); }
+static inline int32_t buffers_load_int32_t_le(const uint8_t* p) { return (int32_t)buffers_load_uint32_t_le(p); }
+static inline int64_t buffers_load_int64_t_le(const uint8_t* p) { return (int64_t)buffers_load_uint64_t_le(p); }
+static inline float buffers_load_float_le(const uint8_t* p) {
+    uint32_t tmp = buffers_load_uint32_t_le(p); float result; memcpy(&result, &tmp, sizeof(result)); return result; }
+static inline double buffers_load_double_le(const uint8_t* p) {
+    uint64_t tmp = buffers_load_uint64_t_le(p); double result; memcpy(&result, &tmp, sizeof(result)); return result; }
+
+static inline uint16_t buffers_load_uint16_t_be(const uint8_t* p) {
+    return (uint16_t)(((uint16_t)p[0] << 8) | p[1]); }
+static inline uint32_t buffers_load_uint32_t_be(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3]; }
+static inline uint64_t buffers_load_uint64_t_be(const uint8_t* p) {
+    return ((uint64_t)buffers_load_uint32_t_be(p) << 32) | (uint64_t)buffers_load_uint32_t_be(p + 4); }
+static inline int16_t buffers_load_int16_t_be(const uint8_t* p) { return (int16_t)buffers_load_uint16_t_be(p); }
+static inline int32_t buffers_load_int32_t_be(const uint8_t* p) { return (int32_t)buffers_load_uint32_t_be(p); }
+static inline int64_t buffers_load_int64_t_be(const uint8_t* p) { return (int64_t)buffers_load_uint64_t_be(p); }
+static inline float buffers_load_float_be(const uint8_t* p) {
+    uint32_t tmp = buffers_load_uint32_t_be(p); float result; memcpy(&result, &tmp, sizeof(result)); return result; }
+static inline double buffers_load_double_be(const uint8_t* p) {
+    uint64_t tmp = buffers_load_uint64_t_be(p); double result; memcpy(&result, &tmp, sizeof(result)); return result; }
+
 #ifdef __cplusplus
 }
 #endif
@@ -1106,6 +1465,7 @@ def main():
     user_prefix = ""
     fixed_mode = False  # Default: variable-length (length-prefixed) serialization
     big_endian = False
+    lengths_mode = False
     while args and args[0].startswith('--'):
         opt = args.pop(0)
         if opt == '--buffers':
@@ -1122,12 +1482,16 @@ def main():
             fixed_mode = True
         elif opt == '--big-endian':
             big_endian = True
+        elif opt == '--lengths':
+            lengths_mode = True
         else:
             error(f"Unknown option: {opt}")
 
     if len(args) != 1:
-        print(f"Usage: {sys.argv[0]} [--fixed] [--big-endian] [--buffers] [--out <dir>] [--prefix <pfx>] <header.h>", file=sys.stderr)
+        print(f"Usage: {sys.argv[0]} [--fixed] [--big-endian] [--lengths] [--buffers] [--out <dir>] [--prefix <pfx>] <header.h>", file=sys.stderr)
         sys.exit(1)
+    if lengths_mode and fixed_mode:
+        error("--lengths and --fixed are mutually exclusive")
 
     endian_suffix = "_be" if big_endian else "_le"
 
@@ -1138,7 +1502,7 @@ def main():
     except OSError as e:
         error(f"Cannot open file: {e}")
 
-    structs = parse_header(text)
+    structs = parse_header(text, lengths_mode=lengths_mode)
     if not structs:
         error("No structs found in header")
 
@@ -103,6 +103,40 @@ int buffers_write_int64_t_be (int64_t  value, buffers_write_callback_t cb, void*
 int buffers_write_float_be   (float    value, buffers_write_callback_t cb, void* state);
 int buffers_write_double_be  (double   value, buffers_write_callback_t cb, void* state);
 
+/* -------------------------------------------------------------------------
+ * Loads from a buffer the caller has already bounds checked, for the
+ * generated _read_span functions. Assembled from bytes, so they work at any
+ * alignment (Xtensa faults on unaligned loads). Where unaligned loads are
+ * fine the compiler folds them into one.
+ * ------------------------------------------------------------------------- */
+static inline uint16_t buffers_load_uint16_t_le(const uint8_t* p) {
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8)); }
+static inline uint32_t buffers_load_uint32_t_le(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+static inline uint64_t buffers_load_uint64_t_le(const uint8_t* p) {
+    return (uint64_t)buffers_load_uint32_t_le(p) | ((uint64_t)buffers_load_uint32_t_le(p + 4) << 32); }
+static inline int16_t buffers_load_int16_t_le(const uint8_t* p) { return (int16_t)buffers_load_uint16_t_le(p); }
+static inline int32_t buffers_load_int32_t_le(const uint8_t* p) { return (int32_t)buffers_load_uint32_t_le(p); }
+static inline int64_t buffers_load_int64_t_le(const uint8_t* p) { return (int64_t)buffers_load_uint64_t_le(p); }
+static inline float buffers_load_float_le(const uint8_t* p) {
+    uint32_t tmp = buffers_load_uint32_t_le(p); float result; memcpy(&result, &tmp, sizeof(result)); return result; }
+static inline double buffers_load_double_le(const uint8_t* p) {
+    uint64_t tmp = buffers_load_uint64_t_le(p); double result; memcpy(&result, &tmp, sizeof(result)); return result; }
+
+static inline uint16_t buffers_load_uint16_t_be(const uint8_t* p) {
+    return (uint16_t)(((uint16_t)p[0] << 8) | p[1]); }
+static inline uint32_t buffers_load_uint32_t_be(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3]; }
+static inline uint64_t buffers_load_uint64_t_be(const uint8_t* p) {
+    return ((uint64_t)buffers_load_uint32_t_be(p) << 32) | (uint64_t)buffers_load_uint32_t_be(p + 4); }
+static inline int16_t buffers_load_int16_t_be(const uint8_t* p) { return (int16_t)buffers_load_uint16_t_be(p); }
+static inline int32_t buffers_load_int32_t_be(const uint8_t* p) { return (int32_t)buffers_load_uint32_t_be(p); }
+static inline int64_t buffers_load_int64_t_be(const uint8_t* p) { return (int64_t)buffers_load_uint64_t_be(p); }
+static inline float buffers_load_float_be(const uint8_t* p) {
+    uint32_t tmp = buffers_load_uint32_t_be(p); float result; memcpy(&result, &tmp, sizeof(result)); return result; }
+static inline double buffers_load_double_be(const uint8_t* p) {
+    uint64_t tmp = buffers_load_uint64_t_be(p); double result; memcpy(&result, &tmp, sizeof(result)); return result; }
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,93 @@
+#include "data_delta.h"
+#include <math.h>
+#include <string.h>
+
+static int64_t quantize_value(float value) {
+    if (isnan(value)) {
+        return DATA_DELTA_NAN;
+    }
+    const double d = (double)value * 100.0;
+    if (d >= (double)DATA_DELTA_LIMIT) {
+        return DATA_DELTA_LIMIT;
+    }
+    if (d <= -(double)DATA_DELTA_LIMIT) {
+        return -DATA_DELTA_LIMIT;
+    }
+    return llround(d);
+}
+static uint16_t quantize_scaled(float scaled) {
+    if (isnan(scaled) || scaled <= 0.f) {
+        return 0;
+    }
+    if (scaled >= 1.f) {
+        return 65535;
+    }
+    return (uint16_t)lround((double)scaled * 65535.0);
+}
+static bool read_varint(const uint8_t* data, size_t length, size_t* pos, uint64_t* out_value) {
+    uint64_t value = 0;
+    int shift = 0;
+    while (*pos < length) {
+        const uint8_t b = data[(*pos)++];
+        if (shift > 63) {
+            return false;
+        }
+        value |= ((uint64_t)(b & 0x7F)) << shift;
+        if (!(b & 0x80)) {
+            *out_value = value;
+            return true;
+        }
+        shift += 7;
+    }
+    return false;
+}
+void data_delta_init(data_delta_t* dd) {
+    memset(dd, 0, sizeof(*dd));
+}
+void data_delta_key(data_delta_t* dd, const response_data_t* data) {
+    const response_value_t* s[DATA_DELTA_SLOTS] = {&data->top.value1, &data->top.value2, &data->bottom.value1, &data->bottom.value2};
+    for (int i = 0; i < DATA_DELTA_SLOTS; ++i) {
+        dd->value[i] = quantize_value(s[i]->value);
+        dd->scaled[i] = quantize_scaled(s[i]->scaled);
+    }
+    dd->valid = true;
+}
+bool data_delta_apply(data_delta_t* dd, const response_data_delta_t* delta, response_data_t* out_data) {
+    if (!dd->valid || delta->length > sizeof(delta->deltas)) {
+        return false;
+    }
+    // decode it all before touching the baseline, so a bad frame leaves it alone
+    int64_t value[DATA_DELTA_SLOTS];
+    uint16_t scaled[DATA_DELTA_SLOTS];
+    memcpy(value, dd->value, sizeof(value));
+    memcpy(scaled, dd->scaled, sizeof(scaled));
+    size_t pos = 0;
+    for (int i = 0; i < DATA_DELTA_SLOTS; ++i) {
+        if (delta->changed & (1 << i)) {
+            uint64_t zz;
+            if (!read_varint(delta->deltas, delta->length, &pos, &zz)) {
+                return false;
+            }
+            // unsigned, so the step to or from NaN wraps instead of overflowing
+            value[i] = (int64_t)((uint64_t)value[i] + (uint64_t)((zz >> 1) ^ (0 - (zz & 1))));
+        }
+        if (delta->changed & (1 << (i + 4))) {
+            if (pos + 2 > delta->length) {
+                return false;
+            }
+            scaled[i] = (uint16_t)(delta->deltas[pos] | (delta->deltas[pos + 1] << 8));
+            pos += 2;
+        }
+    }
+    if (pos != delta->length) {
+        return false;
+    }
+    memcpy(dd->value, value, sizeof(value));
+    memcpy(dd->scaled, scaled, sizeof(scaled));
+    response_value_t* s[DATA_DELTA_SLOTS] = {&out_data->top.value1, &out_data->top.value2, &out_data->bottom.value1, &out_data->bottom.value2};
+    for (int i = 0; i < DATA_DELTA_SLOTS; ++i) {
+        s[i]->value = value[i] == DATA_DELTA_NAN ? NAN : (float)((double)value[i] / 100.0);
+        s[i]->scaled = scaled[i] / 65535.f;
+    }
+    return true;
+}
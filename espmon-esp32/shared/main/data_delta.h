@@ -0,0 +1,37 @@
+#ifndef DATA_DELTA_H
+#define DATA_DELTA_H
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "interface.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+// Rebuilds CMD_DATA from CMD_DATA_DELTA (the encoding is in interface.h).
+// Values travel in hundredths, which is all format_float() shows, and scaled
+// values as 0-65535, finer than the graph's 0-255 and any bar's width.
+// The host quantizes the same way (LocalSessionController), so both ends
+// hold the same numbers and the changes never drift
+#define DATA_DELTA_SLOTS 4
+// the hundredths that stand for NaN
+#define DATA_DELTA_NAN INT64_MIN
+// values past this many hundredths are clamped to it
+#define DATA_DELTA_LIMIT INT64_C(4000000000000000000)
+
+typedef struct {
+    int64_t value[DATA_DELTA_SLOTS];
+    uint16_t scaled[DATA_DELTA_SLOTS];
+    // a full CMD_DATA has come in since startup
+    bool valid;
+} data_delta_t;
+
+void data_delta_init(data_delta_t* dd);
+// makes a full CMD_DATA what the next changes are from
+void data_delta_key(data_delta_t* dd, const response_data_t* data);
+// applies a CMD_DATA_DELTA and writes the CMD_DATA it stands for.
+// false if it's malformed or no full CMD_DATA has come in yet
+bool data_delta_apply(data_delta_t* dd, const response_data_delta_t* delta, response_data_t* out_data);
+#ifdef __cplusplus
+}
+#endif
+#endif // DATA_DELTA_H
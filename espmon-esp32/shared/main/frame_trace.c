@@ -0,0 +1,177 @@
+#include "frame_trace.h"
+
+static const uint8_t frame_trace_magic[4] = {'E', 'M', 'T', 'R'};
+
+static int write_varint(uint64_t value, buffers_write_callback_t on_write, void* on_write_state) {
+    int total = 0;
+    do {
+        uint8_t b = value & 0x7F;
+        value >>= 7;
+        if (value) {
+            b |= 0x80;
+        }
+        int res = on_write(b, on_write_state);
+        if (res < 0) {
+            return res;
+        }
+        ++total;
+    } while (value);
+    return total;
+}
+
+static int read_varint(uint64_t* result, buffers_read_callback_t on_read, void* on_read_state, int* bytes_read) {
+    uint64_t value = 0;
+    int shift = 0;
+    while (1) {
+        int b = on_read(on_read_state);
+        if (b < 0) {
+            return BUFFERS_ERROR_EOF;
+        }
+        ++*bytes_read;
+        if (shift > 63) {
+            return FRAME_TRACE_ERROR_FORMAT;
+        }
+        value |= ((uint64_t)(b & 0x7F)) << shift;
+        if (!(b & 0x80)) {
+            break;
+        }
+        shift += 7;
+    }
+    *result = value;
+    return 0;
+}
+
+int frame_trace_writer_init(frame_trace_writer_t* writer, buffers_write_callback_t on_write, void* on_write_state) {
+    writer->on_write = on_write;
+    writer->on_write_state = on_write_state;
+    writer->last_us = 0;
+    int total = 0;
+    for (size_t i = 0; i < sizeof(frame_trace_magic); ++i) {
+        int res = buffers_write_uint8_t(frame_trace_magic[i], on_write, on_write_state);
+        if (res < 0) {
+            return res;
+        }
+        total += res;
+    }
+    int res = buffers_write_uint8_t(FRAME_TRACE_VERSION, on_write, on_write_state);
+    if (res < 0) {
+        return res;
+    }
+    total += res;
+    for (int i = 0; i < 3; ++i) {
+        res = buffers_write_uint8_t(0, on_write, on_write_state);
+        if (res < 0) {
+            return res;
+        }
+        total += res;
+    }
+    return total;
+}
+
+int frame_trace_write(frame_trace_writer_t* writer, uint64_t timestamp_us, frame_trace_dir_t dir, uint8_t cmd, uint8_t seq, const void* payload, size_t length) {
+    // a clock that went backward records as no gap
+    uint64_t delta = timestamp_us >= writer->last_us ? timestamp_us - writer->last_us : 0;
+    writer->last_us = timestamp_us;
+    int total = 0;
+    int res = write_varint(delta, writer->on_write, writer->on_write_state);
+    if (res < 0) {
+        return res;
+    }
+    total += res;
+    res = buffers_write_uint8_t((uint8_t)((dir << 7) | (cmd & 0x7F)), writer->on_write, writer->on_write_state);
+    if (res < 0) {
+        return res;
+    }
+    total += res;
+    res = buffers_write_uint8_t(seq, writer->on_write, writer->on_write_state);
+    if (res < 0) {
+        return res;
+    }
+    total += res;
+    res = write_varint(length, writer->on_write, writer->on_write_state);
+    if (res < 0) {
+        return res;
+    }
+    total += res;
+    const uint8_t* p = (const uint8_t*)payload;
+    for (size_t i = 0; i < length; ++i) {
+        res = writer->on_write(p[i], writer->on_write_state);
+        if (res < 0) {
+            return res;
+        }
+        ++total;
+    }
+    return total;
+}
+
+int frame_trace_reader_init(frame_trace_reader_t* reader, buffers_read_callback_t on_read, void* on_read_state) {
+    reader->on_read = on_read;
+    reader->on_read_state = on_read_state;
+    reader->last_us = 0;
+    uint8_t header[FRAME_TRACE_HEADER_SIZE];
+    for (size_t i = 0; i < sizeof(header); ++i) {
+        int b = on_read(on_read_state);
+        if (b < 0) {
+            return BUFFERS_ERROR_EOF;
+        }
+        header[i] = (uint8_t)b;
+    }
+    if (0 != memcmp(header, frame_trace_magic, sizeof(frame_trace_magic)) || header[4] != FRAME_TRACE_VERSION) {
+        return FRAME_TRACE_ERROR_FORMAT;
+    }
+    return FRAME_TRACE_HEADER_SIZE;
+}
+
+int frame_trace_read(frame_trace_reader_t* reader, frame_trace_record_t* out_record, uint8_t* payload_buffer, size_t payload_buffer_size) {
+    int bytes_read = 0;
+    uint64_t delta;
+    int b = reader->on_read(reader->on_read_state);
+    if (b < 0) {
+        // clean end of the trace
+        return 0;
+    }
+    ++bytes_read;
+    // first varint byte already read
+    delta = b & 0x7F;
+    if (b & 0x80) {
+        uint64_t rest;
+        int res = read_varint(&rest, reader->on_read, reader->on_read_state, &bytes_read);
+        if (res < 0) {
+            return res;
+        }
+        delta |= rest << 7;
+    }
+    uint8_t kind, seq;
+    int res = buffers_read_uint8_t(&kind, reader->on_read, reader->on_read_state, &bytes_read);
+    if (res < 0) {
+        return res;
+    }
+    res = buffers_read_uint8_t(&seq, reader->on_read, reader->on_read_state, &bytes_read);
+    if (res < 0) {
+        return res;
+    }
+    uint64_t length;
+    res = read_varint(&length, reader->on_read, reader->on_read_state, &bytes_read);
+    if (res < 0) {
+        return res;
+    }
+    if (length > payload_buffer_size) {
+        return FRAME_TRACE_ERROR_TOO_BIG;
+    }
+    for (size_t i = 0; i < (size_t)length; ++i) {
+        int v = reader->on_read(reader->on_read_state);
+        if (v < 0) {
+            return BUFFERS_ERROR_EOF;
+        }
+        payload_buffer[i] = (uint8_t)v;
+        ++bytes_read;
+    }
+    reader->last_us += delta;
+    out_record->timestamp_us = reader->last_us;
+    out_record->dir = (frame_trace_dir_t)(kind >> 7);
+    out_record->cmd = kind & 0x7F;
+    out_record->seq = seq;
+    out_record->length = (size_t)length;
+    out_record->payload = payload_buffer;
+    return bytes_read;
+}
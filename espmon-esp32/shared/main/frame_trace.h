@@ -0,0 +1,63 @@
+#ifndef FRAME_TRACE_H
+#define FRAME_TRACE_H
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "buffers.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+// Binary trace of the frames that crossed the link, for offline replay.
+// All multibyte fields are little endian. Varints are LEB128.
+// header: 'E' 'M' 'T' 'R', uint8 version, 3 reserved bytes (0)
+// record: varint microseconds since the previous record (or since boot),
+//         uint8 (direction<<7)|cmd, uint8 seq, varint payload length, payload
+#define FRAME_TRACE_VERSION 1
+#define FRAME_TRACE_HEADER_SIZE 8
+// largest record framing: two 64-bit varints plus the cmd and seq bytes
+#define FRAME_TRACE_RECORD_OVERHEAD 22
+
+enum {
+    FRAME_TRACE_ERROR_FORMAT = -3,
+    FRAME_TRACE_ERROR_TOO_BIG = -4
+};
+
+typedef enum {
+    FRAME_TRACE_IN = 0,  // received by the device
+    FRAME_TRACE_OUT = 1  // sent by the device
+} frame_trace_dir_t;
+
+typedef struct {
+    uint64_t timestamp_us;
+    frame_trace_dir_t dir;
+    uint8_t cmd;
+    uint8_t seq;
+    size_t length;
+    const uint8_t* payload;
+} frame_trace_record_t;
+
+typedef struct {
+    buffers_write_callback_t on_write;
+    void* on_write_state;
+    uint64_t last_us;
+} frame_trace_writer_t;
+
+typedef struct {
+    buffers_read_callback_t on_read;
+    void* on_read_state;
+    uint64_t last_us;
+} frame_trace_reader_t;
+
+// writes the header. returns the bytes written, or < 0 on error
+int frame_trace_writer_init(frame_trace_writer_t* writer, buffers_write_callback_t on_write, void* on_write_state);
+// writes one record. returns the bytes written, or < 0 on error
+int frame_trace_write(frame_trace_writer_t* writer, uint64_t timestamp_us, frame_trace_dir_t dir, uint8_t cmd, uint8_t seq, const void* payload, size_t length);
+// reads and validates the header. returns the bytes read, or < 0 on error
+int frame_trace_reader_init(frame_trace_reader_t* reader, buffers_read_callback_t on_read, void* on_read_state);
+// reads one record. The payload is copied into payload_buffer.
+// returns the bytes read, 0 at the end of the trace, or < 0 on error
+int frame_trace_read(frame_trace_reader_t* reader, frame_trace_record_t* out_record, uint8_t* payload_buffer, size_t payload_buffer_size);
+#ifdef __cplusplus
+}
+#endif
+#endif // FRAME_TRACE_H
@@ -0,0 +1,269 @@
+#include "frame_window.h"
+#include <string.h>
+
+#define SEQ_MASK 0x3F
+#define TYPE_SHIFT 6
+#define CONTROL_MARKER 128
+
+// CRC-32 (0xEDB88320), four bits at a time
+static const uint32_t crc_table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+static uint32_t crc_byte(uint32_t crc, uint8_t value) {
+    crc = (crc >> 4) ^ crc_table[(crc ^ value) & 0x0F];
+    return (crc >> 4) ^ crc_table[(crc ^ (value >> 4)) & 0x0F];
+}
+static uint32_t frame_crc(uint8_t seq_byte, uint32_t length, const uint8_t* payload) {
+    uint32_t crc = crc_byte(0xFFFFFFFF, seq_byte);
+    for (int i = 0; i < 4; ++i) {
+        crc = crc_byte(crc, (uint8_t)(length >> (8 * i)));
+    }
+    for (uint32_t i = 0; i < length; ++i) {
+        crc = crc_byte(crc, payload[i]);
+    }
+    return crc ^ 0xFFFFFFFF;
+}
+static uint8_t* tx_slot(frame_window_t* fw, uint8_t slot) {
+    return fw->buffer + (size_t)slot * fw->max_payload;
+}
+static uint8_t* held_slot(frame_window_t* fw, uint8_t slot) {
+    return fw->buffer + ((size_t)fw->capacity + slot) * fw->max_payload;
+}
+static uint8_t* rx_buffer(frame_window_t* fw) {
+    return fw->buffer + (size_t)fw->capacity * 2 * fw->max_payload;
+}
+static void write_frame(frame_window_t* fw, uint8_t marker, uint8_t seq_byte, const uint8_t* payload, uint32_t length) {
+    const uint32_t crc = frame_crc(seq_byte, length, payload);
+    for (int i = 0; i < 8; ++i) {
+        fw->on_write(marker, fw->on_write_state);
+    }
+    fw->on_write(seq_byte, fw->on_write_state);
+    for (int i = 0; i < 4; ++i) {
+        fw->on_write((uint8_t)(length >> (8 * i)), fw->on_write_state);
+    }
+    for (int i = 0; i < 4; ++i) {
+        fw->on_write((uint8_t)(crc >> (8 * i)), fw->on_write_state);
+    }
+    for (uint32_t i = 0; i < length; ++i) {
+        fw->on_write(payload[i], fw->on_write_state);
+    }
+}
+static void write_control(frame_window_t* fw, int type, uint8_t seq) {
+    if (type == FRAME_WINDOW_TYPE_NACK) {
+        ++fw->nacks_sent;
+    }
+    write_frame(fw, CONTROL_MARKER, (uint8_t)((type << TYPE_SHIFT) | (seq & SEQ_MASK)), NULL, 0);
+}
+// sends the frame at offset from tx_base
+static void write_data(frame_window_t* fw, uint8_t offset) {
+    const uint8_t slot = (uint8_t)((fw->tx_first + offset) % fw->window);
+    const uint8_t seq = (uint8_t)((fw->tx_base + offset) & SEQ_MASK);
+    write_frame(fw, (uint8_t)(fw->tx_cmd[slot] + 128), seq, tx_slot(fw, slot), (uint32_t)fw->tx_len[slot]);
+}
+static void on_ack(frame_window_t* fw, uint8_t seq) {
+    const uint8_t offset = (uint8_t)((seq - fw->tx_base) & SEQ_MASK);
+    if (offset >= fw->tx_count) {
+        return;  // stale, or from before the switch
+    }
+    fw->tx_base = (uint8_t)((seq + 1) & SEQ_MASK);
+    fw->tx_first = (uint8_t)((fw->tx_first + offset + 1) % fw->window);
+    fw->tx_count -= offset + 1;
+}
+static void on_nack(frame_window_t* fw, uint8_t seq) {
+    const uint8_t offset = (uint8_t)((seq - fw->tx_base) & SEQ_MASK);
+    if (offset < fw->tx_count) {
+        ++fw->resends;
+        write_data(fw, offset);
+    }
+}
+// a whole frame is in rx_buffer(). returns true if it's the next one in order
+static bool on_data(frame_window_t* fw) {
+    const uint8_t seq = fw->rx_seq & SEQ_MASK;
+    const uint8_t cmd = (uint8_t)(fw->rx_cmd - 128);
+    if (fw->switch_cmd != 0 && cmd == fw->switch_cmd) {
+        write_control(fw, FRAME_WINDOW_TYPE_ACK, seq);
+        return false;
+    }
+    const uint8_t ahead = (uint8_t)((seq - fw->rx_expected) & SEQ_MASK);
+    if (ahead == 0) {
+        return true;
+    }
+    if (ahead < fw->window) {
+        const uint8_t slot = (uint8_t)((fw->rx_first + ahead) % fw->window);
+        if (!fw->rx_held[slot]) {
+            memcpy(held_slot(fw, slot), rx_buffer(fw), fw->rx_len);
+            fw->rx_held_cmd[slot] = cmd;
+            fw->rx_held_len[slot] = fw->rx_len;
+            fw->rx_held[slot] = true;
+        }
+        if (!fw->rx_nacked) {
+            fw->rx_nacked = true;
+            write_control(fw, FRAME_WINDOW_TYPE_NACK, fw->rx_expected);
+        }
+        return false;
+    }
+    if (((fw->rx_expected - seq) & SEQ_MASK) <= fw->window) {
+        // already delivered. our ACK must have been lost
+        write_control(fw, FRAME_WINDOW_TYPE_CACK, (uint8_t)(fw->rx_expected - 1));
+    }
+    return false;
+}
+// moves past the frame just delivered, and ACKs once the run of held frames
+// behind it is done
+static void advance(frame_window_t* fw) {
+    fw->rx_held[fw->rx_first] = false;
+    fw->rx_first = (uint8_t)((fw->rx_first + 1) % fw->window);
+    fw->rx_expected = (uint8_t)((fw->rx_expected + 1) & SEQ_MASK);
+    fw->rx_nacked = false;
+    if (!fw->rx_held[fw->rx_first]) {
+        write_control(fw, FRAME_WINDOW_TYPE_CACK, (uint8_t)(fw->rx_expected - 1));
+    }
+}
+int frame_window_init(frame_window_t* fw, uint8_t capacity, size_t max_payload, uint8_t* buffer,
+                      frame_window_read_callback_t on_read, void* on_read_state,
+                      frame_window_write_callback_t on_write, void* on_write_state) {
+    if (fw == NULL || buffer == NULL || on_read == NULL || on_write == NULL ||
+        capacity == 0 || capacity > FRAME_WINDOW_MAX) {
+        return FRAME_WINDOW_ERROR_ARG;
+    }
+    fw->on_read = on_read;
+    fw->on_read_state = on_read_state;
+    fw->on_write = on_write;
+    fw->on_write_state = on_write_state;
+    fw->buffer = buffer;
+    fw->max_payload = max_payload;
+    fw->capacity = capacity;
+    fw->resends = 0;
+    fw->nacks_sent = 0;
+    frame_window_reset(fw, capacity, 0);
+    return FRAME_WINDOW_SUCCESS;
+}
+void frame_window_reset(frame_window_t* fw, uint8_t window, uint8_t switch_cmd) {
+    if (window == 0) window = 1;
+    if (window > fw->capacity) window = fw->capacity;
+    fw->window = window;
+    fw->switch_cmd = switch_cmd;
+    fw->rx_state = 0;
+    fw->rx_expected = 0;
+    fw->rx_first = 0;
+    fw->rx_nacked = false;
+    memset(fw->rx_held, 0, sizeof(fw->rx_held));
+    fw->tx_base = 0;
+    fw->tx_count = 0;
+    fw->tx_first = 0;
+}
+int frame_window_get(frame_window_t* fw, void** out_payload, size_t* out_length) {
+    // a frame held past a gap that has since filled
+    if (fw->rx_held[fw->rx_first]) {
+        *out_payload = held_slot(fw, fw->rx_first);
+        *out_length = fw->rx_held_len[fw->rx_first];
+        const int cmd = fw->rx_held_cmd[fw->rx_first];
+        advance(fw);
+        return cmd;
+    }
+    int value;
+    while ((value = fw->on_read(fw->on_read_state)) >= 0) {
+        const uint8_t b = (uint8_t)value;
+        if (fw->rx_state == 0) {
+            if (b < 128) {
+                continue;
+            }
+            fw->rx_cmd = b;
+            fw->rx_len = 0;
+            fw->rx_crc = 0;
+            fw->rx_state = 1;
+        } else if (fw->rx_state < 8) {
+            if (b != fw->rx_cmd) {
+                // could be the start of the next frame's marker
+                fw->rx_state = 0;
+                if (b >= 128) {
+                    fw->rx_cmd = b;
+                    fw->rx_len = 0;
+                    fw->rx_crc = 0;
+                    fw->rx_state = 1;
+                }
+                continue;
+            }
+            ++fw->rx_state;
+        } else if (fw->rx_state == 8) {
+            fw->rx_seq = b;
+            ++fw->rx_state;
+        } else if (fw->rx_state < 13) {
+            fw->rx_len |= (uint32_t)b << (8 * (fw->rx_state - 9));
+            ++fw->rx_state;
+        } else if (fw->rx_state < 17) {
+            fw->rx_crc |= (uint32_t)b << (8 * (fw->rx_state - 13));
+            ++fw->rx_state;
+            if (fw->rx_state == 17) {
+                if (fw->rx_len > fw->max_payload) {
+                    fw->rx_state = 0;
+                    write_control(fw, FRAME_WINDOW_TYPE_NACK, fw->rx_expected);
+                    continue;
+                }
+                fw->rx_pos = 0;
+            }
+        } else {
+            rx_buffer(fw)[fw->rx_pos++] = b;
+        }
+        if (fw->rx_state < 17 || fw->rx_pos < fw->rx_len) {
+            continue;
+        }
+        // a whole frame
+        fw->rx_state = 0;
+        if (frame_crc(fw->rx_seq, fw->rx_len, rx_buffer(fw)) != fw->rx_crc) {
+            write_control(fw, FRAME_WINDOW_TYPE_NACK, fw->rx_expected);
+            continue;
+        }
+        const int type = fw->rx_seq >> TYPE_SHIFT;
+        if (fw->rx_cmd == CONTROL_MARKER || type != FRAME_WINDOW_TYPE_DATA) {
+            if (type == FRAME_WINDOW_TYPE_CACK) {
+                on_ack(fw, fw->rx_seq & SEQ_MASK);
+            } else if (type == FRAME_WINDOW_TYPE_NACK) {
+                on_nack(fw, fw->rx_seq & SEQ_MASK);
+            }
+            // a stop-and-wait ACK is left over from before the switch
+            continue;
+        }
+        if (on_data(fw)) {
+            *out_payload = rx_buffer(fw);
+            *out_length = fw->rx_len;
+            advance(fw);
+            return fw->rx_cmd - 128;
+        }
+    }
+    return 0;
+}
+int frame_window_put(frame_window_t* fw, uint8_t cmd, const void* payload, size_t length) {
+    if (cmd == 0 || cmd > 127) {
+        return FRAME_WINDOW_ERROR_ARG;
+    }
+    if (length > fw->max_payload) {
+        return FRAME_WINDOW_ERROR_TOO_BIG;
+    }
+    if (fw->tx_count >= fw->window) {
+        return FRAME_WINDOW_ERROR_BUSY;
+    }
+    const uint8_t offset = fw->tx_count;
+    const uint8_t slot = (uint8_t)((fw->tx_first + offset) % fw->window);
+    if (length) {
+        memcpy(tx_slot(fw, slot), payload, length);
+    }
+    fw->tx_cmd[slot] = cmd;
+    fw->tx_len[slot] = length;
+    ++fw->tx_count;
+    write_data(fw, offset);
+    return FRAME_WINDOW_SUCCESS;
+}
+bool frame_window_resend(frame_window_t* fw) {
+    if (fw->tx_count == 0) {
+        return false;
+    }
+    ++fw->resends;
+    write_data(fw, 0);
+    return true;
+}
+uint8_t frame_window_in_flight(const frame_window_t* fw) {
+    return fw->tx_count;
+}
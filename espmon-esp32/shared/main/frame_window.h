@@ -0,0 +1,103 @@
+#ifndef FRAME_WINDOW_H
+#define FRAME_WINDOW_H
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+// Sliding window ARQ over the same framing frame_arq uses: 8 marker bytes
+// (cmd + 128, or 128 for control frames), a seq/type byte (type << 6 | seq),
+// a little endian payload length and CRC-32, then the payload.
+// Up to window DATA frames are in flight at once. An ACK (FRAME_WINDOW_TYPE_CACK)
+// covers every frame up to its seq, and a NACK asks for one frame, so only
+// the frame that was lost goes out again. Frames received past a gap are held
+// and delivered in order once it fills.
+// Both ends start in stop-and-wait (frame_arq) and switch once the host has
+// its window request acked. See main.cpp
+#define FRAME_WINDOW_HEADER_LENGTH 17
+// seqs are 6 bits. Selective repeat needs the window to be at most half that
+#define FRAME_WINDOW_MAX 32
+
+enum {
+    FRAME_WINDOW_TYPE_DATA = 0,
+    FRAME_WINDOW_TYPE_ACK = 1,  // stop-and-wait ACK. Only sent to answer switch_cmd
+    FRAME_WINDOW_TYPE_NACK = 2,
+    FRAME_WINDOW_TYPE_CACK = 3  // cumulative ACK
+};
+
+enum {
+    FRAME_WINDOW_SUCCESS = 0,
+    FRAME_WINDOW_ERROR_BUSY = -1,  // the window is full
+    FRAME_WINDOW_ERROR_TOO_BIG = -2,
+    FRAME_WINDOW_ERROR_ARG = -3
+};
+
+typedef int (*frame_window_read_callback_t)(void* state);
+typedef int (*frame_window_write_callback_t)(uint8_t value, void* state);
+
+// bytes of buffer a window of this size with this largest payload needs:
+// the frames in flight, the frames held past a gap, and the one being read
+#define FRAME_WINDOW_BUFFER_SIZE(window, max_payload) \
+    (((size_t)(window) * 2 + 1) * (size_t)(max_payload))
+
+typedef struct {
+    frame_window_read_callback_t on_read;
+    void* on_read_state;
+    frame_window_write_callback_t on_write;
+    void* on_write_state;
+    uint8_t* buffer;
+    size_t max_payload;
+    uint8_t capacity;  // the window the buffer was sized for
+    uint8_t window;
+    // DATA frames with this cmd are the request that switched the link here,
+    // resent by a host that missed the stop-and-wait ACK for it. They get
+    // that ACK again and are not delivered. 0 for none
+    uint8_t switch_cmd;
+    // receive
+    int rx_state;
+    uint8_t rx_cmd;
+    uint8_t rx_seq;
+    uint32_t rx_len;
+    uint32_t rx_crc;
+    size_t rx_pos;
+    uint8_t rx_expected;
+    uint8_t rx_first;  // hold slot of rx_expected
+    bool rx_nacked;    // rx_expected was already asked for
+    bool rx_held[FRAME_WINDOW_MAX];
+    uint8_t rx_held_cmd[FRAME_WINDOW_MAX];
+    size_t rx_held_len[FRAME_WINDOW_MAX];
+    // send
+    uint8_t tx_base;   // oldest unacked seq
+    uint8_t tx_count;  // frames in flight
+    uint8_t tx_first;  // slot of tx_base
+    uint8_t tx_cmd[FRAME_WINDOW_MAX];
+    size_t tx_len[FRAME_WINDOW_MAX];
+    // since init. reset leaves them alone
+    uint32_t resends;     // DATA frames sent again, for a NACK or the ACK timer
+    uint32_t nacks_sent;
+} frame_window_t;
+
+// buffer must be FRAME_WINDOW_BUFFER_SIZE(capacity, max_payload) bytes.
+// capacity is at most FRAME_WINDOW_MAX
+int frame_window_init(frame_window_t* fw, uint8_t capacity, size_t max_payload, uint8_t* buffer,
+                      frame_window_read_callback_t on_read, void* on_read_state,
+                      frame_window_write_callback_t on_write, void* on_write_state);
+// drops everything in flight or held and starts both directions at seq 0 with
+// the given window (clamped to the capacity)
+void frame_window_reset(frame_window_t* fw, uint8_t window, uint8_t switch_cmd);
+// reads what's available. Returns the cmd of the next frame in order, with its
+// payload valid until the next call, or 0 if there isn't one yet.
+// ACKs and NACKs are handled here, and resends go out as they're asked for
+int frame_window_get(frame_window_t* fw, void** out_payload, size_t* out_length);
+// sends a frame. FRAME_WINDOW_ERROR_BUSY if the window is full
+int frame_window_put(frame_window_t* fw, uint8_t cmd, const void* payload, size_t length);
+// resends the oldest unacked frame, for the caller's ACK timer.
+// false if nothing is in flight
+bool frame_window_resend(frame_window_t* fw);
+// the frames sent and not yet acked
+uint8_t frame_window_in_flight(const frame_window_t* fw);
+#ifdef __cplusplus
+}
+#endif
+#endif // FRAME_WINDOW_H
@@ -43,6 +43,17 @@ size_t response_value_size(const response_value_t* s) {
     return size;
 }
 
+static void response_value_load(response_value_t* s, const uint8_t* p) {
+    s->value = buffers_load_float_le(p);
+    s->scaled = buffers_load_float_le(p + 4);
+}
+
+int response_value_read_span(response_value_t* s, const void* data, size_t length) {
+    if(length < 8) { return BUFFERS_ERROR_EOF; }
+    response_value_load(s, (const uint8_t*)data);
+    return 8;
+}
+
 int response_value_entry_read(response_value_entry_t* s, buffers_read_callback_t on_read, void* on_read_state) {
     int res;
     int bytes_read = 0;
@@ -74,6 +85,17 @@ size_t response_value_entry_size(const response_value_entry_t* s) {
     return size;
 }
 
+static void response_value_entry_load(response_value_entry_t* s, const uint8_t* p) {
+    response_value_load(&s->value1, p);
+    response_value_load(&s->value2, p + 8);
+}
+
+int response_value_entry_read_span(response_value_entry_t* s, const void* data, size_t length) {
+    if(length < 16) { return BUFFERS_ERROR_EOF; }
+    response_value_entry_load(s, (const uint8_t*)data);
+    return 16;
+}
+
 int response_data_read(response_data_t* s, buffers_read_callback_t on_read, void* on_read_state) {
     int res;
     int bytes_read = 0;
@@ -105,6 +127,78 @@ size_t response_data_size(const response_data_t* s) {
     return size;
 }
 
+static void response_data_load(response_data_t* s, const uint8_t* p) {
+    response_value_entry_load(&s->top, p);
+    response_value_entry_load(&s->bottom, p + 16);
+}
+
+int response_data_read_span(response_data_t* s, const void* data, size_t length) {
+    if(length < 32) { return BUFFERS_ERROR_EOF; }
+    response_data_load(s, (const uint8_t*)data);
+    return 32;
+}
+
+int response_data_delta_read(response_data_delta_t* s, buffers_read_callback_t on_read, void* on_read_state) {
+    int res;
+    int bytes_read = 0;
+    res = buffers_read_uint8_t(&s->changed, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    {
+        uint8_t _len_length;
+        res = buffers_read_uint8_t(&_len_length, on_read, on_read_state, &bytes_read);
+        if(res < 0) { return res; }
+        if(_len_length > 48) { return BUFFERS_ERROR_EOF; }
+        s->length = _len_length;
+    }
+    for(int i = 0; i < (int)s->length; ++i) {
+        res = buffers_read_uint8_t(&s->deltas[i], on_read, on_read_state, &bytes_read);
+        if(res < 0) { return res; }
+    }
+    return bytes_read;
+}
+
+int response_data_delta_write(const response_data_delta_t* s, buffers_write_callback_t on_write, void* on_write_state) {
+    int res;
+    int total = 0;
+    res = buffers_write_uint8_t(s->changed, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    if(s->length > 48) { return BUFFERS_ERROR_EOF; }
+    res = buffers_write_uint8_t((uint8_t)s->length, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    for(int i = 0; i < (int)s->length; ++i) {
+        res = buffers_write_uint8_t(s->deltas[i], on_write, on_write_state);
+        if(res < 0) { return res; }
+        total += res;
+    }
+    return total;
+}
+
+size_t response_data_delta_size(const response_data_delta_t* s) {
+    size_t size = 0;
+    size += 1;
+    size += 1;
+    size += s->length * 1;
+    return size;
+}
+
+int response_data_delta_read_span(response_data_delta_t* s, const void* data, size_t length) {
+    const uint8_t* p = (const uint8_t*)data;
+    size_t pos = 0;
+    size_t _len_deltas;
+    if(length - pos < 2) { return BUFFERS_ERROR_EOF; }
+    s->changed = p[pos];
+    _len_deltas = p[pos + 1];
+    s->length = _len_deltas;
+    pos += 2;
+    if(_len_deltas > 48) { return BUFFERS_ERROR_EOF; }
+    if(length - pos < _len_deltas) { return BUFFERS_ERROR_EOF; }
+    memcpy(s->deltas, p + pos, _len_deltas);
+    pos += _len_deltas;
+    return (int)pos;
+}
+
 int response_color_read(response_color_t* s, buffers_read_callback_t on_read, void* on_read_state) {
     int res;
     int bytes_read = 0;
@@ -146,6 +240,19 @@ size_t response_color_size(const response_color_t* s) {
     return size;
 }
 
+static void response_color_load(response_color_t* s, const uint8_t* p) {
+    s->a = p[0];
+    s->r = p[1];
+    s->g = p[2];
+    s->b = p[3];
+}
+
+int response_color_read_span(response_color_t* s, const void* data, size_t length) {
+    if(length < 4) { return BUFFERS_ERROR_EOF; }
+    response_color_load(s, (const uint8_t*)data);
+    return 4;
+}
+
 int response_screen_value_entry_read(response_screen_value_entry_t* s, buffers_read_callback_t on_read, void* on_read_state) {
     int res;
     int bytes_read = 0;
@@ -206,6 +313,23 @@ size_t response_screen_value_entry_size(const response_screen_value_entry_t* s)
     return size;
 }
 
+int response_screen_value_entry_read_span(response_screen_value_entry_t* s, const void* data, size_t length) {
+    const uint8_t* p = (const uint8_t*)data;
+    size_t pos = 0;
+    size_t _len_suffix;
+    if(length - pos < 5) { return BUFFERS_ERROR_EOF; }
+    response_color_load(&s->color, p + pos);
+    _len_suffix = p[pos + 4];
+    pos += 5;
+    if(_len_suffix > 12 || length - pos < _len_suffix) { return BUFFERS_ERROR_EOF; }
+    memcpy(s->suffix, p + pos, _len_suffix);
+    if(_len_suffix < 12) {
+        s->suffix[_len_suffix] = '\0';
+    }
+    pos += _len_suffix;
+    return (int)pos;
+}
+
 int response_screen_entry_read(response_screen_entry_t* s, buffers_read_callback_t on_read, void* on_read_state) {
     int res;
     int bytes_read = 0;
@@ -280,6 +404,32 @@ size_t response_screen_entry_size(const response_screen_entry_t* s) {
     return size;
 }
 
+int response_screen_entry_read_span(response_screen_entry_t* s, const void* data, size_t length) {
+    const uint8_t* p = (const uint8_t*)data;
+    size_t pos = 0;
+    size_t _len_label;
+    int res;
+    if(length - pos < 1) { return BUFFERS_ERROR_EOF; }
+    _len_label = p[pos];
+    pos += 1;
+    if(_len_label > 16 || length - pos < _len_label) { return BUFFERS_ERROR_EOF; }
+    memcpy(s->label, p + pos, _len_label);
+    if(_len_label < 16) {
+        s->label[_len_label] = '\0';
+    }
+    pos += _len_label;
+    if(length - pos < 4) { return BUFFERS_ERROR_EOF; }
+    response_color_load(&s->color, p + pos);
+    pos += 4;
+    res = response_screen_value_entry_read_span(&s->value1, p + pos, length - pos);
+    if(res < 0) { return res; }
+    pos += res;
+    res = response_screen_value_entry_read_span(&s->value2, p + pos, length - pos);
+    if(res < 0) { return res; }
+    pos += res;
+    return (int)pos;
+}
+
 int response_screen_header_read(response_screen_header_t* s, buffers_read_callback_t on_read, void* on_read_state) {
     int res;
     int bytes_read = 0;
@@ -309,6 +459,17 @@ size_t response_screen_header_size(const response_screen_header_t* s) {
     return size;
 }
 
+static void response_screen_header_load(response_screen_header_t* s, const uint8_t* p) {
+    s->index = (int8_t)p[0];
+    s->flags = p[1];
+}
+
+int response_screen_header_read_span(response_screen_header_t* s, const void* data, size_t length) {
+    if(length < 2) { return BUFFERS_ERROR_EOF; }
+    response_screen_header_load(s, (const uint8_t*)data);
+    return 2;
+}
+
 int response_screen_read(response_screen_t* s, buffers_read_callback_t on_read, void* on_read_state) {
     int res;
     int bytes_read = 0;
@@ -347,6 +508,22 @@ size_t response_screen_size(const response_screen_t* s) {
     return size;
 }
 
+int response_screen_read_span(response_screen_t* s, const void* data, size_t length) {
+    const uint8_t* p = (const uint8_t*)data;
+    size_t pos = 0;
+    int res;
+    if(length - pos < 2) { return BUFFERS_ERROR_EOF; }
+    response_screen_header_load(&s->header, p + pos);
+    pos += 2;
+    res = response_screen_entry_read_span(&s->top, p + pos, length - pos);
+    if(res < 0) { return res; }
+    pos += res;
+    res = response_screen_entry_read_span(&s->bottom, p + pos, length - pos);
+    if(res < 0) { return res; }
+    pos += res;
+    return (int)pos;
+}
+
 int response_clear_read(response_clear_t* s, buffers_read_callback_t on_read, void* on_read_state) {
     (void)s; (void)on_read; (void)on_read_state;
     return 0;
@@ -362,6 +539,11 @@ size_t response_clear_size(const response_clear_t* s) {
     return 0;
 }
 
+int response_clear_read_span(response_clear_t* s, const void* data, size_t length) {
+    (void)s; (void)data; (void)length;
+    return 0;
+}
+
 int response_ident_read(response_ident_t* s, buffers_read_callback_t on_read, void* on_read_state) {
     (void)s; (void)on_read; (void)on_read_state;
     return 0;
@@ -377,6 +559,11 @@ size_t response_ident_size(const response_ident_t* s) {
     return 0;
 }
 
+int response_ident_read_span(response_ident_t* s, const void* data, size_t length) {
+    (void)s; (void)data; (void)length;
+    return 0;
+}
+
 int response_refresh_screen_read(response_refresh_screen_t* s, buffers_read_callback_t on_read, void* on_read_state) {
     (void)s; (void)on_read; (void)on_read_state;
     return 0;
@@ -392,6 +579,77 @@ size_t response_refresh_screen_size(const response_refresh_screen_t* s) {
     return 0;
 }
 
+int response_refresh_screen_read_span(response_refresh_screen_t* s, const void* data, size_t length) {
+    (void)s; (void)data; (void)length;
+    return 0;
+}
+
+int response_baud_read(response_baud_t* s, buffers_read_callback_t on_read, void* on_read_state) {
+    int res;
+    int bytes_read = 0;
+    res = buffers_read_uint32_t_le(&s->baud, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    return bytes_read;
+}
+
+int response_baud_write(const response_baud_t* s, buffers_write_callback_t on_write, void* on_write_state) {
+    int res;
+    int total = 0;
+    res = buffers_write_uint32_t_le(s->baud, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    return total;
+}
+
+size_t response_baud_size(const response_baud_t* s) {
+    size_t size = 0;
+    size += 4;
+    return size;
+}
+
+static void response_baud_load(response_baud_t* s, const uint8_t* p) {
+    s->baud = buffers_load_uint32_t_le(p);
+}
+
+int response_baud_read_span(response_baud_t* s, const void* data, size_t length) {
+    if(length < 4) { return BUFFERS_ERROR_EOF; }
+    response_baud_load(s, (const uint8_t*)data);
+    return 4;
+}
+
+int response_window_read(response_window_t* s, buffers_read_callback_t on_read, void* on_read_state) {
+    int res;
+    int bytes_read = 0;
+    res = buffers_read_uint8_t(&s->size, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    return bytes_read;
+}
+
+int response_window_write(const response_window_t* s, buffers_write_callback_t on_write, void* on_write_state) {
+    int res;
+    int total = 0;
+    res = buffers_write_uint8_t(s->size, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    return total;
+}
+
+size_t response_window_size(const response_window_t* s) {
+    size_t size = 0;
+    size += 1;
+    return size;
+}
+
+static void response_window_load(response_window_t* s, const uint8_t* p) {
+    s->size = p[0];
+}
+
+int response_window_read_span(response_window_t* s, const void* data, size_t length) {
+    if(length < 1) { return BUFFERS_ERROR_EOF; }
+    response_window_load(s, (const uint8_t*)data);
+    return 1;
+}
+
 int request_data_read(request_data_t* s, buffers_read_callback_t on_read, void* on_read_state) {
     int res;
     int bytes_read = 0;
@@ -415,6 +673,16 @@ size_t request_data_size(const request_data_t* s) {
     return size;
 }
 
+static void request_data_load(request_data_t* s, const uint8_t* p) {
+    s->screen_index = (int8_t)p[0];
+}
+
+int request_data_read_span(request_data_t* s, const void* data, size_t length) {
+    if(length < 1) { return BUFFERS_ERROR_EOF; }
+    request_data_load(s, (const uint8_t*)data);
+    return 1;
+}
+
 int request_nop_read(request_nop_t* s, buffers_read_callback_t on_read, void* on_read_state) {
     (void)s; (void)on_read; (void)on_read_state;
     return 0;
@@ -430,6 +698,11 @@ size_t request_nop_size(const request_nop_t* s) {
     return 0;
 }
 
+int request_nop_read_span(request_nop_t* s, const void* data, size_t length) {
+    (void)s; (void)data; (void)length;
+    return 0;
+}
+
 int request_screen_read(request_screen_t* s, buffers_read_callback_t on_read, void* on_read_state) {
     int res;
     int bytes_read = 0;
@@ -453,6 +726,16 @@ size_t request_screen_size(const request_screen_t* s) {
     return size;
 }
 
+static void request_screen_load(request_screen_t* s, const uint8_t* p) {
+    s->screen_index = (int8_t)p[0];
+}
+
+int request_screen_read_span(request_screen_t* s, const void* data, size_t length) {
+    if(length < 1) { return BUFFERS_ERROR_EOF; }
+    request_screen_load(s, (const uint8_t*)data);
+    return 1;
+}
+
 int request_set_mode_read(request_set_mode_t* s, buffers_read_callback_t on_read, void* on_read_state) {
     int res;
     int bytes_read = 0;
@@ -476,6 +759,56 @@ size_t request_set_mode_size(const request_set_mode_t* s) {
     return size;
 }
 
+static void request_set_mode_load(request_set_mode_t* s, const uint8_t* p) {
+    s->mode = (int8_t)p[0];
+}
+
+int request_set_mode_read_span(request_set_mode_t* s, const void* data, size_t length) {
+    if(length < 1) { return BUFFERS_ERROR_EOF; }
+    request_set_mode_load(s, (const uint8_t*)data);
+    return 1;
+}
+
+int request_subscribe_read(request_subscribe_t* s, buffers_read_callback_t on_read, void* on_read_state) {
+    int res;
+    int bytes_read = 0;
+    res = buffers_read_int8_t(&s->screen_index, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    res = buffers_read_uint16_t_le(&s->interval_ms, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    return bytes_read;
+}
+
+int request_subscribe_write(const request_subscribe_t* s, buffers_write_callback_t on_write, void* on_write_state) {
+    int res;
+    int total = 0;
+    res = buffers_write_int8_t(s->screen_index, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    res = buffers_write_uint16_t_le(s->interval_ms, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    return total;
+}
+
+size_t request_subscribe_size(const request_subscribe_t* s) {
+    size_t size = 0;
+    size += 1;
+    size += 2;
+    return size;
+}
+
+static void request_subscribe_load(request_subscribe_t* s, const uint8_t* p) {
+    s->screen_index = (int8_t)p[0];
+    s->interval_ms = buffers_load_uint16_t_le(p + 1);
+}
+
+int request_subscribe_read_span(request_subscribe_t* s, const void* data, size_t length) {
+    if(length < 3) { return BUFFERS_ERROR_EOF; }
+    request_subscribe_load(s, (const uint8_t*)data);
+    return 3;
+}
+
 int request_ident_read(request_ident_t* s, buffers_read_callback_t on_read, void* on_read_state) {
     int res;
     int bytes_read = 0;
@@ -529,6 +862,12 @@ int request_ident_read(request_ident_t* s, buffers_read_callback_t on_read, void
     if(res < 0) { return res; }
     res = read_input_type_t(&s->input_type, on_read, on_read_state, &bytes_read);
     if(res < 0) { return res; }
+    res = buffers_read_uint32_t_le(&s->max_baud, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    res = buffers_read_uint8_t(&s->max_window, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    res = buffers_read_bool(&s->data_delta, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
     return bytes_read;
 }
 
@@ -600,6 +939,15 @@ int request_ident_write(const request_ident_t* s, buffers_write_callback_t on_wr
     res = write_input_type_t(s->input_type, on_write, on_write_state);
     if(res < 0) { return res; }
     total += res;
+    res = buffers_write_uint32_t_le(s->max_baud, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    res = buffers_write_uint8_t(s->max_window, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    res = buffers_write_bool(s->data_delta, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
     return total;
 }
 
@@ -632,5 +980,216 @@ size_t request_ident_size(const request_ident_t* s) {
     size += 4;
     size += 4;
     size += 1;
+    size += 4;
+    size += 1;
+    size += 1;
+    return size;
+}
+
+int request_ident_read_span(request_ident_t* s, const void* data, size_t length) {
+    const uint8_t* p = (const uint8_t*)data;
+    size_t pos = 0;
+    size_t _len_display_name;
+    size_t _len_slug;
+    if(length - pos < 21) { return BUFFERS_ERROR_EOF; }
+    s->version_major = buffers_load_uint16_t_le(p + pos);
+    s->version_minor = buffers_load_uint16_t_le(p + pos + 2);
+    s->build = buffers_load_uint64_t_le(p + pos + 4);
+    s->id = buffers_load_int16_t_le(p + pos + 12);
+    memcpy(s->mac_address, p + pos + 14, 6);
+    _len_display_name = p[pos + 20];
+    pos += 21;
+    if(_len_display_name > 64 || length - pos < _len_display_name) { return BUFFERS_ERROR_EOF; }
+    memcpy(s->display_name, p + pos, _len_display_name);
+    if(_len_display_name < 64) {
+        s->display_name[_len_display_name] = '\0';
+    }
+    pos += _len_display_name;
+    if(length - pos < 1) { return BUFFERS_ERROR_EOF; }
+    _len_slug = p[pos];
+    pos += 1;
+    if(_len_slug > 64 || length - pos < _len_slug) { return BUFFERS_ERROR_EOF; }
+    memcpy(s->slug, p + pos, _len_slug);
+    if(_len_slug < 64) {
+        s->slug[_len_slug] = '\0';
+    }
+    pos += _len_slug;
+    if(length - pos < 20) { return BUFFERS_ERROR_EOF; }
+    s->horizontal_resolution = buffers_load_uint16_t_le(p + pos);
+    s->vertical_resolution = buffers_load_uint16_t_le(p + pos + 2);
+    s->is_monochrome = (p[pos + 4] ? 1 : 0);
+    s->dpi = buffers_load_float_le(p + pos + 5);
+    s->pixel_size = buffers_load_float_le(p + pos + 9);
+    s->input_type = (input_type_t)p[pos + 13];
+    s->max_baud = buffers_load_uint32_t_le(p + pos + 14);
+    s->max_window = p[pos + 18];
+    s->data_delta = (p[pos + 19] ? 1 : 0);
+    pos += 20;
+    return (int)pos;
+}
+
+int request_stats_port_read(request_stats_port_t* s, buffers_read_callback_t on_read, void* on_read_state) {
+    int res;
+    int bytes_read = 0;
+    res = buffers_read_uint32_t_le(&s->retransmits, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    res = buffers_read_uint32_t_le(&s->nacks, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    return bytes_read;
+}
+
+int request_stats_port_write(const request_stats_port_t* s, buffers_write_callback_t on_write, void* on_write_state) {
+    int res;
+    int total = 0;
+    res = buffers_write_uint32_t_le(s->retransmits, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    res = buffers_write_uint32_t_le(s->nacks, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    return total;
+}
+
+size_t request_stats_port_size(const request_stats_port_t* s) {
+    size_t size = 0;
+    size += 4;
+    size += 4;
+    return size;
+}
+
+static void request_stats_port_load(request_stats_port_t* s, const uint8_t* p) {
+    s->retransmits = buffers_load_uint32_t_le(p);
+    s->nacks = buffers_load_uint32_t_le(p + 4);
+}
+
+int request_stats_port_read_span(request_stats_port_t* s, const void* data, size_t length) {
+    if(length < 8) { return BUFFERS_ERROR_EOF; }
+    request_stats_port_load(s, (const uint8_t*)data);
+    return 8;
+}
+
+int request_stats_read(request_stats_t* s, buffers_read_callback_t on_read, void* on_read_state) {
+    int res;
+    int bytes_read = 0;
+    res = buffers_read_uint32_t_le(&s->interval_ms, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    res = buffers_read_uint32_t_le(&s->frames, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    res = buffers_read_uint32_t_le(&s->render_min_us, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    res = buffers_read_uint32_t_le(&s->render_avg_us, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    res = buffers_read_uint32_t_le(&s->render_p99_us, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    res = buffers_read_uint32_t_le(&s->flush_bytes, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    res = buffers_read_uint32_t_le(&s->flush_stalls, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    res = request_stats_port_read(&s->port1, on_read, on_read_state);
+    if(res < 0) { return res; }
+    bytes_read += res;
+    res = request_stats_port_read(&s->port2, on_read, on_read_state);
+    if(res < 0) { return res; }
+    bytes_read += res;
+    res = buffers_read_uint32_t_le(&s->rx_overflows, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    res = buffers_read_uint32_t_le(&s->free_heap, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    res = buffers_read_uint32_t_le(&s->largest_free_block, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    res = buffers_read_uint32_t_le(&s->free_psram, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    res = buffers_read_uint32_t_le(&s->largest_free_psram, on_read, on_read_state, &bytes_read);
+    if(res < 0) { return res; }
+    return bytes_read;
+}
+
+int request_stats_write(const request_stats_t* s, buffers_write_callback_t on_write, void* on_write_state) {
+    int res;
+    int total = 0;
+    res = buffers_write_uint32_t_le(s->interval_ms, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    res = buffers_write_uint32_t_le(s->frames, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    res = buffers_write_uint32_t_le(s->render_min_us, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    res = buffers_write_uint32_t_le(s->render_avg_us, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    res = buffers_write_uint32_t_le(s->render_p99_us, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    res = buffers_write_uint32_t_le(s->flush_bytes, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    res = buffers_write_uint32_t_le(s->flush_stalls, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    res = request_stats_port_write(&s->port1, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    res = request_stats_port_write(&s->port2, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    res = buffers_write_uint32_t_le(s->rx_overflows, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    res = buffers_write_uint32_t_le(s->free_heap, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    res = buffers_write_uint32_t_le(s->largest_free_block, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    res = buffers_write_uint32_t_le(s->free_psram, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    res = buffers_write_uint32_t_le(s->largest_free_psram, on_write, on_write_state);
+    if(res < 0) { return res; }
+    total += res;
+    return total;
+}
+
+size_t request_stats_size(const request_stats_t* s) {
+    size_t size = 0;
+    size += 4;
+    size += 4;
+    size += 4;
+    size += 4;
+    size += 4;
+    size += 4;
+    size += 4;
+    size += request_stats_port_size(&s->port1);
+    size += request_stats_port_size(&s->port2);
+    size += 4;
+    size += 4;
+    size += 4;
+    size += 4;
+    size += 4;
     return size;
 }
+
+static void request_stats_load(request_stats_t* s, const uint8_t* p) {
+    s->interval_ms = buffers_load_uint32_t_le(p);
+    s->frames = buffers_load_uint32_t_le(p + 4);
+    s->render_min_us = buffers_load_uint32_t_le(p + 8);
+    s->render_avg_us = buffers_load_uint32_t_le(p + 12);
+    s->render_p99_us = buffers_load_uint32_t_le(p + 16);
+    s->flush_bytes = buffers_load_uint32_t_le(p + 20);
+    s->flush_stalls = buffers_load_uint32_t_le(p + 24);
+    request_stats_port_load(&s->port1, p + 28);
+    request_stats_port_load(&s->port2, p + 36);
+    s->rx_overflows = buffers_load_uint32_t_le(p + 44);
+    s->free_heap = buffers_load_uint32_t_le(p + 48);
+    s->largest_free_block = buffers_load_uint32_t_le(p + 52);
+    s->free_psram = buffers_load_uint32_t_le(p + 56);
+    s->largest_free_psram = buffers_load_uint32_t_le(p + 60);
+}
+
+int request_stats_read_span(request_stats_t* s, const void* data, size_t length) {
+    if(length < 64) { return BUFFERS_ERROR_EOF; }
+    request_stats_load(s, (const uint8_t*)data);
+    return 64;
+}
@@ -1,4 +1,14 @@
 //#define LOG_HEAP
+// Emit every frame sent or received as a TRACE: line on the log channel
+// (see frame_trace.h). Capture with the host's serial log and replay it with
+// libespmon's espmon_bench -t <log>.
+// The log channel is the console, UART0, which is the same port the link to
+// the host runs over, so a host session on that port sees the lines as
+// garbage between frames and drops or resends them. On boards with a second
+// port (HAS_SERIAL2, the USB Serial/JTAG) run the host over that one and
+// capture UART0 on its own. Elsewhere the trace is only good for a short
+// capture, not a session to measure.
+//#define TRACE_FRAMES
 // If the CMD_SCREEN response for an input-driven advance never arrives, don't
 // lock out navigation forever — clear the input gate after this.
 #define SCREEN_CHANGE_TIMEOUT_MS 1000
@@ -8,6 +18,7 @@
 #include <string.h>
 #include <math.h>
 #include <time.h>
+#include <algorithm>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_system.h"
@@ -23,7 +34,14 @@
 #include "panel.h"
 #include "serial.h"
 #include "frame_arq.h"
+#include "frame_window.h"
+#include "data_delta.h"
+#include "packet_queue.h"
 #include "interface_buffers.h"
+#include "esp_timer.h"
+#ifdef TRACE_FRAMES
+#include "frame_trace.h"
+#endif
 #define MONOXBOLD_IMPLEMENTATION
 #include <monoxbold.hpp>
 #undef MONOXBOLD_IMPLEMENTATION
@@ -55,6 +73,20 @@ static const char* TAG = "app";
 #define LCD_BUFFER1 ((uint8_t*)panel_lcd_transfer_buffer())
 #if LCD_SYNC_TRANSFER == 0
 #define LCD_BUFFER2 ((uint8_t*)panel_lcd_transfer_buffer2())
+// How many transfer buffers the display renders into in turn, so it can get
+// that many tiles less one ahead of the bus. Past the two the panel
+// provides, the rest come from DMA capable heap
+#ifndef LCD_TRANSFER_BUFFERS
+#define LCD_TRANSFER_BUFFERS 2
+#endif
+// Rows of the screen each tile holds, for boards that do better with strips
+// shorter than LCD_TRANSFER_SIZE (LCD_DIVISOR) holds
+#ifdef LCD_STRIP_HEIGHT
+#define LCD_STRIP_SIZE ((LCD_WIDTH*LCD_STRIP_HEIGHT*LCD_BIT_DEPTH+7)/8)
+static_assert(LCD_STRIP_SIZE<=LCD_TRANSFER_SIZE,"LCD_STRIP_HEIGHT is more than LCD_TRANSFER_SIZE holds");
+#else
+#define LCD_STRIP_SIZE LCD_TRANSFER_SIZE
+#endif
 #else
 #define LCD_BUFFER2 nullptr
 #endif
@@ -67,12 +99,63 @@ static const char* TAG = "app";
 // cleared by the disconnect timeout below, which resets the ARQ state.
 #define ACK_TIMEOUT_MS 300
 
+// The most frames CMD_WINDOW lets each port keep in flight. Each one costs
+// two INTERFACE_MAX_SIZE buffers per port
+#ifndef FRAME_WINDOW_SIZE
+#define FRAME_WINDOW_SIZE 4
+#endif
+static_assert(FRAME_WINDOW_SIZE>=1 && FRAME_WINDOW_SIZE<=FRAME_WINDOW_MAX,"FRAME_WINDOW_SIZE is out of range");
+
+// Once connected the device subscribes to its screen with CMD_SUBSCRIBE, and the
+// host pushes CMD_DATA at most this often instead of answering a request per
+// sample. Boards with slow panels can ask for less
+#ifndef SUBSCRIBE_INTERVAL_MS
+#define SUBSCRIBE_INTERVAL_MS 33
+#endif
+// A host that hasn't pushed anything this long after subscribing doesn't
+// support it, so the device goes back to polling until it reconnects
+#define SUBSCRIBE_TIMEOUT_MS 2500
+
+// After CMD_BAUD moves port1 off the default rate, it goes back if nothing
+// decodes (no frame and no ACK) for this long, so a rate the USB bridge or the
+// host can't manage doesn't strand the link. Once subscribed, the only traffic
+// in is the host's pushes, which come as slowly as the screen updates, so this
+// allows a couple of them to be skipped on a 1Hz screen. It still falls back
+// before the 5s disconnect
+#define BAUD_FALLBACK_MS (3*((SUBSCRIBE_INTERVAL_MS)>1000?(SUBSCRIBE_INTERVAL_MS):1000))
+
 #if defined(TOUCH_BUS) || defined(BUTTON)
 #define HAS_INPUT
 #endif
 
+// The serial ports, the ARQ and input run on their own task, so a long repaint
+// doesn't hold up ACKs. On dual core targets it's pinned to the core the
+// render loop (app_main) isn't on. Decoded packets go to the render loop
+// through a packet_queue_t
+#define IO_TASK_STACK_SIZE 4096
+#define IO_TASK_PRIORITY 5
+
+// The render loop paints at most once per frame slot: each vsync on RGB and
+// MIPI panels, and each 1/RENDER_MAX_FPS of a second on the rest. Data frames
+// that come in between only go into the graph. The latest updates the labels
+// and bars as well
+#ifndef RENDER_MAX_FPS
+#define RENDER_MAX_FPS 30
+#endif
+
+// samples of history in the graph. Boards with wide panels can set more
+#ifndef GRAPH_HISTORY
+#define GRAPH_HISTORY 100
+#endif
+// How often CMD_STATS goes out while the link is up
+#ifndef STATS_INTERVAL_MS
+#define STATS_INTERVAL_MS 5000
+#endif
+// Render times kept for the p99. Past this many frames in an interval, it's
+// taken over the most recent ones
+#define STATS_SAMPLES 256
 using uix_color_t = color<uix_pixel>;
-static espmon<bitmap<PIXEL>,LCD_X_ALIGN,LCD_Y_ALIGN> app;
+static espmon<bitmap<PIXEL>,LCD_X_ALIGN,LCD_Y_ALIGN,GRAPH_HISTORY> app;
 static TickType_t disconnect_ts = xTaskGetTickCount();
 static uint8_t mac_address[6] = {0};
 static float dpi = 0.0f;
@@ -80,6 +163,21 @@ static float pixel_size = 0.0f;
 static bool screen_change_pending = false;
 static TickType_t screen_change_ts = 0;
 static int8_t screen_index = -1;
+// a rate CMD_BAUD asked for, applied once the ACK for it has gone out
+static uint32_t baud_pending = 0;
+// the screen the host pushes data for, or -1 when polling
+static int8_t subscribed_index = -1;
+// when the subscription went out, or data last came in for it
+static TickType_t subscribe_ts = 0;
+static bool subscribe_unsupported = false;
+// what CMD_DATA_DELTA changes are from. Kept across disconnects: the host
+// starts each connection with a full CMD_DATA
+static data_delta_t data_baseline;
+// IO task to render loop. CMD_NONE means the link dropped
+static packet_queue_t packets;
+static TaskHandle_t render_task = nullptr;
+// a frame has come in since the link last dropped. IO task only
+static bool link_connected = false;
 
 int serial_read(void* state) {
     return serial_getc();
@@ -103,15 +201,6 @@ typedef struct {
     uint8_t* ptr;
     size_t remaining;
 } buffer_cursor_t;
-static int on_read_buffer(void* state) {
-    buffer_cursor_t* cur = (buffer_cursor_t*)state;
-    if(cur->remaining==0) {
-        return BUFFERS_EOF;
-    }
-    uint8_t result = *cur->ptr++;
-    --cur->remaining;
-    return result;
-}
 int on_write_buffer(uint8_t value, void* state) {
     buffer_cursor_t* cur = (buffer_cursor_t*)state;
     if(cur->remaining==0) {
@@ -124,11 +213,13 @@ int on_write_buffer(uint8_t value, void* state) {
 
 // One serial port: the ARQ state + its two caller-supplied buffers (read + retain,
 // required by the zero-alloc _za create), plus a single staged outbound frame.
-// Stop-and-wait allows only one frame in flight, so an outbound request that
-// can't go out yet (a prior frame is unacked) is held in stage_buf and flushed
-// once the link is free. The device only sends small request frames, so stage_buf
-// can be shrunk below INTERFACE_MAX_SIZE if RAM is tight and you know your largest
-// request size.
+// Every link starts in stop-and-wait, which allows only one frame in flight, so
+// an outbound request that can't go out yet (a prior frame is unacked) is held in
+// stage_buf and flushed once the link is free. The device only sends small request
+// frames, so stage_buf can be shrunk below INTERFACE_MAX_SIZE if RAM is tight and
+// you know your largest request size.
+// Once the host sends CMD_WINDOW the port switches to the sliding window in
+// frame_window.h, and staged frames go out as soon as there's room in it.
 typedef struct {
     frame_arq_t        state;
     uint8_t            read_buf[INTERFACE_MAX_SIZE + FRAME_ARQ_HEADER_LENGTH];
@@ -140,6 +231,17 @@ typedef struct {
     bool               pending;
     bool               priority;    // important send (screen request / ident) that must not drop
     TickType_t         last_send;   // when the outstanding frame was last (re)transmitted
+    bool             (*flush)(void); // sends what the ARQ wrote to the serial buffer
+    frame_window_t     window;
+    uint8_t            window_buf[FRAME_WINDOW_BUFFER_SIZE(FRAME_WINDOW_SIZE, INTERFACE_MAX_SIZE)];
+    bool               windowed;
+    uint8_t            window_pending; // a window CMD_WINDOW asked for, applied after its ACK goes out
+    TickType_t         live_ts;     // when a frame or an ACK last came in
+    uint32_t           retransmits; // stop-and-wait resends. The window counts its own
+#ifdef TRACE_FRAMES
+    uint8_t            trace_in_seq;  // delivery order mod 64, which tracks the wire seq
+    uint8_t            trace_out_seq;
+#endif
 } port_t;
 
 static port_t port1;
@@ -151,6 +253,41 @@ static port_t port2;
 static port_t* active = &port1;
 static bool active_pinned = false;
 
+#ifdef TRACE_FRAMES
+// Records are hex encoded so they stay log text (< 128). One line per record.
+// See TRACE_FRAMES about the port they share with the link.
+static frame_trace_writer_t trace_writer;
+static char trace_line[(INTERFACE_MAX_SIZE + FRAME_TRACE_RECORD_OVERHEAD) * 2 + 1];
+static size_t trace_line_len = 0;
+static int trace_write(uint8_t value, void* state) {
+    (void)state;
+    static const char* hex = "0123456789ABCDEF";
+    if(trace_line_len + 2 >= sizeof(trace_line)) {
+        return BUFFERS_ERROR_EOF;
+    }
+    trace_line[trace_line_len++] = hex[value >> 4];
+    trace_line[trace_line_len++] = hex[value & 0x0F];
+    return 1;
+}
+static void trace_line_flush() {
+    trace_line[trace_line_len] = '\0';
+    printf("TRACE:%s\n", trace_line);
+    trace_line_len = 0;
+}
+static void trace_init() {
+    trace_line_len = 0;
+    frame_trace_writer_init(&trace_writer, trace_write, nullptr);
+    trace_line_flush();
+}
+static void trace_frame(port_t* pt, frame_trace_dir_t dir, uint8_t cmd, const void* payload, size_t len) {
+    uint8_t* seq = (dir == FRAME_TRACE_IN) ? &pt->trace_in_seq : &pt->trace_out_seq;
+    trace_line_len = 0;
+    if(-1 < frame_trace_write(&trace_writer, (uint64_t)esp_timer_get_time(), dir, cmd, *seq, payload, len)) {
+        trace_line_flush();
+    }
+    *seq = (*seq + 1) & 0x3F;
+}
+#endif
 // Stage an outbound frame. A routine send won't clobber a pending important one;
 // a newer important send replaces an older one (rare, and periodic sends self-heal).
 static void stage(port_t* pt, uint8_t cmd, const uint8_t* data, size_t len, bool priority) {
@@ -166,26 +303,112 @@ static void stage(port_t* pt, uint8_t cmd, const uint8_t* data, size_t len, bool
     pt->priority = priority;
     pt->pending = true;
 }
-// Flush a staged frame once the link is free (no unacked frame outstanding).
+static uint8_t port_in_flight(port_t* pt) {
+    if(pt->windowed) {
+        return frame_window_in_flight(&pt->window);
+    }
+    return frame_arq_awaiting_ack(pt->handle)?1:0;
+}
+static bool port_can_put(port_t* pt) {
+    if(pt->windowed) {
+        return frame_window_in_flight(&pt->window) < pt->window.window;
+    }
+    return !frame_arq_awaiting_ack(pt->handle);
+}
+// Receive on a port. Returns the cmd of a frame, or <= 0 for none
+static int port_get(port_t* pt, void** out_payload, size_t* out_length) {
+    const uint8_t in_flight = port_in_flight(pt);
+    int res;
+    if(pt->windowed) {
+        res = frame_window_get(&pt->window, out_payload, out_length);
+    } else {
+        res = frame_arq_get(pt->handle, out_payload, out_length);
+        if(res==FRAME_ARQ_RESEND_NEEDED) {
+            ++pt->retransmits;
+            frame_arq_resend(pt->handle);
+            pt->last_send = xTaskGetTickCount();
+            res = 0;
+        }
+    }
+    if(res>0 || port_in_flight(pt)<in_flight) {
+        pt->live_ts = xTaskGetTickCount();
+    }
+    if(port_in_flight(pt)<in_flight) {
+        // the ACK timer now runs for the oldest frame still in flight
+        pt->last_send = pt->live_ts;
+    }
+    return res;
+}
+// Switch to the window CMD_WINDOW asked for, once its ACK has been flushed.
+// Whatever frame_arq had in flight is dropped. The device only sends requests
+// it repeats anyway
+static void port_apply_window(port_t* pt) {
+    if(pt->window_pending==0) {
+        return;
+    }
+    frame_arq_reset(pt->handle);
+    frame_window_reset(&pt->window, pt->window_pending, CMD_WINDOW);
+    pt->windowed = true;
+    pt->window_pending = 0;
+#ifdef TRACE_FRAMES
+    pt->trace_in_seq = pt->trace_out_seq = 0;
+#endif
+}
+// Back to stop-and-wait, for when the link has gone away
+static void port_reset(port_t* pt) {
+    frame_arq_reset(pt->handle);
+    pt->windowed = false;
+    pt->window_pending = 0;
+    pt->pending = false;
+#ifdef TRACE_FRAMES
+    pt->trace_in_seq = pt->trace_out_seq = 0;
+#endif
+}
+// Flush a staged frame once the link has room (in stop-and-wait, no unacked
+// frame outstanding).
 static void pump_send(port_t* pt) {
-    if(pt->pending && !frame_arq_awaiting_ack(pt->handle)) {
-        int r = frame_arq_put(pt->handle, pt->stage_cmd, pt->stage_buf, pt->stage_len);
-        if(r == FRAME_ARQ_SUCCESS) {
+    if(pt->pending && port_can_put(pt)) {
+        const bool idle = port_in_flight(pt)==0;
+        bool sent, busy;
+        if(pt->windowed) {
+            int r = frame_window_put(&pt->window, pt->stage_cmd, pt->stage_buf, pt->stage_len);
+            sent = r == FRAME_WINDOW_SUCCESS;
+            busy = r == FRAME_WINDOW_ERROR_BUSY;
+        } else {
+            int r = frame_arq_put(pt->handle, pt->stage_cmd, pt->stage_buf, pt->stage_len);
+            sent = r == FRAME_ARQ_SUCCESS;
+            busy = r == FRAME_ARQ_ERROR_BUSY;
+        }
+        if(sent) {
+#ifdef TRACE_FRAMES
+            trace_frame(pt, FRAME_TRACE_OUT, pt->stage_cmd, pt->stage_buf, pt->stage_len);
+#endif
             pt->pending = false;
-            pt->last_send = xTaskGetTickCount();
-        } else if(r == FRAME_ARQ_ERROR_BUSY) {
+            // the ACK timer runs for the oldest frame in flight
+            if(idle) {
+                pt->last_send = xTaskGetTickCount();
+            }
+        } else if(busy) {
             // still awaiting; leave staged and retry next loop
         } else {
             pt->pending = false; // unexpected (e.g. oversized); drop rather than spin
         }
+        pt->flush();
     }
 }
 // Caller-owned retransmit timer. Never gives up / never advances the sequence.
+// In window mode it resends the oldest unacked frame only
 static void service_retransmit(port_t* pt) {
-    if(frame_arq_awaiting_ack(pt->handle) &&
+    if(port_in_flight(pt) &&
        (uint32_t)(xTaskGetTickCount() - pt->last_send) >= pdMS_TO_TICKS(ACK_TIMEOUT_MS)) {
-        frame_arq_resend(pt->handle);
+        if(pt->windowed) {
+            frame_window_resend(&pt->window);
+        } else {
+            ++pt->retransmits;
+            frame_arq_resend(pt->handle);
+        }
         pt->last_send = xTaskGetTickCount();
+        pt->flush();
     }
 }
 
@@ -207,6 +430,36 @@ static void write_data_req(port_t* pt,int index) {
         stage(pt,CMD_DATA,write_buffer,res,false);
     }
 }
+static void write_subscribe(port_t* pt,int index) {
+    request_subscribe_t req;
+    req.screen_index = index;
+    req.interval_ms = SUBSCRIBE_INTERVAL_MS;
+    buffer_cursor_t cur = {write_buffer,sizeof(write_buffer)};
+    int res = request_subscribe_write(&req,on_write_buffer,&cur);
+    if(-1<res) {
+        // the host won't push until it has this, so priority
+        stage(pt,CMD_SUBSCRIBE,write_buffer,res,true);
+    }
+}
+// Asks for the current screen's data: once by subscribing, or every tick
+// when the host doesn't push
+static void request_data(port_t* pt) {
+    if(!subscribe_unsupported) {
+        if(subscribed_index!=screen_index) {
+            write_subscribe(pt,screen_index);
+            subscribed_index = screen_index;
+            subscribe_ts = xTaskGetTickCount();
+            return;
+        }
+        if((uint32_t)(xTaskGetTickCount() - subscribe_ts) < pdMS_TO_TICKS(SUBSCRIBE_TIMEOUT_MS)) {
+            return;
+        }
+        ESP_LOGW(TAG, "No data pushed. Polling");
+        subscribe_unsupported = true;
+        subscribed_index = -1;
+    }
+    write_data_req(pt,screen_index);
+}
 static void write_nop(port_t* pt) {
     request_nop_t req;
     buffer_cursor_t cur = {write_buffer,sizeof(write_buffer)};
@@ -215,6 +468,93 @@ static void write_nop(port_t* pt) {
         stage(pt,CMD_NOP,write_buffer,res,false);
     }
 }
+// What the render loop measured since the IO task last sent CMD_STATS
+typedef struct {
+    uint32_t frames;
+    uint32_t render_min_us;
+    uint64_t render_total_us;
+    uint32_t render_us[STATS_SAMPLES];
+    uint32_t flush_bytes;
+    uint32_t flush_stalls;
+} render_stats_t;
+static render_stats_t render_stats;
+static portMUX_TYPE render_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+// render task only. espmon_flush() adds to this during a refresh
+static uint32_t frame_flush_bytes = 0;
+static size_t frame_flush_stalls = 0;
+static void stats_frame(uint32_t render_us) {
+    const size_t stalls = app.flush_stalls();
+    taskENTER_CRITICAL(&render_stats_lock);
+    if(render_stats.frames==0 || render_us<render_stats.render_min_us) {
+        render_stats.render_min_us = render_us;
+    }
+    render_stats.render_total_us += render_us;
+    render_stats.render_us[render_stats.frames%STATS_SAMPLES] = render_us;
+    ++render_stats.frames;
+    render_stats.flush_bytes += frame_flush_bytes;
+    render_stats.flush_stalls += (uint32_t)(stalls-frame_flush_stalls);
+    taskEXIT_CRITICAL(&render_stats_lock);
+    frame_flush_bytes = 0;
+    frame_flush_stalls = stalls;
+}
+// Takes the render loop's numbers, adds the link's and the heap's, and sends
+// them. Counts are since the last call
+static void write_stats(port_t* pt, uint32_t interval_ms) {
+    // the IO task's copy of the render times, sorted for the p99
+    static uint32_t render_us[STATS_SAMPLES];
+    // the since-boot counts as of the last call
+    static request_stats_port_t sent_port1 = {0,0};
+    static request_stats_port_t sent_port2 = {0,0};
+    static uint32_t sent_overflows = 0;
+    request_stats_t stats;
+    memset(&stats,0,sizeof(stats));
+    stats.interval_ms = interval_ms;
+    uint64_t render_total_us;
+    taskENTER_CRITICAL(&render_stats_lock);
+    stats.frames = render_stats.frames;
+    stats.render_min_us = render_stats.render_min_us;
+    render_total_us = render_stats.render_total_us;
+    stats.flush_bytes = render_stats.flush_bytes;
+    stats.flush_stalls = render_stats.flush_stalls;
+    const size_t samples = stats.frames<STATS_SAMPLES?stats.frames:STATS_SAMPLES;
+    memcpy(render_us,render_stats.render_us,samples*sizeof(uint32_t));
+    render_stats.frames = 0;
+    render_stats.render_total_us = 0;
+    render_stats.flush_bytes = 0;
+    render_stats.flush_stalls = 0;
+    taskEXIT_CRITICAL(&render_stats_lock);
+    if(samples>0) {
+        stats.render_avg_us = (uint32_t)(render_total_us/stats.frames);
+        // nearest rank
+        const size_t rank = (samples*99+99)/100-1;
+        std::nth_element(render_us,render_us+rank,render_us+samples);
+        stats.render_p99_us = render_us[rank];
+    }
+    const request_stats_port_t port1_total = {port1.retransmits+port1.window.resends,port1.window.nacks_sent};
+    stats.port1.retransmits = port1_total.retransmits-sent_port1.retransmits;
+    stats.port1.nacks = port1_total.nacks-sent_port1.nacks;
+    sent_port1 = port1_total;
+#ifdef HAS_SERIAL2
+    const request_stats_port_t port2_total = {port2.retransmits+port2.window.resends,port2.window.nacks_sent};
+    stats.port2.retransmits = port2_total.retransmits-sent_port2.retransmits;
+    stats.port2.nacks = port2_total.nacks-sent_port2.nacks;
+    sent_port2 = port2_total;
+#else
+    (void)sent_port2;
+#endif
+    const uint32_t overflows = serial_rx_overflows();
+    stats.rx_overflows = overflows-sent_overflows;
+    sent_overflows = overflows;
+    stats.free_heap = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    stats.largest_free_block = heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
+    stats.free_psram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    stats.largest_free_psram = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+    buffer_cursor_t cur = {write_buffer,sizeof(write_buffer)};
+    int res = request_stats_write(&stats,on_write_buffer,&cur);
+    if(-1<res) {
+        stage(pt,CMD_STATS,write_buffer,res,false);
+    }
+}
 
 #ifdef HAS_INPUT
 // Feed the raw "is a contact present right now" signal each poll. Returns true
@@ -256,7 +596,7 @@ static void update_input(port_t* pt) {
     if(panel_button_read_all()) raw_down = true;
 #endif
     if(input_released(raw_down)) {
-        if(app.connected() && !screen_change_pending) {
+        if(link_connected && !screen_change_pending) {
             ++screen_index;
             screen_change_pending = true;
             screen_change_ts = xTaskGetTickCount();
@@ -265,39 +605,72 @@ static void update_input(port_t* pt) {
     }
 }
 #endif
+// hands a decoded packet to the render loop. The IO task only reads frames
+// while there's room, so this doesn't fail
+static void queue_packet(command_t cmd, const response_t& resp) {
+    if(packet_queue_put(&packets,cmd,&resp)) {
+        xTaskNotifyGive(render_task);
+    } else {
+        ESP_LOGE(TAG, "PACKET QUEUE FULL");
+    }
+}
+// the payload is already contiguous, so it's decoded in place with the
+// _read_span() functions rather than a byte at a time through a callback
 static void process_frame(port_t* pt, uint8_t cmd, void* p, size_t len) {
-    buffer_cursor_t cur = {(uint8_t*)p,len};
     response_t resp;
     int res;
+#ifdef TRACE_FRAMES
+    trace_frame(pt, FRAME_TRACE_IN, cmd, p, len);
+#endif
     switch(cmd) {
         case CMD_NOP:
             break;
         case CMD_SCREEN:
-            if(-1<response_screen_read(&resp.screen,on_read_buffer,&cur)) {
+            if(-1<response_screen_read_span(&resp.screen,p,len)) {
                 screen_index = resp.screen.header.index;
                 screen_change_pending = false;
-                app.accept_packet((command_t)cmd,resp,false);
+                queue_packet((command_t)cmd,resp);
             } else {
                 ESP_LOGE(TAG, "CMD_SCREEN READ ERROR");
             }
             break;
         case CMD_DATA:
-            if(-1<response_data_read(&resp.data,on_read_buffer,&cur)) {
-                app.accept_packet((command_t)cmd,resp,false);
+            if(-1<response_data_read_span(&resp.data,p,len)) {
+                subscribe_ts = xTaskGetTickCount();
+                data_delta_key(&data_baseline,&resp.data);
+                queue_packet((command_t)cmd,resp);
             } else {
                 ESP_LOGE(TAG, "CMD_DATA READ ERROR");
             }
             break;
+        case CMD_DATA_DELTA: {
+            response_data_delta_t delta;
+            if(-1<response_data_delta_read_span(&delta,p,len)) {
+                subscribe_ts = xTaskGetTickCount();
+                if(data_delta_apply(&data_baseline,&delta,&resp.data)) {
+                    queue_packet(CMD_DATA,resp);
+                } else {
+                    ESP_LOGE(TAG, "CMD_DATA_DELTA APPLY ERROR");
+                }
+            } else {
+                ESP_LOGE(TAG, "CMD_DATA_DELTA READ ERROR");
+            }
+            break;
+        }
         case CMD_CLEAR:
-            if(-1<response_clear_read(&resp.clear,on_read_buffer,&cur)) {
-                app.accept_packet((command_t)cmd,resp,false);
+            if(-1<response_clear_read_span(&resp.clear,p,len)) {
+                queue_packet((command_t)cmd,resp);
             } else {
                 ESP_LOGE(TAG, "CMD_CLEAR READ ERROR");
             }
             break;
         case CMD_IDENT:
-            if(-1<response_ident_read(&resp.ident,on_read_buffer,&cur)) {
+            if(-1<response_ident_read_span(&resp.ident,p,len)) {
                 request_ident_t ident = FIRMWARE_INFO();
+                // only the UART has a real rate. USB CDC/JTAG ignores it
+                ident.max_baud = (pt==&port1)?SERIAL_MAX_BAUD:0;
+                ident.max_window = FRAME_WINDOW_SIZE;
+                ident.data_delta = true;
                 buffer_cursor_t write_cur = {(uint8_t*)write_buffer,sizeof(write_buffer)};
                 res = request_ident_write(&ident,on_write_buffer,&write_cur);
                 if(-1<res) {
@@ -308,8 +681,28 @@ static void process_frame(port_t* pt, uint8_t cmd, void* p, size_t len) {
                 ESP_LOGE(TAG, "CMD_IDENT READ ERROR");
             }
             break;
+        case CMD_BAUD:
+            if(-1<response_baud_read_span(&resp.baud,p,len)) {
+                if(pt==&port1 && resp.baud.baud>=SERIAL_DEFAULT_BAUD && resp.baud.baud<=SERIAL_MAX_BAUD) {
+                    baud_pending = resp.baud.baud;
+                } else {
+                    ESP_LOGE(TAG, "CMD_BAUD %lu NOT SUPPORTED", (unsigned long)resp.baud.baud);
+                }
+            } else {
+                ESP_LOGE(TAG, "CMD_BAUD READ ERROR");
+            }
+            break;
+        case CMD_WINDOW:
+            if(-1<response_window_read_span(&resp.window,p,len)) {
+                if(!pt->windowed && resp.window.size>1) {
+                    pt->window_pending = resp.window.size>FRAME_WINDOW_SIZE?FRAME_WINDOW_SIZE:resp.window.size;
+                }
+            } else {
+                ESP_LOGE(TAG, "CMD_WINDOW READ ERROR");
+            }
+            break;
         case CMD_REFRESH_SCREEN:
-            if(-1<response_refresh_screen_read(&resp.refresh_screen,on_read_buffer,&cur)) {
+            if(-1<response_refresh_screen_read_span(&resp.refresh_screen,p,len)) {
                 screen_index = -1;
                 screen_change_pending = false;
             } else {
@@ -322,7 +715,9 @@ static void process_frame(port_t* pt, uint8_t cmd, void* p, size_t len) {
         
     }
 }
-// called when the pixel transfer from a single flush is complete
+// called when the pixel transfer from a single flush is complete. They
+// complete in the order they were made, which is how the display knows which
+// of its transfer buffers is free again
 extern "C" IRAM_ATTR void panel_lcd_flush_complete() {
 #if !(LCD_BUS == PANEL_BUS_MIPI || LCD_BUS == PANEL_BUS_RGB)
     app.transfer_complete();
@@ -330,8 +725,44 @@ extern "C" IRAM_ATTR void panel_lcd_flush_complete() {
 }
 // called when a frame is done being sent via DMA
 #if LCD_BUS == PANEL_BUS_MIPI || LCD_BUS == PANEL_BUS_RGB
+// vsyncs so far, and whether the render loop wants to hear about the next one
+static volatile uint32_t vsync_count = 0;
+static volatile bool vsync_wanted = false;
 extern "C" IRAM_ATTR void panel_lcd_on_vsync() {
     app.transfer_complete();
+    vsync_count = vsync_count + 1;
+    if(vsync_wanted) {
+        vsync_wanted = false;
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(render_task,&woken);
+        portYIELD_FROM_ISR(woken);
+    }
+}
+static uint32_t painted_vsync = 0;
+static bool frame_slot_open() {
+    return vsync_count!=painted_vsync;
+}
+static void frame_slot_take() {
+    painted_vsync = vsync_count;
+}
+// how long to sleep until the slot opens. The vsync wakes the loop sooner
+static TickType_t frame_slot_wait() {
+    vsync_wanted = true;
+    return pdMS_TO_TICKS(100);
+}
+#else
+#define FRAME_SLOT_US (1000000/RENDER_MAX_FPS)
+static int64_t painted_us = -FRAME_SLOT_US;
+static bool frame_slot_open() {
+    return esp_timer_get_time()-painted_us>=FRAME_SLOT_US;
+}
+static void frame_slot_take() {
+    painted_us = esp_timer_get_time();
+}
+static TickType_t frame_slot_wait() {
+    const int64_t remaining_us = FRAME_SLOT_US-(esp_timer_get_time()-painted_us);
+    const TickType_t ticks = pdMS_TO_TICKS((uint32_t)((remaining_us+999)/1000));
+    return ticks>0?ticks:1;
 }
 #endif
 
@@ -344,39 +775,110 @@ extern "C" IRAM_ATTR void panel_lcd_on_vsync() {
 #define ESPMON_FB_COUNT LCD_FRAMEBUFFER_COUNT
 #endif
 
-// Push dirty cache lines for rows [y1..y2] out to PSRAM so the LCD DMA sees
-// them. C2M (writeback) only - nothing but the CPU ever writes the FB, so no
-// invalidate is ever needed. No-op on targets whose PSRAM cache is write-through.
-static inline void espmon_fb_writeback(const void* fb, int y1, int y2) {
+// Push the cache lines the CPU dirtied this frame out to PSRAM so the LCD DMA
+// sees them. C2M (writeback) only - nothing but the CPU ever writes the FB, so
+// no invalidate is ever needed. No-op on targets whose PSRAM cache is
+// write-through.
+// uix flushes the whole screen in direct mode, so what actually changed comes
+// from app.frame_rects() (what was painted) and app.frame_copied_rows() (what
+// was copied in from the other framebuffer). They are turned into byte ranges
+// and sorted, ranges close enough together are merged, and each one left is
+// one msync. A narrow rect is written back a row at a time, only the cache
+// lines its columns touch, when that costs less than its full rows.
 #if CONFIG_IDF_TARGET_ESP32S3 || CONFIG_IDF_TARGET_ESP32P4
-    if (esp_ptr_external_ram(fb)) {
-        const size_t stride = (size_t)LCD_WIDTH * 2;   // RGB565
-        void*  start = (void*)(((uint8_t*)fb) + (size_t)y1 * stride);
-        size_t len   = (size_t)(y2 - y1 + 1) * stride;
-        ESP_ERROR_CHECK(esp_cache_msync(start, len,
+// About what one msync costs over the bytes it writes back
+#define ESPMON_MSYNC_CALL_BYTES 256
+#define ESPMON_MSYNC_MAX_RANGES 256
+typedef struct {
+    size_t offset;
+    size_t end;
+} fb_range_t;
+static fb_range_t fb_ranges[ESPMON_MSYNC_MAX_RANGES];
+static size_t fb_line_size = 0;
+#endif
+static void espmon_fb_writeback(const void* fb, const rect16& bounds) {
+#if CONFIG_IDF_TARGET_ESP32S3 || CONFIG_IDF_TARGET_ESP32P4
+    if (!esp_ptr_external_ram(fb)) {
+        return;
+    }
+    if (fb_line_size == 0) {
+        if (ESP_OK != esp_cache_get_alignment(MALLOC_CAP_SPIRAM, &fb_line_size) || fb_line_size == 0) {
+            fb_line_size = 64;
+        }
+    }
+    const size_t stride = (size_t)LCD_WIDTH * 2;   // RGB565
+    const size_t fb_size = stride * LCD_HEIGHT;
+    const size_t line = fb_line_size;
+    size_t count = 0;
+    const auto add_rows = [&](int y1, int y2) {
+        if (count == ESPMON_MSYNC_MAX_RANGES) {
+            // full up. Widen the last one to cover these rows too
+            fb_ranges[count - 1].offset = std::min(fb_ranges[count - 1].offset, (size_t)y1 * stride);
+            fb_ranges[count - 1].end = std::max(fb_ranges[count - 1].end, (size_t)(y2 + 1) * stride);
+            return;
+        }
+        fb_ranges[count++] = {(size_t)y1 * stride, (size_t)(y2 + 1) * stride};
+    };
+    const damage_list& rects = app.frame_rects();
+    const row_spans& copied = app.frame_copied_rows();
+    if (rects.size() == 0 && copied.size() == 0) {
+        // nothing tracked the frame, so take the flush at its word
+        add_rows(bounds.y1, bounds.y2);
+    }
+    for (size_t i = 0; i < copied.size(); ++i) {
+        add_rows(copied.y1(i), copied.y2(i));
+    }
+    for (size_t i = 0; i < rects.size(); ++i) {
+        const rect16& r = rects[i];
+        const size_t rows = (size_t)r.height();
+        const size_t x1 = ((size_t)r.x1 * 2) / line * line;
+        const size_t x2 = std::min(stride, (((size_t)r.x2 + 1) * 2 + line - 1) / line * line);
+        if (rows * (x2 - x1 + ESPMON_MSYNC_CALL_BYTES) >= rows * stride + ESPMON_MSYNC_CALL_BYTES ||
+            count + rows > ESPMON_MSYNC_MAX_RANGES) {
+            add_rows(r.y1, r.y2);
+            continue;
+        }
+        for (size_t y = r.y1; y <= r.y2; ++y) {
+            fb_ranges[count++] = {y * stride + x1, y * stride + x2};
+        }
+    }
+    std::sort(fb_ranges, fb_ranges + count, [](const fb_range_t& lhs, const fb_range_t& rhs) {
+        return lhs.offset < rhs.offset;
+    });
+    size_t i = 0;
+    while (i < count) {
+        const size_t offset = fb_ranges[i].offset / line * line;
+        size_t end = fb_ranges[i].end;
+        // writing back a few clean lines in between costs less than another call
+        while (++i < count && fb_ranges[i].offset <= end + ESPMON_MSYNC_CALL_BYTES) {
+            end = std::max(end, fb_ranges[i].end);
+        }
+        end = std::min(fb_size, (end + line - 1) / line * line);
+        ESP_ERROR_CHECK(esp_cache_msync(((uint8_t*)fb) + offset, end - offset,
             ESP_CACHE_MSYNC_FLAG_DIR_C2M | ESP_CACHE_MSYNC_FLAG_UNALIGNED));
     }
 #else
-    (void)fb; (void)y1; (void)y2;
+    (void)fb; (void)bounds;
 #endif
 }
 #endif  // MIPI || RGB
 
 static void espmon_flush(const rect16& bounds, const void* bmp, void* state) {
+    frame_flush_bytes += ((uint32_t)bounds.width()*bounds.height()*LCD_BIT_DEPTH+7)/8;
 #if LCD_BUS == PANEL_BUS_MIPI || LCD_BUS == PANEL_BUS_RGB
 
 #if ESPMON_FB_COUNT == 1
     // Single framebuffer: it IS the scanout buffer. Once the writeback lands,
     // the pixels are on screen. Nothing to recycle, nothing to wait for, so
     // completion is synchronous.
-    espmon_fb_writeback(bmp, bounds.y1, bounds.y2);
+    espmon_fb_writeback(bmp, bounds);
     app.transfer_complete();
 #else
     // Multiple framebuffers: we rendered into a hidden buffer. Writeback first
     // (DMA must not read stale lines), then retarget scanout at it. The swap
     // lands at the next VSYNC, so completion is NOT signalled here - the
     // on_vsync handler calls app.transfer_complete() once the swap is live.
-    espmon_fb_writeback(bmp, bounds.y1, bounds.y2);
+    espmon_fb_writeback(bmp, bounds);
     panel_lcd_flush(0, 0, LCD_WIDTH - 1, LCD_HEIGHT - 1, (void*)bmp);
 #endif
 
@@ -419,6 +921,133 @@ static void log_heap(const char* tag) {
     return;
 }
 #endif
+// Everything on the wire: the ports, the ARQ, retransmits and input
+static void io_task(void* arg) {
+    (void)arg;
+    TickType_t send_ts = 0;
+    TickType_t stats_ts = xTaskGetTickCount();
+    // the render loop hasn't been told the link dropped yet
+    bool disconnect_pending = false;
+    void* p;
+    size_t len;
+    while(1) {
+        if(disconnect_ts>0 && xTaskGetTickCount()>=disconnect_ts+pdMS_TO_TICKS(5000)) {
+            disconnect_pending = true;
+            link_connected = false;
+            disconnect_ts = 0;
+            screen_index=-1;
+            screen_change_pending = false;
+            // Link is dead. Reset ARQ state so a reconnect that does NOT reboot the
+            // MCU (native USB CDC) still realigns sequence numbers. Only fires after
+            // 5s of no frames, so it can't disturb a live link. The active handle
+            // stays pinned to whichever port connected first (until reboot).
+            // The host reopens it in stop-and-wait, at the default rate.
+            port_reset(&port1);
+            baud_pending = 0;
+            serial_set_baud(SERIAL_DEFAULT_BAUD);
+            subscribed_index = -1;
+            subscribe_unsupported = false;
+#ifdef HAS_SERIAL2
+            port_reset(&port2);
+#endif
+        }
+        if(disconnect_pending && packet_queue_can_put(&packets)) {
+            response_t resp = {};
+            queue_packet(CMD_NONE,resp);
+            disconnect_pending = false;
+        }
+        // frames stay in the port (and unacked) while the render loop is
+        // too far behind to take what they decode to
+        const bool can_put = !disconnect_pending && packet_queue_can_put(&packets);
+        bool received = false;
+        int res = can_put?port_get(&port1,&p,&len):0;
+        if(res>0) {
+            received = true;
+            if(!active_pinned) { active = &port1; active_pinned = true; }
+            link_connected = true;
+            disconnect_ts = xTaskGetTickCount();
+            process_frame(&port1,(uint8_t)res,p,len);
+        }
+        // the ACK, or the resent frame
+        port1.flush();
+        port_apply_window(&port1);
+        if(baud_pending!=0) {
+            // the ACK for CMD_BAUD went out at the old rate above
+            serial_set_baud(baud_pending);
+            baud_pending = 0;
+            port1.live_ts = xTaskGetTickCount();
+        } else if(serial_baud()!=SERIAL_DEFAULT_BAUD &&
+                  (uint32_t)(xTaskGetTickCount() - port1.live_ts) >= pdMS_TO_TICKS(BAUD_FALLBACK_MS)) {
+            ESP_LOGW(TAG, "No traffic at %lu baud. Falling back", (unsigned long)serial_baud());
+            serial_set_baud(SERIAL_DEFAULT_BAUD);
+        }
+#ifdef HAS_SERIAL2
+        res = can_put?port_get(&port2,&p,&len):0;
+        if(res>0) {
+            received = true;
+            if(!active_pinned) { active = &port2; active_pinned = true; }
+            link_connected = true;
+            disconnect_ts = xTaskGetTickCount();
+            process_frame(&port2,(uint8_t)res,p,len);
+        }
+        // the ACK, or the resent frame
+        port2.flush();
+        port_apply_window(&port2);
+#endif
+
+        if(xTaskGetTickCount()>send_ts+pdMS_TO_TICKS(100)) {
+            send_ts = xTaskGetTickCount();
+            if(screen_index==-1) {
+                write_nop(active);
+            } else {
+                if(res!=CMD_REFRESH_SCREEN) {
+                    if(link_connected) {
+                        request_data(active);
+                    } else {
+                        write_nop(active);
+                    }
+                } else {
+                    write_screen_req(active,screen_index);
+                }
+            }
+        }
+
+        // never in place of a send that's already waiting
+        if(link_connected && !active->pending &&
+           (uint32_t)(xTaskGetTickCount() - stats_ts) >= pdMS_TO_TICKS(STATS_INTERVAL_MS)) {
+            write_stats(active,pdTICKS_TO_MS(xTaskGetTickCount() - stats_ts));
+            stats_ts = xTaskGetTickCount();
+        }
+        // Flush staged sends and service retransmits on both ports, so an ident
+        // reply left pending on the non-active port still gets delivered.
+        pump_send(&port1);
+        service_retransmit(&port1);
+#ifdef HAS_SERIAL2
+        pump_send(&port2);
+        service_retransmit(&port2);
+#endif
+        if(screen_change_pending &&
+           (uint32_t)(xTaskGetTickCount() - screen_change_ts) >= pdMS_TO_TICKS(SCREEN_CHANGE_TIMEOUT_MS)) {
+            screen_change_pending = false;
+        }
+#ifdef LOG_HEAP
+        static TickType_t log_ts = 0;
+        if((uint32_t)(xTaskGetTickCount() - log_ts) >= pdMS_TO_TICKS(5000)) {
+            log_ts = xTaskGetTickCount();
+            log_heap("Running");
+        }
+#endif
+
+#ifdef HAS_INPUT
+        update_input(active);
+#endif
+        if(!received) {
+            // the drivers don't block, so give the rest of the core a turn.
+            // serial_init() sizes the UART's buffer to cover the wait
+            vTaskDelay(1);
+        }
+    }
+}
 extern "C" void app_main() {
     log_heap("On boot");
 #ifdef POWER
@@ -450,6 +1079,16 @@ extern "C" void app_main() {
     port1.pending = false;
     port1.priority = false;
     port1.last_send = 0;
+    port1.flush = serial_flush;
+    frame_window_init(&port1.window,FRAME_WINDOW_SIZE,INTERFACE_MAX_SIZE,port1.window_buf,serial_read,nullptr,serial_write,nullptr);
+    port1.windowed = false;
+    port1.window_pending = 0;
+    port1.live_ts = 0;
+    port1.retransmits = 0;
+#ifdef TRACE_FRAMES
+    port1.trace_in_seq = 0;
+    port1.trace_out_seq = 0;
+#endif
 #ifdef HAS_SERIAL2
     if(!serial2_init(INTERFACE_MAX_SIZE)) {
         ESP_LOGE(TAG,"Serial2 could not be initialized");
@@ -463,8 +1102,21 @@ extern "C" void app_main() {
     port2.pending = false;
     port2.priority = false;
     port2.last_send = 0;
+    port2.flush = serial2_flush;
+    frame_window_init(&port2.window,FRAME_WINDOW_SIZE,INTERFACE_MAX_SIZE,port2.window_buf,serial2_read,nullptr,serial2_write,nullptr);
+    port2.windowed = false;
+    port2.window_pending = 0;
+    port2.live_ts = 0;
+    port2.retransmits = 0;
+#ifdef TRACE_FRAMES
+    port2.trace_in_seq = 0;
+    port2.trace_out_seq = 0;
+#endif
 #endif
     log_heap("After serial init");
+#ifdef TRACE_FRAMES
+    trace_init();
+#endif
     active = &port1;
     active_pinned = false;
     app.dimensions({LCD_WIDTH,LCD_HEIGHT});
@@ -478,98 +1130,85 @@ extern "C" void app_main() {
 #define DIRECT_MODE 0
 #endif
 #endif
+#if defined(LCD_TRANSFER_BUFFERS) && DIRECT_MODE == 0
+    static uint8_t* transfer_buffers[LCD_TRANSFER_BUFFERS];
+    size_t transfer_buffer_count = 2;
+    transfer_buffers[0] = LCD_BUFFER1;
+    transfer_buffers[1] = LCD_BUFFER2;
+    while(transfer_buffer_count<LCD_TRANSFER_BUFFERS) {
+        uint8_t* buf = (uint8_t*)heap_caps_malloc(LCD_STRIP_SIZE,MALLOC_CAP_DMA);
+        if(buf==nullptr) {
+            ESP_LOGW(TAG, "Only room for %d transfer buffers",(int)transfer_buffer_count);
+            break;
+        }
+        transfer_buffers[transfer_buffer_count++]=buf;
+    }
+    app.set_transfer_buffers(transfer_buffers,transfer_buffer_count,LCD_STRIP_SIZE);
+#else
     app.set_transfer((DIRECT_MODE)?screen_update_mode::direct:screen_update_mode::partial,LCD_BUFFER1,LCD_TRANSFER_SIZE!=0?LCD_TRANSFER_SIZE:(LCD_HRES*LCD_VRES*LCD_BIT_DEPTH+7)/8,LCD_BUFFER2);
+#endif
     app.has_graph(LCD_HEIGHT>64);
     app.is_monochrome(LCD_BIT_DEPTH==1);
+#ifdef CONFIG_SPIRAM
+    // keep the graph in an offscreen bitmap and scroll it
+    app.graph_scrolling(true);
+#endif
     app.initialize();
+    data_delta_init(&data_baseline);
     log_heap("After app init");
-    TickType_t send_ts = 0;
-    bool connected = false;
-    void* p;
-    size_t len;
-    while(1) {
-        if(disconnect_ts>0 && xTaskGetTickCount()>=disconnect_ts+pdMS_TO_TICKS(5000)) {
-            app.disconnect();
-            connected = false;
-            disconnect_ts = 0;
-            screen_index=-1;
-            screen_change_pending = false;
-            // Link is dead. Reset ARQ state so a reconnect that does NOT reboot the
-            // MCU (native USB CDC) still realigns sequence numbers. Only fires after
-            // 5s of no frames, so it can't disturb a live link. The active handle
-            // stays pinned to whichever port connected first (until reboot).
-            frame_arq_reset(port1.handle);
-            port1.pending = false;
-#ifdef HAS_SERIAL2
-            frame_arq_reset(port2.handle);
-            port2.pending = false;
-#endif
-        }
-        int res = frame_arq_get(port1.handle,&p,&len);
-        if(res==FRAME_ARQ_RESEND_NEEDED) {
-            frame_arq_resend(port1.handle);
-            port1.last_send = xTaskGetTickCount();
-        } else if(res>0) {
-            if(!active_pinned) { active = &port1; active_pinned = true; }
-            connected = true;
-            disconnect_ts = xTaskGetTickCount();
-            process_frame(&port1,(uint8_t)res,p,len);
-        }
-#ifdef HAS_SERIAL2
-        res = frame_arq_get(port2.handle,&p,&len);
-        if(res==FRAME_ARQ_RESEND_NEEDED) {
-            frame_arq_resend(port2.handle);
-            port2.last_send = xTaskGetTickCount();
-        } else if(res>0) {
-            if(!active_pinned) { active = &port2; active_pinned = true; }
-            connected = true;
-            disconnect_ts = xTaskGetTickCount();
-            process_frame(&port2,(uint8_t)res,p,len);
-        }
+    packet_queue_init(&packets);
+    render_task = xTaskGetCurrentTaskHandle();
+#if CONFIG_FREERTOS_UNICORE
+    const BaseType_t io_core = tskNO_AFFINITY;
+#else
+    const BaseType_t io_core = xPortGetCoreID()==0?1:0;
 #endif
-        app.refresh(true);
-        
-        if(xTaskGetTickCount()>send_ts+pdMS_TO_TICKS(100)) {
-            send_ts = xTaskGetTickCount();
-            if(screen_index==-1) {
-                write_nop(active);
-            } else {
-                if(res!=CMD_REFRESH_SCREEN) {
-                    if(connected) {
-                        write_data_req(active,screen_index);
-                    } else {
-                        write_nop(active);
-                    }
-                } else {
-                    write_screen_req(active,screen_index);
+    if(pdPASS!=xTaskCreatePinnedToCore(io_task,"espmon_io",IO_TASK_STACK_SIZE,nullptr,IO_TASK_PRIORITY,nullptr,io_core)) {
+        ESP_LOGE(TAG,"IO task could not be created");
+        while(1) vTaskDelay(5);
+    }
+    command_t cmd;
+    response_t resp;
+    // the latest data frame, held for the next frame slot
+    response_t data;
+    bool data_pending = false;
+    while(1) {
+        while(packet_queue_get(&packets,&cmd,&resp)) {
+            if(cmd==CMD_DATA) {
+                if(data_pending) {
+                    app.fold_data(data.data);
                 }
+                data = resp;
+                data_pending = true;
+                continue;
+            }
+            // anything else is applied in order, right away
+            if(data_pending) {
+                app.accept_packet(CMD_DATA,data,false);
+                data_pending = false;
+            }
+            if(cmd==CMD_NONE) {
+                app.disconnect();
+            } else {
+                app.accept_packet(cmd,resp,false);
             }
-            vTaskDelay(5);
-        }
-
-        // Flush staged sends and service retransmits on both ports, so an ident
-        // reply left pending on the non-active port still gets delivered.
-        pump_send(&port1);
-        service_retransmit(&port1);
-#ifdef HAS_SERIAL2
-        pump_send(&port2);
-        service_retransmit(&port2);
-#endif
-        if(screen_change_pending &&
-           (uint32_t)(xTaskGetTickCount() - screen_change_ts) >= pdMS_TO_TICKS(SCREEN_CHANGE_TIMEOUT_MS)) {
-            screen_change_pending = false;
         }
-#ifdef LOG_HEAP
-        static TickType_t log_ts = 0;
-        if((uint32_t)(xTaskGetTickCount() - log_ts) >= pdMS_TO_TICKS(5000)) {
-            log_ts = xTaskGetTickCount();
-            log_heap("Running");
+        // until the IO task queues something
+        TickType_t wait = pdMS_TO_TICKS(100);
+        if(data_pending || app.is_dirty()) {
+            if(frame_slot_open()) {
+                frame_slot_take();
+                const int64_t render_start_us = esp_timer_get_time();
+                if(data_pending) {
+                    app.accept_packet(CMD_DATA,data,false);
+                    data_pending = false;
+                }
+                app.refresh(true);
+                stats_frame((uint32_t)(esp_timer_get_time()-render_start_us));
+            } else {
+                wait = frame_slot_wait();
+            }
         }
-#endif
-
-#ifdef HAS_INPUT
-        update_input(active);
-#endif
-        
+        ulTaskNotifyTake(pdTRUE,wait);
     }
 }
\ No newline at end of file
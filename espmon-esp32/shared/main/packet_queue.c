@@ -0,0 +1,133 @@
+#include "packet_queue.h"
+#include <string.h>
+
+#define PACKET_QUEUE_MASK (PACKET_QUEUE_SIZE - 1)
+#define PACKET_QUEUE_FOLD_MASK (PACKET_QUEUE_FOLD_SIZE - 1)
+#define PACKET_QUEUE_FRESH 0x80
+#define PACKET_QUEUE_INDEX 0x03
+
+_Static_assert((PACKET_QUEUE_SIZE & PACKET_QUEUE_MASK) == 0 && PACKET_QUEUE_SIZE >= 2,
+               "PACKET_QUEUE_SIZE must be a power of two");
+_Static_assert((PACKET_QUEUE_FOLD_SIZE & PACKET_QUEUE_FOLD_MASK) == 0,
+               "PACKET_QUEUE_FOLD_SIZE must be a power of two");
+
+// head and tail are each written by one side and read by the other. The
+// release store publishes the entry, and the acquire load on the other side
+// sees it whole. middle is swapped with acquire/release for the same reason
+static uint32_t load_acquire(const uint32_t* value) {
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+static void store_release(uint32_t* value, uint32_t new_value) {
+    __atomic_store_n(value, new_value, __ATOMIC_RELEASE);
+}
+static uint8_t swap_middle(packet_queue_t* queue, uint8_t value) {
+    return __atomic_exchange_n(&queue->data_middle, value, __ATOMIC_ACQ_REL);
+}
+static bool middle_fresh(const packet_queue_t* queue) {
+    return 0 != (__atomic_load_n(&queue->data_middle, __ATOMIC_ACQUIRE) & PACKET_QUEUE_FRESH);
+}
+void packet_queue_init(packet_queue_t* queue) {
+    memset(queue, 0, sizeof(*queue));
+    queue->data_back = 0;
+    queue->data_middle = 1;
+    queue->data_front = 2;
+}
+bool packet_queue_can_put(const packet_queue_t* queue) {
+    // a pending CMD_DATA may have to go in ahead of the packet
+    return queue->head - load_acquire(&queue->tail) + 2 <= PACKET_QUEUE_SIZE;
+}
+// keeps a CMD_DATA that was replaced before the consumer took it
+static void fold(packet_queue_t* queue, uint8_t index) {
+    const uint32_t head = queue->fold_head;
+    if (head - load_acquire(&queue->fold_tail) >= PACKET_QUEUE_FOLD_SIZE) {
+        ++queue->dropped;
+        return;
+    }
+    queue->fold[head & PACKET_QUEUE_FOLD_MASK] = queue->data[index];
+    queue->fold_seq[head & PACKET_QUEUE_FOLD_MASK] = queue->data_seq[index];
+    queue->fold_id[head & PACKET_QUEUE_FOLD_MASK] = queue->data_id[index];
+    store_release(&queue->fold_head, head + 1);
+}
+bool packet_queue_put(packet_queue_t* queue, command_t cmd, const response_t* resp) {
+    uint32_t head = queue->head;
+    if (cmd == CMD_DATA) {
+        // take middle back before publishing, so a CMD_DATA it held is folded
+        // before the consumer can see the one that replaces it
+        uint8_t index = swap_middle(queue, queue->data_back);
+        if (index & PACKET_QUEUE_FRESH) {
+            fold(queue, index & PACKET_QUEUE_INDEX);
+        }
+        index &= PACKET_QUEUE_INDEX;
+        queue->data[index] = resp->data;
+        queue->data_seq[index] = head;
+        queue->data_id[index] = queue->data_count++;
+        // back is either still in middle or the consumer's old front now.
+        // Either way it isn't being read
+        queue->data_back = swap_middle(queue, index | PACKET_QUEUE_FRESH) & PACKET_QUEUE_INDEX;
+        return true;
+    }
+    const uint32_t used = head - load_acquire(&queue->tail);
+    if (used >= PACKET_QUEUE_SIZE) {
+        return false;
+    }
+    if (middle_fresh(queue)) {
+        // the CMD_DATA put before this one has to come out before it, so
+        // take it back and queue it in order, unless the consumer beats us to it
+        if (used + 2 > PACKET_QUEUE_SIZE) {
+            return false;
+        }
+        const uint8_t prev = swap_middle(queue, queue->data_back);
+        if (prev & PACKET_QUEUE_FRESH) {
+            packet_queue_entry_t* entry = &queue->entries[head & PACKET_QUEUE_MASK];
+            entry->cmd = CMD_DATA;
+            entry->resp.data = queue->data[prev & PACKET_QUEUE_INDEX];
+            ++head;
+        }
+        queue->data_back = prev & PACKET_QUEUE_INDEX;
+    }
+    packet_queue_entry_t* entry = &queue->entries[head & PACKET_QUEUE_MASK];
+    entry->cmd = cmd;
+    entry->resp = *resp;
+    store_release(&queue->head, head + 1);
+    return true;
+}
+bool packet_queue_get(packet_queue_t* queue, command_t* out_cmd, response_t* out_resp) {
+    while (true) {
+        const uint32_t tail = queue->tail;
+        const uint32_t head = load_acquire(&queue->head);
+        // replaced CMD_DATA goes out ahead of whatever was put after it, and
+        // ahead of a held one that replaced it
+        const uint32_t fold_tail = queue->fold_tail;
+        const uint32_t fold_slot = fold_tail & PACKET_QUEUE_FOLD_MASK;
+        if (fold_tail != load_acquire(&queue->fold_head) &&
+            (int32_t)(queue->fold_seq[fold_slot] - tail) <= 0 &&
+            (!queue->data_held || (int32_t)(queue->fold_id[fold_slot] - queue->data_id[queue->data_front]) < 0)) {
+            *out_cmd = CMD_DATA;
+            out_resp->data = queue->fold[fold_slot];
+            store_release(&queue->fold_tail, fold_tail + 1);
+            return true;
+        }
+        // a CMD_DATA taken while the producer was queueing more goes out once
+        // everything put before it has
+        if (queue->data_held && (queue->data_seq[queue->data_front] == tail || tail == head)) {
+            queue->data_held = false;
+            *out_cmd = CMD_DATA;
+            out_resp->data = queue->data[queue->data_front];
+            return true;
+        }
+        if (tail != head) {
+            const packet_queue_entry_t* entry = &queue->entries[tail & PACKET_QUEUE_MASK];
+            *out_cmd = entry->cmd;
+            *out_resp = entry->resp;
+            store_release(&queue->tail, tail + 1);
+            return true;
+        }
+        if (!middle_fresh(queue)) {
+            return false;
+        }
+        const uint8_t prev = swap_middle(queue, queue->data_front);
+        queue->data_front = prev & PACKET_QUEUE_INDEX;
+        // if it isn't fresh the producer took it back to queue it in order
+        queue->data_held = 0 != (prev & PACKET_QUEUE_FRESH);
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef PACKET_QUEUE_H
+#define PACKET_QUEUE_H
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "interface.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+// Hands decoded packets from the IO task to the render task without a lock.
+// One task puts and one task gets. Packets come out in the order they went in.
+// CMD_DATA is latest-wins: a CMD_DATA the render task hasn't taken yet is
+// replaced by the next one, so a slow repaint never backs up the queue. The
+// one replaced moves to a smaller ring of its own, so it still comes out, in
+// order, for the graph's history. Only when that ring is full is it dropped
+// Both must be powers of two
+#ifndef PACKET_QUEUE_SIZE
+#define PACKET_QUEUE_SIZE 8
+#endif
+#ifndef PACKET_QUEUE_FOLD_SIZE
+#define PACKET_QUEUE_FOLD_SIZE 16
+#endif
+
+typedef struct {
+    command_t cmd;
+    response_t resp;
+} packet_queue_entry_t;
+
+typedef struct {
+    packet_queue_entry_t entries[PACKET_QUEUE_SIZE];
+    uint32_t head;  // written by the producer
+    uint32_t tail;  // written by the consumer
+    // the latest CMD_DATA is triple buffered. The producer fills back, the
+    // consumer reads front, and middle is swapped between them
+    response_data_t data[3];
+    uint32_t data_seq[3];  // head when each was put
+    uint32_t data_id[3];   // data_count when each was put, to order them
+    uint32_t data_count;
+    uint8_t data_back;
+    uint8_t data_middle;  // PACKET_QUEUE_FRESH is set when it holds unread data
+    uint8_t data_front;
+    bool data_held;  // front is waiting on packets put before it
+    // CMD_DATA replaced before the consumer took it
+    response_data_t fold[PACKET_QUEUE_FOLD_SIZE];
+    uint32_t fold_seq[PACKET_QUEUE_FOLD_SIZE];
+    uint32_t fold_id[PACKET_QUEUE_FOLD_SIZE];
+    uint32_t fold_head;
+    uint32_t fold_tail;
+    // replaced while the fold ring was full
+    uint32_t dropped;
+} packet_queue_t;
+
+void packet_queue_init(packet_queue_t* queue);
+// producer. true if the next packet_queue_put() can't fail
+bool packet_queue_can_put(const packet_queue_t* queue);
+// producer. false if the queue is full. CMD_DATA always goes in
+bool packet_queue_put(packet_queue_t* queue, command_t cmd, const response_t* resp);
+// consumer. false if there's nothing to take
+bool packet_queue_get(packet_queue_t* queue, command_t* out_cmd, response_t* out_resp);
+#ifdef __cplusplus
+}
+#endif
+#endif // PACKET_QUEUE_H
@@ -1,5 +1,7 @@
 #include "serial.h"
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 #include <driver/gpio.h>
 #include <driver/uart.h>
 #include <esp_err.h>
@@ -7,8 +9,86 @@
 #include <esp_log.h>
 #include <memory.h>
 
+// Bytes move to and from the drivers in chunks. Each driver call takes the
+// driver's lock, so reading a whole frame's worth at once instead of a byte
+// per call saves a lot of CPU. The getc/putc functions work on these buffers.
+typedef struct {
+    uint8_t rx_buf[SERIAL_CHUNK_SIZE];
+    size_t rx_head;
+    size_t rx_tail;
+    uint8_t tx_buf[SERIAL_CHUNK_SIZE];
+    size_t tx_len;
+} serial_buffers_t;
+
+// takes up to size bytes from the receive buffer, refilling it from the driver
+// with one call when it runs dry
+static size_t buffers_read(serial_buffers_t* bufs, uint8_t* data, size_t size, int (*fill)(uint8_t* data, size_t size)) {
+    size_t total = 0;
+    while (total < size) {
+        if (bufs->rx_head == bufs->rx_tail) {
+            int res = fill(bufs->rx_buf, sizeof(bufs->rx_buf));
+            if (res <= 0) {
+                break;
+            }
+            bufs->rx_head = 0;
+            bufs->rx_tail = (size_t)res;
+        }
+        size_t count = bufs->rx_tail - bufs->rx_head;
+        if (count > size - total) {
+            count = size - total;
+        }
+        memcpy(data + total, bufs->rx_buf + bufs->rx_head, count);
+        bufs->rx_head += count;
+        total += count;
+    }
+    return total;
+}
+static bool buffers_flush(serial_buffers_t* bufs, bool (*drain)(const uint8_t* data, size_t size)) {
+    if (bufs->tx_len == 0) {
+        return true;
+    }
+    bool result = drain(bufs->tx_buf, bufs->tx_len);
+    bufs->tx_len = 0;
+    return result;
+}
+static bool buffers_write(serial_buffers_t* bufs, const uint8_t* data, size_t size, bool (*drain)(const uint8_t* data, size_t size)) {
+    bool result = true;
+    while (size) {
+        size_t count = sizeof(bufs->tx_buf) - bufs->tx_len;
+        if (count > size) {
+            count = size;
+        }
+        memcpy(bufs->tx_buf + bufs->tx_len, data, count);
+        bufs->tx_len += count;
+        data += count;
+        size -= count;
+        if (bufs->tx_len == sizeof(bufs->tx_buf)) {
+            result = buffers_flush(bufs, drain) && result;
+        }
+    }
+    return result;
+}
+
 static bool initialized = false;
 static const char* TAG = "Serial";
+static serial_buffers_t serial_bufs;
+static uint32_t serial_rate = SERIAL_DEFAULT_BAUD;
+// the driver reports overflows here. Drained on every read, so the data
+// events it also posts don't fill it and crowd them out
+static QueueHandle_t serial_events = NULL;
+static uint32_t serial_overflows = 0;
+static int serial_fill(uint8_t* data, size_t size) {
+    uart_event_t event;
+    while (pdTRUE == xQueueReceive(serial_events, &event, 0)) {
+        if (event.type == UART_FIFO_OVF || event.type == UART_BUFFER_FULL) {
+            ++serial_overflows;
+        }
+    }
+    return uart_read_bytes(UART_NUM_0, data, size, 0);
+}
+static bool serial_drain(const uint8_t* data, size_t size) {
+    return (int)size == uart_write_bytes(UART_NUM_0, data, size);
+}
 bool serial_init(size_t max_payload) {
     if(initialized) return true;
     esp_log_level_set(TAG, ESP_LOG_INFO);
@@ -16,19 +96,28 @@ bool serial_init(size_t max_payload) {
      * communication pins and install the driver */
     uart_config_t uart_config;
     memset(&uart_config, 0, sizeof(uart_config));
-    uart_config.baud_rate = 115200;
+    uart_config.baud_rate = SERIAL_DEFAULT_BAUD;
     uart_config.data_bits = UART_DATA_8_BITS;
     uart_config.parity = UART_PARITY_DISABLE;
     uart_config.stop_bits = UART_STOP_BITS_1;
     uart_config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+    // The IO task sleeps a tick when it finds nothing to read, so the buffer
+    // holds at least two ticks at the fastest rate (10 bits a byte)
+    size_t rx_size = max_payload * 2;
+    const size_t tick_bytes = (SERIAL_MAX_BAUD / 10) / configTICK_RATE_HZ * 2;
+    if (rx_size < tick_bytes) {
+        rx_size = tick_bytes;
+    }
     // Install UART driver, and get the queue.
-    if (ESP_OK != uart_driver_install(UART_NUM_0, max_payload * 2, 0, 20, NULL, 0)) {
+    if (ESP_OK != uart_driver_install(UART_NUM_0, rx_size, 0, 20, &serial_events, 0)) {
         ESP_LOGE(TAG, "Unable to install uart driver");
         goto error;
     }
     uart_param_config(UART_NUM_0, &uart_config);
     // Set UART pins (using UART0 default pins ie no changes.)
     uart_set_pin(UART_NUM_0, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    memset(&serial_bufs, 0, sizeof(serial_bufs));
+    serial_rate = SERIAL_DEFAULT_BAUD;
     initialized = true;
     return true;
 error:
@@ -36,18 +125,56 @@ error:
 }
 int serial_getc(void) {
     uint8_t tmp;
-    if(1==uart_read_bytes(UART_NUM_0,&tmp,1,0)) {
+    if(1==buffers_read(&serial_bufs,&tmp,1,serial_fill)) {
         return tmp;
     }
     return -1;
 }
 void serial_putc(int value) {
     uint8_t tmp = value;
-    uart_write_bytes(UART_NUM_0,&tmp,1);
+    buffers_write(&serial_bufs,&tmp,1,serial_drain);
+}
+size_t serial_read_bytes(uint8_t* data, size_t size) {
+    return buffers_read(&serial_bufs,data,size,serial_fill);
+}
+bool serial_write_bytes(const uint8_t* data, size_t size) {
+    return buffers_write(&serial_bufs,data,size,serial_drain);
+}
+bool serial_flush(void) {
+    return buffers_flush(&serial_bufs,serial_drain);
+}
+bool serial_set_baud(uint32_t baud) {
+    if(!initialized || baud==0 || baud>SERIAL_MAX_BAUD) return false;
+    if(baud==serial_rate) return true;
+    buffers_flush(&serial_bufs,serial_drain);
+    uart_wait_tx_done(UART_NUM_0, pdMS_TO_TICKS(100));
+    if(ESP_OK != uart_set_baudrate(UART_NUM_0, baud)) {
+        ESP_LOGE(TAG, "Unable to set baud rate to %lu", (unsigned long)baud);
+        return false;
+    }
+    // whatever is still queued was received at the old rate
+    uart_flush_input(UART_NUM_0);
+    serial_bufs.rx_head = serial_bufs.rx_tail = 0;
+    serial_rate = baud;
+    ESP_LOGI(TAG, "Baud rate set to %lu", (unsigned long)baud);
+    return true;
+}
+uint32_t serial_baud(void) {
+    return serial_rate;
+}
+uint32_t serial_rx_overflows(void) {
+    return serial_overflows;
 }
 #ifdef CONFIG_SOC_USB_SERIAL_JTAG_SUPPORTED
 #include "driver/usb_serial_jtag.h"
 
+static serial_buffers_t serial2_bufs;
+static int serial2_fill(uint8_t* data, size_t size) {
+    return usb_serial_jtag_read_bytes(data, size, 0);
+}
+static bool serial2_drain(const uint8_t* data, size_t size) {
+    return (int)size == usb_serial_jtag_write_bytes(data, size, pdMS_TO_TICKS(100));
+}
 bool serial2_init(size_t queue_size) {
     usb_serial_jtag_driver_config_t usb_config;
     memset(&usb_config,0,sizeof(usb_config));
@@ -56,21 +183,27 @@ bool serial2_init(size_t queue_size) {
     if(ESP_OK!=usb_serial_jtag_driver_install(&usb_config)) {
         return false;
     }
+    memset(&serial2_bufs, 0, sizeof(serial2_bufs));
     return true;
 }
 int serial2_getc(void) {
     uint8_t tmp;
-    if(1==usb_serial_jtag_read_bytes(&tmp,1,0)) {
+    if(1==buffers_read(&serial2_bufs,&tmp,1,serial2_fill)) {
         return tmp;
     }
     return -1;
 }
 bool serial2_putc(int value) {
     uint8_t tmp=value;
-    if(1==usb_serial_jtag_write_bytes(&tmp,1,pdMS_TO_TICKS(100))) {
-        //uart_wait_tx_done(UART_NUM_0,pdMS_TO_TICKS(100));
-        return true;
-    }
-    return false;
+    return buffers_write(&serial2_bufs,&tmp,1,serial2_drain);
+}
+size_t serial2_read_bytes(uint8_t* data, size_t size) {
+    return buffers_read(&serial2_bufs,data,size,serial2_fill);
+}
+bool serial2_write_bytes(const uint8_t* data, size_t size) {
+    return buffers_write(&serial2_bufs,data,size,serial2_drain);
+}
+bool serial2_flush(void) {
+    return buffers_flush(&serial2_bufs,serial2_drain);
 }
-#endif
\ No newline at end of file
+#endif
@@ -3,19 +3,45 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+// Reads and writes go through buffers of this size, so the drivers are called
+// once per chunk rather than once per byte. Written bytes go out when the
+// buffer fills or on serial_flush()
+#ifndef SERIAL_CHUNK_SIZE
+#define SERIAL_CHUNK_SIZE 256
+#endif
+// The rate the UART starts at, and falls back to when a faster one stops working
+#define SERIAL_DEFAULT_BAUD 115200
+// The fastest rate CMD_BAUD may switch the UART to. Boards whose USB bridge
+// can't keep up can set a lower one
+#ifndef SERIAL_MAX_BAUD
+#define SERIAL_MAX_BAUD 2000000
+#endif
 #ifdef __cplusplus
 extern "C" {
 #endif
 bool serial_init(size_t max_payload_size);
 int serial_getc(void);
 void serial_putc(int value);
+size_t serial_read_bytes(uint8_t* data, size_t size);
+bool serial_write_bytes(const uint8_t* data, size_t size);
+bool serial_flush(void);
+// sends what's buffered, waits for it to leave, then changes the rate and drops
+// anything received at the old one
+bool serial_set_baud(uint32_t baud);
+uint32_t serial_baud(void);
+// times received bytes were lost because the UART's FIFO or buffer was full.
+// Counted since boot
+uint32_t serial_rx_overflows(void);
 #ifdef CONFIG_SOC_USB_SERIAL_JTAG_SUPPORTED
 #define HAS_SERIAL2
 bool serial2_init(size_t max_payload_size);
 int serial2_getc(void);
-void serial2_putc(int value);
+bool serial2_putc(int value);
+size_t serial2_read_bytes(uint8_t* data, size_t size);
+bool serial2_write_bytes(const uint8_t* data, size_t size);
+bool serial2_flush(void);
 #endif
 #ifdef __cplusplus
 }
 #endif
-#endif // SERIAL_H
\ No newline at end of file
+#endif // SERIAL_H
@@ -0,0 +1,172 @@
+// Decoder microbenchmark for interface_buffers.c
+// Encodes a sample of every message type, then times decoding it with the
+// byte-at-a-time callback readers (X_read) against the span readers
+// (X_read_span) process_frame() uses, and checks both decode the same.
+// Usage: codec_bench [-n iterations]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "interface_buffers.h"
+
+typedef struct {
+    const uint8_t* ptr;
+    size_t remaining;
+} cursor_t;
+static int on_read(void* state) {
+    cursor_t* cur = (cursor_t*)state;
+    if (cur->remaining == 0) {
+        return BUFFERS_EOF;
+    }
+    --cur->remaining;
+    return *cur->ptr++;
+}
+typedef struct {
+    uint8_t* ptr;
+    size_t remaining;
+} write_cursor_t;
+static int on_write(uint8_t value, void* state) {
+    write_cursor_t* cur = (write_cursor_t*)state;
+    if (cur->remaining == 0) {
+        return BUFFERS_ERROR_EOF;
+    }
+    --cur->remaining;
+    *cur->ptr++ = value;
+    return 1;
+}
+
+// keeps the decodes from being optimized away
+static volatile uint8_t sink;
+
+template <typename T>
+static bool run(const char* name, const T& sample,
+                int (*write_fn)(const T*, buffers_write_callback_t, void*),
+                int (*read_fn)(T*, buffers_read_callback_t, void*),
+                int (*read_span_fn)(T*, const void*, size_t),
+                size_t iterations) {
+    uint8_t payload[INTERFACE_MAX_SIZE];
+    write_cursor_t wcur = {payload, sizeof(payload)};
+    const int len = write_fn(&sample, on_write, &wcur);
+    if (len < 0) {
+        printf("%-22s write failed\n", name);
+        return false;
+    }
+    // both start from the same garbage, so padding and unwritten string tails compare equal
+    T a, b;
+    memset(&a, 0xCD, sizeof(a));
+    memset(&b, 0xCD, sizeof(b));
+    cursor_t cur = {payload, (size_t)len};
+    const int res_cb = read_fn(&a, on_read, &cur);
+    const int res_span = read_span_fn(&b, payload, (size_t)len);
+    if (res_cb < 0 || res_span != len || 0 != memcmp(&a, &b, sizeof(T))) {
+        printf("%-22s MISMATCH (callback %d, span %d of %d bytes)\n", name, res_cb, res_span, len);
+        return false;
+    }
+    uint8_t acc = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        cursor_t c = {payload, (size_t)len};
+        read_fn(&a, on_read, &c);
+        acc ^= ((const uint8_t*)&a)[i % sizeof(T)];
+    }
+    auto mid = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        read_span_fn(&b, payload, (size_t)len);
+        acc ^= ((const uint8_t*)&b)[i % sizeof(T)];
+    }
+    auto end = std::chrono::steady_clock::now();
+    sink = acc;
+    const double cb_ns = std::chrono::duration<double, std::nano>(mid - start).count() / iterations;
+    const double span_ns = std::chrono::duration<double, std::nano>(end - mid).count() / iterations;
+    printf("%-22s %5d %10.1f %10.1f %7.1fx\n", name, len, cb_ns, span_ns, span_ns > 0 ? cb_ns / span_ns : 0);
+    return true;
+}
+
+static void fill_screen_entry(response_screen_entry_t* entry, const char* label, const char* suffix1, const char* suffix2) {
+    strcpy(entry->label, label);
+    entry->color = {255, 0, 200, 255};
+    entry->value1.color = {255, 255, 128, 0};
+    strcpy(entry->value1.suffix, suffix1);
+    entry->value2.color = {255, 64, 255, 64};
+    strcpy(entry->value2.suffix, suffix2);
+}
+
+static void usage(const char* exe) {
+    fprintf(stderr, "Usage: %s [-n iterations]\n", exe);
+    fprintf(stderr, "  -n iterations  decodes timed per message and path (1000000)\n");
+}
+
+int main(int argc, char** argv) {
+    size_t iterations = 1000000;
+    for (int i = 1; i < argc; ++i) {
+        if (0 == strcmp(argv[i], "-n") && i + 1 < argc) {
+            iterations = (size_t)strtoul(argv[++i], nullptr, 10);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (iterations == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    printf("%-22s %5s %10s %10s %8s\n", "message", "bytes", "cb ns", "span ns", "speedup");
+    bool ok = true;
+
+    response_data_t data = {{{42.5f, .425f}, {3600.f, .72f}}, {{61.f, .61f}, {1850.f, .37f}}};
+    ok &= run("response_data", data, response_data_write, response_data_read, response_data_read_span, iterations);
+
+    // two values and one scaled value changed, about what a steady load sends
+    response_data_delta_t data_delta = {0x13, 5, {0x0A, 0xD1, 0x0F, 0x9C, 0x01}};
+    ok &= run("response_data_delta", data_delta, response_data_delta_write, response_data_delta_read, response_data_delta_read_span, iterations);
+
+    response_screen_t screen;
+    memset(&screen, 0, sizeof(screen));
+    screen.header.index = 1;
+    screen.header.flags = 3;
+    fill_screen_entry(&screen.top, "CPU", "%", "MHz");
+    fill_screen_entry(&screen.bottom, "GPU", "\xC2\xB0" "C", "W");
+    ok &= run("response_screen", screen, response_screen_write, response_screen_read, response_screen_read_span, iterations);
+
+    response_baud_t baud = {921600};
+    ok &= run("response_baud", baud, response_baud_write, response_baud_read, response_baud_read_span, iterations);
+
+    response_window_t window = {8};
+    ok &= run("response_window", window, response_window_write, response_window_read, response_window_read_span, iterations);
+
+    request_data_t req_data = {1};
+    ok &= run("request_data", req_data, request_data_write, request_data_read, request_data_read_span, iterations);
+
+    request_screen_t req_screen = {2};
+    ok &= run("request_screen", req_screen, request_screen_write, request_screen_read, request_screen_read_span, iterations);
+
+    request_set_mode_t req_set_mode = {1};
+    ok &= run("request_set_mode", req_set_mode, request_set_mode_write, request_set_mode_read, request_set_mode_read_span, iterations);
+
+    request_subscribe_t req_subscribe = {0, 33};
+    ok &= run("request_subscribe", req_subscribe, request_subscribe_write, request_subscribe_read, request_subscribe_read_span, iterations);
+
+    request_ident_t ident;
+    memset(&ident, 0, sizeof(ident));
+    ident.version_major = ESPMON_VERSION_MAJOR;
+    ident.version_minor = ESPMON_VERSION_MINOR;
+    ident.build = 0x0123456789ABCDEFull;
+    ident.id = -1;
+    memcpy(ident.mac_address, "\x24\x6F\x28\x01\x02\x03", 6);
+    strcpy(ident.display_name, "Lilygo T-Display S3");
+    strcpy(ident.slug, "lilygo-tdisplay-s3");
+    ident.horizontal_resolution = 320;
+    ident.vertical_resolution = 170;
+    ident.dpi = 190.f;
+    ident.pixel_size = .13f;
+    ident.input_type = INPUT_BUTTON;
+    ident.max_baud = 2000000;
+    ident.max_window = 8;
+    ident.data_delta = true;
+    ok &= run("request_ident", ident, request_ident_write, request_ident_read, request_ident_read_span, iterations);
+
+    request_stats_t stats = {5000, 150, 8120, 9310, 14870, 2457600, 12, {3, 1}, {0, 0}, 0, 143212, 65536, 7340032, 4194304};
+    ok &= run("request_stats", stats, request_stats_write, request_stats_read, request_stats_read_span, iterations);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,519 @@
+// Headless render benchmark for espmon<>
+// Replays a frame trace into an in-memory transfer buffer at each board's
+// resolution and bit depth, and reports decode and render time, dirty rects,
+// flush bytes and overdraw per frame. Without a trace it synthesizes one.
+// The partial mode boards flush to a simulated bus, so how much of the
+// transfer time rendering hid is reported too.
+// Usage: espmon_bench [-n frames] [-t trace] [-x speed] [-f count] [-k count] [-s rows] [-r rate] [board-slug]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#define MONOXBOLD_IMPLEMENTATION
+#include <monoxbold.hpp>
+#undef MONOXBOLD_IMPLEMENTATION
+#include <espmon.hpp>
+#include "trace_replay.hpp"
+
+using namespace gfx;
+
+typedef struct {
+    command_t cmd;
+    response_t resp;
+} packet_t;
+
+typedef struct {
+    std::vector<uint8_t> trace;
+    float speed;
+    // for the direct mode boards, or 0 for the board's own
+    // (LCD_FRAMEBUFFER_COUNT)
+    int framebuffers;
+    // for the partial mode boards, or 0 for the board's own
+    // transfer buffers (LCD_TRANSFER_BUFFERS)
+    int transfer_buffers;
+    // rows per tile (LCD_STRIP_HEIGHT)
+    int strip_height;
+    // bus Mbit/s
+    double bus_mbps;
+} stream_t;
+
+typedef struct board board_t;
+typedef void (*run_board_fn_t)(const board_t& board, const stream_t& stream);
+struct board {
+    const char* slug;
+    uint16_t width;
+    uint16_t height;
+    // RGB panels render straight into a full framebuffer
+    bool direct;
+    // the partial transfer buffer is one screen / divisor (LCD_DIVISOR)
+    uint16_t divisor;
+    // LCD_FRAMEBUFFER_COUNT
+    int framebuffers;
+    // LCD_TRANSFER_BUFFERS, and LCD_STRIP_HEIGHT or 0 for the divisor's
+    int transfer_buffers;
+    uint16_t strip_height;
+    // about what the panel bus moves, Mbit/s
+    double bus_mbps;
+    // CONFIG_SPIRAM: the firmware scrolls the graph offscreen
+    bool psram;
+    run_board_fn_t run;
+};
+
+typedef struct {
+    double min_us;
+    double avg_us;
+    double p99_us;
+    double max_us;
+} timing_t;
+
+// In flight on the simulated bus. Transfers go out one after another in the
+// order they were flushed, and complete in that order
+typedef struct {
+    double bytes_per_us;
+    // microseconds into the frame, counting the render time so far and
+    // any waits on the bus
+    double now_us;
+    std::chrono::steady_clock::time_point step_start;
+    double step_now_us;
+    double bus_free_us;
+    double bus_us;
+    std::vector<double> ends;
+    size_t completed;
+} bus_t;
+static double bus_time(const bus_t& bus) {
+    const auto now = std::chrono::steady_clock::now();
+    return bus.step_now_us + std::chrono::duration<double, std::micro>(now - bus.step_start).count();
+}
+
+static timing_t compute_timing(std::vector<double>& samples) {
+    timing_t result = {0, 0, 0, 0};
+    if (samples.empty()) {
+        return result;
+    }
+    std::sort(samples.begin(), samples.end());
+    double total = 0;
+    for (double d : samples) {
+        total += d;
+    }
+    result.min_us = samples.front();
+    result.max_us = samples.back();
+    result.avg_us = total / samples.size();
+    result.p99_us = samples[(samples.size() - 1) * 99 / 100];
+    return result;
+}
+
+// HistorySize is the board's GRAPH_HISTORY
+template <typename PixelType, size_t HistorySize = 100>
+static void run_board(const board_t& board, const stream_t& stream) {
+    using espmon_t = espmon<bitmap<PixelType>, 1, 1, HistorySize>;
+    typedef struct {
+        espmon_t* app;
+        size_t flushes;
+        size_t area;
+        // nullptr for the direct mode boards
+        bus_t* bus;
+    } state_t;
+    const size_t screen_bytes = ((size_t)board.width * board.height * PixelType::bit_depth + 7) / 8;
+    size_t transfer_size = board.direct ? screen_bytes : screen_bytes / board.divisor;
+    const int strip_height = stream.strip_height ? stream.strip_height : board.strip_height;
+    if (!board.direct && strip_height != 0) {
+        // a strip no bigger than the buffer the divisor gives, as the firmware checks
+        const size_t strip_bytes = ((size_t)board.width * strip_height * PixelType::bit_depth + 7) / 8;
+        transfer_size = std::min(transfer_size, strip_bytes);
+    }
+    size_t count = 1;
+    if (board.direct) {
+        count = (size_t)(stream.framebuffers ? stream.framebuffers : board.framebuffers);
+    } else {
+        count = (size_t)(stream.transfer_buffers ? stream.transfer_buffers : board.transfer_buffers);
+        count = std::min(count, espmon_t::max_transfer_buffers);
+    }
+    uint8_t* buffers[espmon_t::max_transfer_buffers] = {nullptr};
+    bool allocated = true;
+    for (size_t i = 0; i < count; ++i) {
+        buffers[i] = (uint8_t*)malloc(transfer_size);
+        allocated = allocated && buffers[i] != nullptr;
+    }
+    // keep the instance off the stack, it's big
+    espmon_t* app = new espmon_t();
+    bus_t bus;
+    bus.bytes_per_us = (stream.bus_mbps > 0 ? stream.bus_mbps : board.bus_mbps) / 8;
+    bus.completed = 0;
+    const auto free_buffers = [&]() {
+        for (size_t i = 0; i < count; ++i) {
+            free(buffers[i]);
+        }
+    };
+    if (!allocated || app == nullptr) {
+        printf("%-20s out of memory\n", board.slug);
+        free_buffers();
+        delete app;
+        return;
+    }
+    state_t st = {app, 0, 0, board.direct ? nullptr : &bus};
+    // same setup order as the firmware
+    app->dimensions({board.width, board.height});
+    app->set_flush_callback([](const uix::rect16& bounds, const void* bmp, void* state) {
+        state_t& st = *(state_t*)state;
+        ++st.flushes;
+        st.area += (size_t)bounds.width() * bounds.height();
+        if (st.bus == nullptr) {
+            // there's no bus, so the transfer completes immediately
+            st.app->transfer_complete();
+            return;
+        }
+        bus_t& bus = *st.bus;
+        const double bytes = ((double)bounds.width() * bounds.height() * PixelType::bit_depth + 7) / 8;
+        const double duration = bytes / bus.bytes_per_us;
+        const double start = std::max(bus_time(bus), bus.bus_free_us);
+        bus.bus_free_us = start + duration;
+        bus.bus_us += duration;
+        bus.ends.push_back(bus.bus_free_us);
+    }, &st);
+    if (board.direct) {
+        app->set_transfer(uix::screen_update_mode::direct, buffers[0], transfer_size, count > 1 ? buffers[1] : nullptr);
+    } else {
+        app->set_transfer_buffers(buffers, count, transfer_size);
+    }
+    app->has_graph(board.height > 64);
+    app->is_monochrome(PixelType::bit_depth == 1);
+    app->graph_scrolling(board.psram);
+    app->initialize();
+    // renders a packet, or whatever is dirty without one, and returns the
+    // render time. For the partial mode boards end_us is when the last
+    // transfer finished, counting from the start
+    double end_us = 0;
+    const auto render = [&](const command_t* cmd, const response_t* resp) {
+        if (board.direct) {
+            auto start = std::chrono::steady_clock::now();
+            if (cmd != nullptr) {
+                app->accept_packet(*cmd, *resp, true);
+            } else {
+                app->refresh();
+            }
+            auto end = std::chrono::steady_clock::now();
+            return std::chrono::duration<double, std::micro>(end - start).count();
+        }
+        bus.now_us = 0;
+        bus.bus_free_us = 0;
+        bus.bus_us = 0;
+        bus.ends.clear();
+        bus.completed = 0;
+        double cpu_us = 0;
+        const auto complete = [&]() {
+            ++bus.completed;
+            app->transfer_complete();
+        };
+        auto start = std::chrono::steady_clock::now();
+        if (cmd != nullptr) {
+            app->accept_packet(*cmd, *resp, false);
+        }
+        auto end = std::chrono::steady_clock::now();
+        bus.now_us = cpu_us = std::chrono::duration<double, std::micro>(end - start).count();
+        while (app->is_dirty()) {
+            while (bus.completed < bus.ends.size() && bus.ends[bus.completed] <= bus.now_us) {
+                complete();
+            }
+            const size_t flushes = st.flushes;
+            bus.step_now_us = bus.now_us;
+            bus.step_start = std::chrono::steady_clock::now();
+            app->refresh(false);
+            const double step_us = bus_time(bus) - bus.step_now_us;
+            bus.now_us += step_us;
+            cpu_us += step_us;
+            if (st.flushes == flushes && bus.completed < bus.ends.size()) {
+                // nothing went out, so the display is waiting on the bus
+                bus.now_us = std::max(bus.now_us, bus.ends[bus.completed]);
+                complete();
+            }
+        }
+        end_us = std::max(bus.now_us, bus.bus_free_us);
+        while (bus.completed < bus.ends.size()) {
+            complete();
+        }
+        return cpu_us;
+    };
+    // paint the disconnected screen so it doesn't count against the first frame
+    render(nullptr, nullptr);
+    app->reset_paint_stats();
+
+    trace_replayer replay;
+    replay.speed(stream.speed);
+    if (0 > replay.open(stream.trace.data(), stream.trace.size())) {
+        printf("%-20s invalid trace\n", board.slug);
+        delete app;
+        free_buffers();
+        return;
+    }
+    std::vector<double> data_times;
+    std::vector<double> screen_times;
+    double decode_us = 0;
+    size_t data_flushes = 0, data_area = 0;
+    size_t max_flushes = 0;
+    // render and bus time per data frame, how long until the last transfer
+    // finished, and the least of render and bus time, which is as much as
+    // could overlap
+    double cpu_total = 0, bus_total = 0, end_total = 0, hideable_total = 0;
+    // pixels drawn and pixels flushed per control, over the data frames
+    static const size_t controls = (size_t)espmon_hit::graph + 1;
+    size_t painted[controls] = {0};
+    size_t flushed[controls] = {0};
+    frame_trace_record_t rec;
+    command_t cmd;
+    response_t resp;
+    while (0 < replay.next(&rec)) {
+        auto start = std::chrono::steady_clock::now();
+        if (!replay.decode(rec, &cmd, &resp)) {
+            continue;
+        }
+        auto decoded = std::chrono::steady_clock::now();
+        decode_us += std::chrono::duration<double, std::micro>(decoded - start).count();
+        if (cmd != CMD_SCREEN && cmd != CMD_DATA && cmd != CMD_CLEAR) {
+            continue;
+        }
+        st.flushes = 0;
+        st.area = 0;
+        const double us = render(&cmd, &resp);
+        if (cmd == CMD_DATA) {
+            data_times.push_back(us);
+            data_flushes += st.flushes;
+            data_area += st.area;
+            if (st.flushes > max_flushes) {
+                max_flushes = st.flushes;
+            }
+            if (!board.direct) {
+                cpu_total += us;
+                bus_total += bus.bus_us;
+                end_total += end_us;
+                hideable_total += std::min(us, bus.bus_us);
+            }
+            for (size_t i = 0; i < controls; ++i) {
+                const paint_stats ps = app->control_stats((espmon_hit)i);
+                painted[i] += ps.painted;
+                flushed[i] += ps.flushed;
+            }
+        } else {
+            screen_times.push_back(us);
+        }
+        app->reset_paint_stats();
+    }
+    size_t total_painted = 0, total_flushed = 0;
+    double max_overdraw = 0;
+    for (size_t i = 0; i < controls; ++i) {
+        total_painted += painted[i];
+        total_flushed += flushed[i];
+        if (flushed[i] && (double)painted[i] / flushed[i] > max_overdraw) {
+            max_overdraw = (double)painted[i] / flushed[i];
+        }
+    }
+    const size_t frames = data_times.size();
+    timing_t t = compute_timing(data_times);
+    timing_t ts = compute_timing(screen_times);
+    const double avg_flushes = frames ? (double)data_flushes / frames : 0;
+    const double avg_area = frames ? (double)data_area / frames : 0;
+    const double avg_bytes = avg_area * PixelType::bit_depth / 8;
+    const size_t packets = data_times.size() + screen_times.size();
+    // a label and a bar per value, four values per frame
+    const double skipped = frames ? 100.0 * app->skipped_fields() / (frames * 8) : 0;
+    // the share of what could have overlapped that did
+    const double overlap = hideable_total > 0 ? 100.0 * (cpu_total + bus_total - end_total) / hideable_total : 0;
+    printf("%-20s %4dx%-4d %2dbpp %-7s %4d %7.2f %8.1f %8.1f %8.1f %8.1f %6.1f %4d %9.0f %9.0f %6.1f %5.2f %5.2f %8.1f %8.1f %8.1f %5.1f\n",
+           board.slug, (int)board.width, (int)board.height, (int)PixelType::bit_depth,
+           board.direct ? "direct" : "partial", (int)count,
+           packets ? decode_us / packets : 0,
+           t.min_us, t.avg_us, t.p99_us, t.max_us,
+           avg_flushes, (int)max_flushes, avg_area, avg_bytes, skipped,
+           total_flushed ? (double)total_painted / total_flushed : 0, max_overdraw, ts.avg_us,
+           frames ? bus_total / frames : 0, frames ? end_total / frames : 0, overlap);
+    delete app;
+    free_buffers();
+}
+
+// generated from espmon-esp32/boards.json, each board's defines and its
+// sdkconfig.defaults when the bench is configured
+static const board_t boards[] = {
+#include "bench_boards.inc"
+};
+
+static void set_color(response_color_t* col, uint8_t r, uint8_t g, uint8_t b) {
+    col->a = 255;
+    col->r = r;
+    col->g = g;
+    col->b = b;
+}
+static void make_screen(packet_t* pck, int8_t index) {
+    memset(pck, 0, sizeof(packet_t));
+    pck->cmd = CMD_SCREEN;
+    response_screen_t& scr = pck->resp.screen;
+    scr.header.index = index;
+    // gradients on the second value of each entry
+    scr.header.flags = (1 << 1) | (1 << 3);
+    strcpy(scr.top.label, (index & 1) ? "GPU" : "CPU");
+    set_color(&scr.top.color, 0, 255, 255);
+    set_color(&scr.top.value1.color, 0, 255, 0);
+    strcpy(scr.top.value1.suffix, "%");
+    set_color(&scr.top.value2.color, 255, 165, 0);
+    strcpy(scr.top.value2.suffix, "\xC2\xB0" "C");
+    strcpy(scr.bottom.label, (index & 1) ? "VRAM" : "RAM");
+    set_color(&scr.bottom.color, 255, 0, 255);
+    set_color(&scr.bottom.value1.color, 255, 255, 255);
+    strcpy(scr.bottom.value1.suffix, "%");
+    set_color(&scr.bottom.value2.color, 128, 0, 128);
+    strcpy(scr.bottom.value2.suffix, "MHz");
+}
+// deterministic, so runs are comparable
+static uint32_t rand_state = 0x1234567;
+static float next_jitter() {
+    rand_state = rand_state * 1103515245 + 12345;
+    return ((rand_state >> 16) & 0x7FFF) / 32767.f;
+}
+static void set_value(response_value_t* val, float scaled, float max) {
+    scaled = gfx::math::clamp(0.f, scaled, 1.f);
+    val->scaled = scaled;
+    // round to 2 places like the host does
+    val->value = roundf(scaled * max * 100.f) / 100.f;
+}
+static void make_data(packet_t* pck, size_t frame) {
+    memset(pck, 0, sizeof(packet_t));
+    pck->cmd = CMD_DATA;
+    response_data_t& data = pck->resp.data;
+    const float t = frame / 10.f;
+    set_value(&data.top.value1, .5f + .4f * sinf(t * .7f) + .1f * next_jitter(), 100.f);
+    set_value(&data.top.value2, .55f + .2f * sinf(t * .13f) + .02f * next_jitter(), 100.f);
+    set_value(&data.bottom.value1, .3f + .05f * sinf(t * .05f), 100.f);
+    set_value(&data.bottom.value2, .6f + .3f * (next_jitter() - .5f), 5000.f);
+}
+static int on_write_vector(uint8_t value, void* state) {
+    ((std::vector<uint8_t>*)state)->push_back(value);
+    return 1;
+}
+// encodes a packet the way the host sends it and records it as received
+static void trace_packet(frame_trace_writer_t* writer, uint64_t timestamp_us, uint8_t seq, const packet_t& pck) {
+    std::vector<uint8_t> payload;
+    if (pck.cmd == CMD_SCREEN) {
+        response_screen_write(&pck.resp.screen, on_write_vector, &payload);
+    } else {
+        response_data_write(&pck.resp.data, on_write_vector, &payload);
+    }
+    frame_trace_write(writer, timestamp_us, FRAME_TRACE_IN, (uint8_t)pck.cmd, seq & 0x3F, payload.data(), payload.size());
+}
+// a screen, then data at the host's 10Hz with a screen change every 30 seconds
+static void make_stream(std::vector<uint8_t>& trace, size_t frames) {
+    frame_trace_writer_t writer;
+    frame_trace_writer_init(&writer, on_write_vector, &trace);
+    packet_t pck;
+    int8_t index = 0;
+    uint64_t ts = 0;
+    uint8_t seq = 0;
+    make_screen(&pck, index);
+    trace_packet(&writer, ts, seq++, pck);
+    for (size_t i = 0; i < frames; ++i) {
+        if (i > 0 && (i % 300) == 0) {
+            make_screen(&pck, ++index);
+            trace_packet(&writer, ts, seq++, pck);
+        }
+        ts += 100000;
+        make_data(&pck, i);
+        trace_packet(&writer, ts, seq++, pck);
+    }
+}
+
+static void usage(const char* exe) {
+    fprintf(stderr, "Usage: %s [-n frames] [-t trace] [-x speed] [-f count] [-k count] [-s rows] [-r rate] [board-slug]\n", exe);
+    fprintf(stderr, "  -n frames  data frames to synthesize when there's no trace (1000)\n");
+    fprintf(stderr, "  -t trace   a binary frame trace, or a serial log with TRACE: lines\n");
+    fprintf(stderr, "  -x speed   replay at the recorded pace times speed (0 = unpaced)\n");
+    fprintf(stderr, "  -f count   framebuffers for the direct mode boards, 1 or 2 (the board's)\n");
+    fprintf(stderr, "  -k count   transfer buffers for the partial mode boards, 1 to 8 (the board's)\n");
+    fprintf(stderr, "  -s rows    rows per tile for the partial mode boards (the board's)\n");
+    fprintf(stderr, "  -r rate    panel bus Mbit/s for the partial mode boards (the board's)\n");
+}
+
+int main(int argc, char** argv) {
+    size_t frames = 1000;
+    const char* slug = nullptr;
+    const char* trace_path = nullptr;
+    stream_t stream;
+    stream.speed = 0;
+    stream.framebuffers = 0;
+    stream.transfer_buffers = 0;
+    stream.strip_height = 0;
+    stream.bus_mbps = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (0 == strcmp(argv[i], "-n") && i + 1 < argc) {
+            frames = (size_t)strtoul(argv[++i], nullptr, 10);
+        } else if (0 == strcmp(argv[i], "-t") && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (0 == strcmp(argv[i], "-x") && i + 1 < argc) {
+            stream.speed = strtof(argv[++i], nullptr);
+        } else if (0 == strcmp(argv[i], "-f") && i + 1 < argc) {
+            stream.framebuffers = atoi(argv[++i]);
+            if (stream.framebuffers < 1 || stream.framebuffers > 2) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (0 == strcmp(argv[i], "-k") && i + 1 < argc) {
+            stream.transfer_buffers = atoi(argv[++i]);
+            if (stream.transfer_buffers < 1 || stream.transfer_buffers > 8) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (0 == strcmp(argv[i], "-s") && i + 1 < argc) {
+            stream.strip_height = atoi(argv[++i]);
+            if (stream.strip_height < 1) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (0 == strcmp(argv[i], "-r") && i + 1 < argc) {
+            stream.bus_mbps = strtod(argv[++i], nullptr);
+            if (stream.bus_mbps <= 0) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (argv[i][0] != '-' && slug == nullptr) {
+            slug = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (trace_path != nullptr) {
+        trace_file file;
+        if (!file.load(trace_path)) {
+            fprintf(stderr, "Unable to load trace %s\n", trace_path);
+            return 1;
+        }
+        stream.trace.assign(file.data(), file.data() + file.size());
+        printf("%s: %zu bytes\n", trace_path, stream.trace.size());
+    } else {
+        if (frames == 0) {
+            usage(argv[0]);
+            return 1;
+        }
+        make_stream(stream.trace, frames);
+        printf("%zu synthesized data frames\n", frames);
+    }
+    // ovr is pixels drawn over pixels flushed, and worst is the control
+    // with the most. end us is when a data frame's last transfer finished,
+    // and ovl% is how much of the render or bus time, whichever is less,
+    // the other hid
+    printf("%-20s %-9s %5s %-7s %4s %7s %8s %8s %8s %8s %6s %4s %9s %9s %6s %5s %5s %8s %8s %8s %5s\n",
+           "board", "res", "depth", "mode", "bufs", "dec us", "min us", "avg us", "p99 us", "max us",
+           "rects", "max", "px/frame", "B/frame", "skip%", "ovr", "worst", "scr us", "bus us", "end us", "ovl%");
+    bool found = false;
+    for (const board_t& board : boards) {
+        if (slug != nullptr && 0 != strcmp(slug, board.slug)) {
+            continue;
+        }
+        found = true;
+        board.run(board, stream);
+    }
+    if (!found) {
+        fprintf(stderr, "Unknown board %s\n", slug);
+        return 1;
+    }
+    return 0;
+}
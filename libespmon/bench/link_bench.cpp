@@ -0,0 +1,313 @@
+// Link benchmark for the serial protocol, without a device
+// Runs the firmware's frame_window.c and packet decoders against a host end
+// written after EspSerialSession, over a simulated cable that can lose or
+// corrupt bytes. Reports the sustained data frames a second the link carries,
+// how often each end had to resend, and the CPU time the device end spends
+// per frame. Every frame is checked to arrive once, in order, and intact.
+// Time on the wire is simulated, so runs are repeatable and don't wait.
+// Usage: link_bench [-n frames] [-b baud] [-w window] [-d drop] [-c corrupt] [-s seed]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "interface_buffers.h"
+#include "data_delta.h"
+#include "frame_window.h"
+#include "link_sim.hpp"
+
+// as main.cpp has them
+#define ACK_TIMEOUT_MS 300
+#define REQUEST_INTERVAL_MS 100
+// the host's
+#define HOST_ACK_TIMEOUT_MS 1000
+// a link that can't deliver the frames in this much simulated time is stuck
+#define MAX_SIM_SECONDS 600
+
+typedef struct {
+    uint32_t baud;
+    int window;
+    double drop;
+    double corrupt;
+} link_config_t;
+
+// The device end: the port handling and frame decoding from main.cpp's IO
+// task, for a port that has switched to the window
+typedef struct {
+    frame_window_t window;
+    std::vector<uint8_t> window_buf;
+    sim_wire* rx;
+    sim_wire* tx;
+    uint64_t now_ns;
+    uint64_t last_send_ns;
+    uint64_t request_ns;
+    data_delta_t baseline;
+    size_t data_frames;
+    size_t screen_frames;
+    // frames that failed to decode, or came out of order, twice, or changed
+    size_t errors;
+    size_t retransmits;
+} device_t;
+
+static int device_read(void* state) {
+    device_t* dev = (device_t*)state;
+    return dev->rx->read(dev->now_ns);
+}
+static int device_write(uint8_t value, void* state) {
+    device_t* dev = (device_t*)state;
+    dev->tx->write(dev->now_ns, value);
+    return 1;
+}
+static int on_write_vector(uint8_t value, void* state) {
+    ((std::vector<uint8_t>*)state)->push_back(value);
+    return 1;
+}
+// the data frames carry their index, so the device can tell where it is
+static void make_data(response_data_t* data, size_t index) {
+    memset(data, 0, sizeof(*data));
+    data->top.value1.value = (float)index;
+    data->top.value1.scaled = (index % 100) / 100.f;
+    data->top.value2.value = 55.25f;
+    data->top.value2.scaled = .55f;
+    data->bottom.value1.value = 3600.f;
+    data->bottom.value1.scaled = .72f;
+    data->bottom.value2.value = 1850.5f;
+    data->bottom.value2.scaled = .37f;
+}
+static void make_screen(response_screen_t* screen, int8_t index) {
+    memset(screen, 0, sizeof(*screen));
+    screen->header.index = index;
+    strcpy(screen->top.label, "CPU");
+    strcpy(screen->top.value1.suffix, "%");
+    strcpy(screen->top.value2.suffix, "\xC2\xB0" "C");
+    strcpy(screen->bottom.label, "GPU");
+    strcpy(screen->bottom.value1.suffix, "%");
+    strcpy(screen->bottom.value2.suffix, "MHz");
+}
+// decodes in place the way process_frame() does
+static void device_process(device_t* dev, uint8_t cmd, const void* p, size_t len) {
+    response_t resp;
+    switch (cmd) {
+        case CMD_SCREEN:
+            if (-1 < response_screen_read_span(&resp.screen, p, len)) {
+                ++dev->screen_frames;
+            } else {
+                ++dev->errors;
+            }
+            break;
+        case CMD_DATA:
+            if (-1 < response_data_read_span(&resp.data, p, len)) {
+                data_delta_key(&dev->baseline, &resp.data);
+                if (resp.data.top.value1.value != (float)dev->data_frames) {
+                    ++dev->errors;
+                }
+                ++dev->data_frames;
+            } else {
+                ++dev->errors;
+            }
+            break;
+        default:
+            ++dev->errors;
+            break;
+    }
+}
+// one pass of the IO task's loop for the port
+static void device_step(device_t* dev) {
+    const uint8_t in_flight = frame_window_in_flight(&dev->window);
+    void* payload;
+    size_t length;
+    int cmd;
+    while (0 < (cmd = frame_window_get(&dev->window, &payload, &length))) {
+        device_process(dev, (uint8_t)cmd, payload, length);
+    }
+    if (frame_window_in_flight(&dev->window) < in_flight) {
+        // the ACK timer now runs for the oldest frame still in flight
+        dev->last_send_ns = dev->now_ns;
+    }
+    if (frame_window_in_flight(&dev->window) &&
+        dev->now_ns - dev->last_send_ns >= (uint64_t)ACK_TIMEOUT_MS * 1000000) {
+        ++dev->retransmits;
+        frame_window_resend(&dev->window);
+        dev->last_send_ns = dev->now_ns;
+    }
+    if (dev->now_ns >= dev->request_ns) {
+        dev->request_ns = dev->now_ns + (uint64_t)REQUEST_INTERVAL_MS * 1000000;
+        // the periodic request the IO task sends, which the host ACKs
+        request_data_t req = {0};
+        std::vector<uint8_t> out;
+        if (-1 < request_data_write(&req, on_write_vector, &out)) {
+            const bool idle = frame_window_in_flight(&dev->window) == 0;
+            if (FRAME_WINDOW_SUCCESS == frame_window_put(&dev->window, CMD_DATA, out.data(), out.size()) && idle) {
+                dev->last_send_ns = dev->now_ns;
+            }
+        }
+    }
+}
+static uint64_t device_deadline_ns(const device_t* dev) {
+    uint64_t next = dev->request_ns;
+    if (frame_window_in_flight(&dev->window)) {
+        const uint64_t ack_ns = dev->last_send_ns + (uint64_t)ACK_TIMEOUT_MS * 1000000;
+        if (ack_ns < next) {
+            next = ack_ns;
+        }
+    }
+    return next;
+}
+
+static bool run(const link_config_t& config, size_t frames, uint32_t seed) {
+    std::mt19937 rng(seed);
+    sim_wire to_device(rng, config.baud, config.drop, config.corrupt);
+    sim_wire to_host(rng, config.baud, config.drop, config.corrupt);
+    host_link host(to_device, to_host, config.window, HOST_ACK_TIMEOUT_MS);
+    device_t dev;
+    dev.window_buf.resize(FRAME_WINDOW_BUFFER_SIZE(FRAME_WINDOW_MAX, INTERFACE_MAX_SIZE));
+    if (FRAME_WINDOW_SUCCESS != frame_window_init(&dev.window, FRAME_WINDOW_MAX, INTERFACE_MAX_SIZE, dev.window_buf.data(),
+                                                  device_read, &dev, device_write, &dev)) {
+        printf("frame_window_init failed\n");
+        return false;
+    }
+    frame_window_reset(&dev.window, (uint8_t)config.window, 0);
+    dev.rx = &to_device;
+    dev.tx = &to_host;
+    dev.now_ns = 0;
+    dev.last_send_ns = 0;
+    dev.request_ns = 0;
+    data_delta_init(&dev.baseline);
+    dev.data_frames = 0;
+    dev.screen_frames = 0;
+    dev.errors = 0;
+    dev.retransmits = 0;
+
+    // a screen, then data as fast as the window takes it, with a screen
+    // change every 300 frames like espmon_bench's stream
+    std::vector<uint8_t> payload;
+    size_t sent = 0;
+    bool screen_due = true;
+    int8_t screen_index = 0;
+    // the host only ACKs the device's requests. The data goes out regardless
+    auto on_request = [](uint8_t cmd, const uint8_t* p, size_t len) {
+        (void)cmd;
+        (void)p;
+        (void)len;
+    };
+    std::chrono::steady_clock::duration device_time(0);
+    uint64_t now = 0;
+    const uint64_t limit = (uint64_t)MAX_SIM_SECONDS * 1000000000ull;
+    while (dev.data_frames < frames && now < limit) {
+        while (sent < frames && host.can_send()) {
+            payload.clear();
+            if (screen_due) {
+                response_screen_t screen;
+                make_screen(&screen, screen_index++);
+                response_screen_write(&screen, on_write_vector, &payload);
+                host.send(now, CMD_SCREEN, payload.data(), payload.size());
+                screen_due = false;
+                continue;
+            }
+            response_data_t data;
+            make_data(&data, sent);
+            response_data_write(&data, on_write_vector, &payload);
+            host.send(now, CMD_DATA, payload.data(), payload.size());
+            ++sent;
+            screen_due = (sent % 300) == 0;
+        }
+        dev.now_ns = now;
+        const auto start = std::chrono::steady_clock::now();
+        device_step(&dev);
+        device_time += std::chrono::steady_clock::now() - start;
+        host.poll(now, on_request);
+        // on to whatever happens next
+        uint64_t next = to_device.next_arrival_ns();
+        uint64_t t = to_host.next_arrival_ns();
+        if (t < next) next = t;
+        t = host.ack_deadline_ns();
+        if (t < next) next = t;
+        t = device_deadline_ns(&dev);
+        if (t < next) next = t;
+        if (sent < frames && host.can_send()) {
+            next = now;  // an ACK made room in the window
+        } else if (next <= now) {
+            next = now + 1;
+        }
+        now = next;
+    }
+    const bool stuck = dev.data_frames < frames;
+    const double seconds = now / 1e9;
+    const double device_us = std::chrono::duration<double, std::micro>(device_time).count();
+    const size_t received = dev.data_frames + dev.screen_frames;
+    char loss[32];
+    snprintf(loss, sizeof(loss), "%g/%g", config.drop, config.corrupt);
+    printf("%8lu %3d %-13s %9.0f %6.1f%% %8zu %8zu %8zu %8zu %8zu %8.2f %6zu%s\n",
+           (unsigned long)config.baud, config.window, loss,
+           seconds > 0 ? dev.data_frames / seconds : 0,
+           // share of the line the host's frames used
+           seconds > 0 ? 100.0 * to_device.sent() * 10 / config.baud / seconds : 0,
+           host.nack_resends(), host.timeout_resends(), (size_t)dev.window.resends,
+           (size_t)dev.window.nacks_sent, host.crc_errors(),
+           received ? device_us / received : 0,
+           dev.errors, stuck ? " STUCK" : "");
+    return !stuck && dev.errors == 0;
+}
+
+static void usage(const char* exe) {
+    fprintf(stderr, "Usage: %s [-n frames] [-b baud] [-w window] [-d drop] [-c corrupt] [-s seed]\n", exe);
+    fprintf(stderr, "  -n frames   data frames to deliver per run (20000)\n");
+    fprintf(stderr, "  -b baud     line rate (2000000)\n");
+    fprintf(stderr, "  -w window   frames in flight, 1 to %d\n", FRAME_WINDOW_MAX);
+    fprintf(stderr, "  -d drop     chance of each byte being lost\n");
+    fprintf(stderr, "  -c corrupt  chance of each byte having a bit flipped\n");
+    fprintf(stderr, "  -s seed     for the loss and corruption (1)\n");
+    fprintf(stderr, "Without -w, -d or -c it runs windows of 1, 4 and 8 on a clean and a noisy line\n");
+}
+
+int main(int argc, char** argv) {
+    size_t frames = 20000;
+    uint32_t baud = 2000000;
+    uint32_t seed = 1;
+    int window = 0;
+    double drop = -1;
+    double corrupt = -1;
+    for (int i = 1; i < argc; ++i) {
+        if (0 == strcmp(argv[i], "-n") && i + 1 < argc) {
+            frames = (size_t)strtoul(argv[++i], nullptr, 10);
+        } else if (0 == strcmp(argv[i], "-b") && i + 1 < argc) {
+            baud = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else if (0 == strcmp(argv[i], "-w") && i + 1 < argc) {
+            window = atoi(argv[++i]);
+        } else if (0 == strcmp(argv[i], "-d") && i + 1 < argc) {
+            drop = strtod(argv[++i], nullptr);
+        } else if (0 == strcmp(argv[i], "-c") && i + 1 < argc) {
+            corrupt = strtod(argv[++i], nullptr);
+        } else if (0 == strcmp(argv[i], "-s") && i + 1 < argc) {
+            seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    // the frame index travels as a float, which is exact up to 2^24
+    if (frames == 0 || frames > (1u << 24) || baud == 0 || window < 0 || window > FRAME_WINDOW_MAX ||
+        drop > 1 || corrupt > 1) {
+        usage(argv[0]);
+        return 1;
+    }
+    printf("%8s %3s %-13s %9s %7s %8s %8s %8s %8s %8s %8s %6s\n",
+           "baud", "win", "drop/corrupt", "frames/s", "line", "h nack", "h timer", "d resend",
+           "d nacks", "h crc", "d us/fr", "errors");
+    bool ok = true;
+    if (window != 0 || drop >= 0 || corrupt >= 0) {
+        const link_config_t config = {baud, window != 0 ? window : 8, drop < 0 ? 0 : drop, corrupt < 0 ? 0 : corrupt};
+        ok = run(config, frames, seed);
+    } else {
+        static const int windows[] = {1, 4, 8};
+        static const double noise[][2] = {{0, 0}, {0, 1e-5}, {0, 1e-4}, {1e-4, 0}, {1e-4, 1e-4}};
+        for (const double* n : noise) {
+            for (int w : windows) {
+                const link_config_t config = {baud, w, n[0], n[1]};
+                ok &= run(config, frames, seed);
+            }
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,366 @@
+#pragma once
+// A simulated serial cable for link_bench: a wire that paces bytes at a baud
+// rate and can lose or corrupt them, and the host end of the framing, after
+// EspSerialSession, to run the firmware's frame_window.c against
+#include <stdint.h>
+#include <string.h>
+#include <deque>
+#include <random>
+#include <vector>
+#include "interface_buffers.h"
+
+// One direction of the cable. Times are simulated nanoseconds
+class sim_wire {
+    typedef struct {
+        uint64_t arrival_ns;
+        uint8_t value;
+    } byte_t;
+    std::deque<byte_t> m_bytes;
+    std::mt19937* m_rng;
+    std::uniform_real_distribution<double> m_chance;
+    uint64_t m_byte_ns;
+    uint64_t m_busy_until_ns;
+    double m_drop;
+    double m_corrupt;
+    size_t m_sent;
+    size_t m_dropped;
+    size_t m_corrupted;
+
+   public:
+    // drop and corrupt are the chance of each byte being lost, or having a bit flipped
+    sim_wire(std::mt19937& rng, uint32_t baud, double drop, double corrupt)
+        : m_rng(&rng),
+          m_chance(0.0, 1.0),
+          // 8N1 is 10 bits a byte
+          m_byte_ns(10000000000ull / baud),
+          m_busy_until_ns(0),
+          m_drop(drop),
+          m_corrupt(corrupt),
+          m_sent(0),
+          m_dropped(0),
+          m_corrupted(0) {
+    }
+    // bytes go out back to back. A lost byte still took its time on the line
+    void write(uint64_t now_ns, uint8_t value) {
+        const uint64_t start = now_ns > m_busy_until_ns ? now_ns : m_busy_until_ns;
+        m_busy_until_ns = start + m_byte_ns;
+        ++m_sent;
+        if (m_drop > 0 && m_chance(*m_rng) < m_drop) {
+            ++m_dropped;
+            return;
+        }
+        if (m_corrupt > 0 && m_chance(*m_rng) < m_corrupt) {
+            value ^= (uint8_t)(1 << ((*m_rng)() % 8));
+            ++m_corrupted;
+        }
+        m_bytes.push_back({m_busy_until_ns, value});
+    }
+    // the next byte that has arrived by now, or -1
+    int read(uint64_t now_ns) {
+        if (m_bytes.empty() || m_bytes.front().arrival_ns > now_ns) {
+            return -1;
+        }
+        const uint8_t value = m_bytes.front().value;
+        m_bytes.pop_front();
+        return value;
+    }
+    // UINT64_MAX when nothing is on the way
+    uint64_t next_arrival_ns() const {
+        return m_bytes.empty() ? UINT64_MAX : m_bytes.front().arrival_ns;
+    }
+    size_t sent() const {
+        return m_sent;
+    }
+    size_t dropped() const {
+        return m_dropped;
+    }
+    size_t corrupted() const {
+        return m_corrupted;
+    }
+};
+
+// The host end of the sliding window, written from EspSerialSession rather
+// than sharing frame_window.c, so the two are checked against each other.
+// Frames go out while fewer than window are unacked. A cumulative ACK retires
+// them, a NACK resends the one it names, and the ACK timer resends the oldest.
+// Frames from the device are delivered in order, held past a gap, and ACKed
+// the same way. It starts in window mode at seq 0, where both ends are once
+// CMD_WINDOW is acked. The stop-and-wait before that is frame_arq's, which
+// isn't in this tree
+class host_link {
+    enum { header_length = 17,
+           // MaxReceiveLength
+           max_frame_length = INTERFACE_MAX_SIZE,
+           seq_mask = 0x3F };
+    enum { type_data = 0,
+           type_ack = 1,
+           type_nack = 2,
+           type_cack = 3 };
+    sim_wire* m_tx;
+    sim_wire* m_rx;
+    int m_window;
+    uint64_t m_ack_timeout_ns;
+    uint32_t m_crc_table[256];
+    // send
+    std::vector<uint8_t> m_outstanding[64];
+    uint8_t m_tx_seq;  // the last one used
+    uint8_t m_tx_base;
+    int m_in_flight;
+    uint64_t m_ack_deadline_ns;
+    // receive
+    int m_state;
+    uint8_t m_raw_cmd;
+    uint8_t m_raw_seq;
+    uint32_t m_raw_len;
+    uint32_t m_raw_crc;
+    std::vector<uint8_t> m_payload;
+    uint8_t m_expected;
+    bool m_rx_nacked;
+    bool m_held[64];
+    uint8_t m_held_cmd[64];
+    std::vector<uint8_t> m_held_payload[64];
+    // counts
+    size_t m_received;
+    size_t m_nack_resends;
+    size_t m_timeout_resends;
+    size_t m_crc_errors;
+    size_t m_nacks_sent;
+
+    uint32_t crc32(uint8_t seq_byte, uint32_t length, const uint8_t* payload) const {
+        uint32_t c = 0xFFFFFFFF;
+        c = (c >> 8) ^ m_crc_table[(c ^ seq_byte) & 0xFF];
+        for (int i = 0; i < 4; ++i) {
+            c = (c >> 8) ^ m_crc_table[(c ^ (uint8_t)(length >> (8 * i))) & 0xFF];
+        }
+        for (uint32_t i = 0; i < length; ++i) {
+            c = (c >> 8) ^ m_crc_table[(c ^ payload[i]) & 0xFF];
+        }
+        return c ^ 0xFFFFFFFF;
+    }
+    std::vector<uint8_t> build_frame(uint8_t marker, uint8_t seq_byte, const uint8_t* payload, uint32_t length) const {
+        std::vector<uint8_t> frame(header_length + length);
+        memset(frame.data(), marker, 8);
+        frame[8] = seq_byte;
+        const uint32_t crc = crc32(seq_byte, length, payload);
+        for (int i = 0; i < 4; ++i) {
+            frame[9 + i] = (uint8_t)(length >> (8 * i));
+            frame[13 + i] = (uint8_t)(crc >> (8 * i));
+        }
+        if (length) {
+            memcpy(frame.data() + header_length, payload, length);
+        }
+        return frame;
+    }
+    void write_frame(uint64_t now_ns, const std::vector<uint8_t>& frame) {
+        for (uint8_t b : frame) {
+            m_tx->write(now_ns, b);
+        }
+    }
+    void send_control(uint64_t now_ns, int type, uint8_t seq) {
+        if (type == type_nack) {
+            ++m_nacks_sent;
+        }
+        write_frame(now_ns, build_frame(128, (uint8_t)((type << 6) | (seq & seq_mask)), nullptr, 0));
+    }
+    void arm(uint64_t now_ns) {
+        m_ack_deadline_ns = now_ns + m_ack_timeout_ns;
+    }
+    void on_cack(uint64_t now_ns, uint8_t seq) {
+        if (m_in_flight == 0) {
+            return;
+        }
+        const int acked = ((seq - m_tx_base) & seq_mask) + 1;
+        if (acked > m_in_flight) {
+            return;  // stale or a duplicate
+        }
+        for (int i = 0; i < acked; ++i) {
+            m_outstanding[(m_tx_base + i) & seq_mask].clear();
+        }
+        m_tx_base = (uint8_t)((m_tx_base + acked) & seq_mask);
+        m_in_flight -= acked;
+        if (m_in_flight > 0) {
+            arm(now_ns);  // for the new oldest frame
+        } else {
+            m_ack_deadline_ns = UINT64_MAX;
+        }
+    }
+    void on_nack(uint64_t now_ns, uint8_t seq) {
+        if (m_in_flight > 0 && ((seq - m_tx_base) & seq_mask) < m_in_flight) {
+            ++m_nack_resends;
+            // the timer keeps running
+            write_frame(now_ns, m_outstanding[seq]);
+        }
+    }
+    template <typename Deliver>
+    void on_data(uint64_t now_ns, uint8_t cmd, uint8_t seq, Deliver& deliver) {
+        const int ahead = (seq - m_expected) & seq_mask;
+        if (ahead == 0) {
+            // in order, along with whatever was held behind the gap it fills
+            ++m_received;
+            deliver(cmd, m_payload.data(), m_payload.size());
+            m_expected = (uint8_t)((m_expected + 1) & seq_mask);
+            while (m_held[m_expected]) {
+                ++m_received;
+                deliver(m_held_cmd[m_expected], m_held_payload[m_expected].data(), m_held_payload[m_expected].size());
+                m_held[m_expected] = false;
+                m_expected = (uint8_t)((m_expected + 1) & seq_mask);
+            }
+            m_rx_nacked = false;
+            send_control(now_ns, type_cack, (uint8_t)(m_expected - 1));
+        } else if (ahead < m_window) {
+            // past a gap: hold it, and ask for the gap once
+            if (!m_held[seq]) {
+                m_held[seq] = true;
+                m_held_cmd[seq] = cmd;
+                m_held_payload[seq] = m_payload;
+            }
+            if (!m_rx_nacked) {
+                m_rx_nacked = true;
+                send_control(now_ns, type_nack, m_expected);
+            }
+        } else if (((m_expected - seq) & seq_mask) <= m_window) {
+            // a duplicate. our ACK was lost
+            send_control(now_ns, type_cack, (uint8_t)(m_expected - 1));
+        }
+    }
+
+   public:
+    host_link(sim_wire& tx, sim_wire& rx, int window, uint32_t ack_timeout_ms = 1000)
+        : m_tx(&tx),
+          m_rx(&rx),
+          m_window(window),
+          m_ack_timeout_ns((uint64_t)ack_timeout_ms * 1000000),
+          m_tx_seq(seq_mask),
+          m_tx_base(0),
+          m_in_flight(0),
+          m_ack_deadline_ns(UINT64_MAX),
+          m_state(0),
+          m_expected(0),
+          m_rx_nacked(false),
+          m_received(0),
+          m_nack_resends(0),
+          m_timeout_resends(0),
+          m_crc_errors(0),
+          m_nacks_sent(0) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+            }
+            m_crc_table[i] = c;
+        }
+        memset(m_held, 0, sizeof(m_held));
+    }
+    bool can_send() const {
+        return m_in_flight < m_window;
+    }
+    // false if the window is full
+    bool send(uint64_t now_ns, uint8_t cmd, const uint8_t* payload, size_t length) {
+        if (!can_send()) {
+            return false;
+        }
+        m_tx_seq = (uint8_t)((m_tx_seq + 1) & seq_mask);
+        m_outstanding[m_tx_seq] = build_frame((uint8_t)(cmd + 128), m_tx_seq, payload, (uint32_t)length);
+        if (m_in_flight++ == 0) {
+            m_tx_base = m_tx_seq;
+            arm(now_ns);
+        }
+        write_frame(now_ns, m_outstanding[m_tx_seq]);
+        return true;
+    }
+    // reads what has arrived, and resends the oldest frame if its ACK is late.
+    // deliver(cmd, payload, length) gets each frame from the device in order
+    template <typename Deliver>
+    void poll(uint64_t now_ns, Deliver deliver) {
+        if (m_in_flight > 0 && now_ns >= m_ack_deadline_ns) {
+            ++m_timeout_resends;
+            write_frame(now_ns, m_outstanding[m_tx_base]);
+            arm(now_ns);
+        }
+        int value;
+        while ((value = m_rx->read(now_ns)) >= 0) {
+            const uint8_t b = (uint8_t)value;
+            if (m_state == 0) {
+                if (b < 128) {
+                    continue;  // log text
+                }
+                m_raw_cmd = b;
+                m_raw_len = 0;
+                m_raw_crc = 0;
+                m_state = 1;
+                continue;
+            }
+            if (m_state < 8) {
+                m_state = (b == m_raw_cmd) ? m_state + 1 : 0;
+                continue;
+            }
+            if (m_state == 8) {
+                m_raw_seq = b;
+                ++m_state;
+                continue;
+            }
+            if (m_state < 13) {
+                m_raw_len |= (uint32_t)b << (8 * (m_state - 9));
+                ++m_state;
+                continue;
+            }
+            if (m_state < 17) {
+                m_raw_crc |= (uint32_t)b << (8 * (m_state - 13));
+                if (++m_state < 17) {
+                    continue;
+                }
+                if (m_raw_len > max_frame_length) {
+                    m_state = 0;
+                    send_control(now_ns, type_nack, m_expected);
+                    continue;
+                }
+                m_payload.clear();
+            } else {
+                m_payload.push_back(b);
+            }
+            if (m_payload.size() < m_raw_len) {
+                continue;
+            }
+            m_state = 0;
+            if (crc32(m_raw_seq, m_raw_len, m_payload.data()) != m_raw_crc) {
+                ++m_crc_errors;
+                // corrupt, so the seq can't be trusted
+                send_control(now_ns, type_nack, m_expected);
+                continue;
+            }
+            const int type = m_raw_seq >> 6;
+            const uint8_t seq = m_raw_seq & seq_mask;
+            if (m_raw_cmd == 128 || type != type_data) {
+                if (type == type_nack) {
+                    on_nack(now_ns, seq);
+                } else if (type == type_cack) {
+                    on_cack(now_ns, seq);
+                }
+                continue;
+            }
+            on_data(now_ns, (uint8_t)(m_raw_cmd - 128), seq, deliver);
+        }
+    }
+    // UINT64_MAX when nothing is in flight
+    uint64_t ack_deadline_ns() const {
+        return m_in_flight > 0 ? m_ack_deadline_ns : UINT64_MAX;
+    }
+    int in_flight() const {
+        return m_in_flight;
+    }
+    size_t received() const {
+        return m_received;
+    }
+    size_t nack_resends() const {
+        return m_nack_resends;
+    }
+    size_t timeout_resends() const {
+        return m_timeout_resends;
+    }
+    size_t crc_errors() const {
+        return m_crc_errors;
+    }
+    size_t nacks_sent() const {
+        return m_nacks_sent;
+    }
+};
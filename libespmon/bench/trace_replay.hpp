@@ -0,0 +1,201 @@
+#pragma once
+// Offline replay of frame traces recorded by the firmware (see frame_trace.h)
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <interface.h>
+#include "buffers.h"
+#include "data_delta.h"
+#include "frame_trace.h"
+#include "interface_buffers.h"
+
+// A trace held in memory. Loads either a binary trace, or a serial log with
+// the firmware's TRACE: lines in it (TRACE_FRAMES).
+class trace_file {
+    std::vector<uint8_t> m_data;
+    static int hex_digit(char ch) {
+        if (ch >= '0' && ch <= '9') return ch - '0';
+        if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+        if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+        return -1;
+    }
+    static void write_header(std::vector<uint8_t>& data) {
+        static const uint8_t header[FRAME_TRACE_HEADER_SIZE] = {'E', 'M', 'T', 'R', FRAME_TRACE_VERSION, 0, 0, 0};
+        data.insert(data.end(), header, header + sizeof(header));
+    }
+    bool load_log(const std::vector<uint8_t>& text) {
+        static const char* prefix = "TRACE:";
+        const size_t prefix_len = strlen(prefix);
+        m_data.clear();
+        // the boot header may not have been captured, and a reboot prints
+        // another, so supply one and drop the ones in the log
+        write_header(m_data);
+        size_t i = 0;
+        std::vector<uint8_t> line;
+        while (i < text.size()) {
+            size_t end = i;
+            while (end < text.size() && text[end] != '\n') ++end;
+            const char* ln = (const char*)text.data() + i;
+            const size_t ln_len = end - i;
+            for (size_t j = 0; j + prefix_len <= ln_len; ++j) {
+                if (0 == memcmp(ln + j, prefix, prefix_len)) {
+                    line.clear();
+                    size_t k = j + prefix_len;
+                    while (k + 1 < ln_len) {
+                        int hi = hex_digit(ln[k]);
+                        int lo = hex_digit(ln[k + 1]);
+                        if (hi < 0 || lo < 0) break;
+                        line.push_back((uint8_t)((hi << 4) | lo));
+                        k += 2;
+                    }
+                    if (!(line.size() == FRAME_TRACE_HEADER_SIZE && 0 == memcmp(line.data(), m_data.data(), 4))) {
+                        m_data.insert(m_data.end(), line.begin(), line.end());
+                    }
+                    break;
+                }
+            }
+            i = end + 1;
+        }
+        return m_data.size() > FRAME_TRACE_HEADER_SIZE;
+    }
+
+   public:
+    bool load(const char* path) {
+        FILE* f = fopen(path, "rb");
+        if (f == nullptr) {
+            return false;
+        }
+        std::vector<uint8_t> contents;
+        uint8_t buf[4096];
+        size_t r;
+        while ((r = fread(buf, 1, sizeof(buf), f)) > 0) {
+            contents.insert(contents.end(), buf, buf + r);
+        }
+        fclose(f);
+        if (contents.size() >= 4 && 0 == memcmp(contents.data(), "EMTR", 4)) {
+            m_data.swap(contents);
+            return true;
+        }
+        return load_log(contents);
+    }
+    const uint8_t* data() const {
+        return m_data.data();
+    }
+    size_t size() const {
+        return m_data.size();
+    }
+};
+
+// Walks the records of a trace, optionally reproducing the recorded timing
+// sped up by a factor (10 = ten times faster). A speed of 0 doesn't wait.
+class trace_replayer {
+    typedef struct {
+        const uint8_t* ptr;
+        size_t remaining;
+    } cursor_t;
+    frame_trace_reader_t m_reader;
+    cursor_t m_cursor;
+    uint8_t m_payload[INTERFACE_MAX_SIZE];
+    float m_speed;
+    uint64_t m_max_gap_us;
+    bool m_started;
+    uint64_t m_last_us;
+    // recorded time since the first record, less the cut gaps
+    uint64_t m_trace_us;
+    std::chrono::steady_clock::time_point m_start;
+    // CMD_DATA_DELTA is decoded against the data before it
+    data_delta_t m_data;
+    static int on_read(void* state) {
+        cursor_t* cur = (cursor_t*)state;
+        if (cur->remaining == 0) {
+            return BUFFERS_EOF;
+        }
+        --cur->remaining;
+        return *cur->ptr++;
+    }
+
+   public:
+    trace_replayer() : m_speed(0), m_max_gap_us(5000000), m_started(false), m_last_us(0), m_trace_us(0) {
+        data_delta_init(&m_data);
+    }
+    float speed() const {
+        return m_speed;
+    }
+    void speed(float value) {
+        m_speed = value < 0 ? 0 : value;
+    }
+    // idle gaps longer than this (a reboot, an unplugged cable) are cut short
+    uint64_t max_gap_us() const {
+        return m_max_gap_us;
+    }
+    void max_gap_us(uint64_t value) {
+        m_max_gap_us = value;
+    }
+    int open(const uint8_t* data, size_t size) {
+        m_cursor.ptr = data;
+        m_cursor.remaining = size;
+        m_started = false;
+        data_delta_init(&m_data);
+        return frame_trace_reader_init(&m_reader, on_read, &m_cursor);
+    }
+    // returns > 0 for a record, 0 at the end of the trace, or < 0 on error
+    int next(frame_trace_record_t* out_record) {
+        int res = frame_trace_read(&m_reader, out_record, m_payload, sizeof(m_payload));
+        if (res <= 0) {
+            return res;
+        }
+        if (!m_started) {
+            m_started = true;
+            m_last_us = out_record->timestamp_us;
+            m_trace_us = 0;
+            m_start = std::chrono::steady_clock::now();
+        }
+        uint64_t delta = out_record->timestamp_us - m_last_us;
+        if (delta > m_max_gap_us) {
+            delta = m_max_gap_us;
+        }
+        m_last_us = out_record->timestamp_us;
+        m_trace_us += delta;
+        if (m_speed > 0) {
+            std::this_thread::sleep_until(m_start + std::chrono::microseconds((uint64_t)(m_trace_us / m_speed)));
+        }
+        return res;
+    }
+    // decodes a frame received by the device, the same way process_frame() does.
+    // CMD_DATA_DELTA comes out as the CMD_DATA it stands for.
+    // returns false if the record isn't a device bound response or fails to decode
+    bool decode(const frame_trace_record_t& record, command_t* out_cmd, response_t* out_response) {
+        if (record.dir != FRAME_TRACE_IN) {
+            return false;
+        }
+        const uint8_t* p = record.payload;
+        const size_t len = record.length;
+        *out_cmd = (command_t)record.cmd;
+        switch (record.cmd) {
+            case CMD_SCREEN:
+                return -1 < response_screen_read_span(&out_response->screen, p, len);
+            case CMD_DATA:
+                if (-1 < response_data_read_span(&out_response->data, p, len)) {
+                    data_delta_key(&m_data, &out_response->data);
+                    return true;
+                }
+                return false;
+            case CMD_DATA_DELTA: {
+                response_data_delta_t delta;
+                *out_cmd = CMD_DATA;
+                return -1 < response_data_delta_read_span(&delta, p, len) &&
+                       data_delta_apply(&m_data, &delta, &out_response->data);
+            }
+            case CMD_CLEAR:
+                return -1 < response_clear_read_span(&out_response->clear, p, len);
+            case CMD_IDENT:
+                return -1 < response_ident_read_span(&out_response->ident, p, len);
+            case CMD_REFRESH_SCREEN:
+                return -1 < response_refresh_screen_read_span(&out_response->refresh_screen, p, len);
+            default:
+                return false;
+        }
+    }
+};
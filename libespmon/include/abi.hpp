@@ -1,13 +1,42 @@
 #pragma once
 #include <stdint.h>
 #include <interface.h>
+#if defined(ESPMON_STATIC)
+#define EXPORT
+#elif defined(_WIN32)
 #define EXPORT __declspec(dllexport)
+#else
+#define EXPORT __attribute__((visibility("default")))
+#endif
 extern "C" {
     /// @brief A handle to the instace
     typedef void* espmon_handle_t;
     typedef struct {
         int32_t x,y,width,height;
     } espmon_rect_t;
+    /// @brief A queued packet for UpdateBatch
+    typedef struct {
+        uint8_t cmd;
+        const response_t* response;
+    } espmon_packet_t;
+    /// @brief A handle to a render pool
+    typedef void* espmon_pool_handle_t;
+    /// @brief Called on a worker thread when a job has been rendered
+    /// @param handle The instance that was updated
+    /// @param dirties The job's dirty rect array, holding the merged dirty areas
+    /// @param dirties_count The count of dirty rectangles filled
+    /// @param state The user defined state from the job
+    typedef void (*espmon_complete_callback_t)(espmon_handle_t handle, const espmon_rect_t* dirties, uint32_t dirties_count, void* state);
+    /// @brief An UpdateBatch call for a render pool to run. The packets, responses and dirty array must stay valid until on_complete is called
+    typedef struct {
+        espmon_handle_t handle;
+        const espmon_packet_t* packets;
+        uint32_t packets_count;
+        espmon_rect_t* dirties_buffer;
+        uint32_t dirties_size;
+        espmon_complete_callback_t on_complete;
+        void* on_complete_state;
+    } espmon_job_t;
     typedef enum {
         HIT_NONE = -1,
         HIT_TOP_LABEL,
@@ -51,9 +80,32 @@ extern "C" {
     /// @param handle The instance
     /// @param cmd A command to send
     /// @param response The response structure to fill
-    /// @param in_dirties_buffer An array of espmon_rect_ts, on out will be filled with the dirty areas that were updated (in pixels). 
+    /// @param in_dirties_buffer An array of espmon_rect_ts, on out will be filled with the dirty areas that were updated (in pixels). Nearby areas are merged when the extra pixels cost less than another rect would, and as needed to fit the array
     /// @param in_out_dirties_count On input, indicates the size of the dirty rect array. On output contains the count of dirty rectangles filled
     EXPORT void Update(espmon_handle_t handle,uint8_t cmd, const response_t* response, espmon_rect_t* in_dirties_buffer, uint32_t* in_out_dirties_count);
+    /// @brief Applies several packets in order, then updates the bitmap once
+    /// @param handle The instance
+    /// @param packets The packets to apply
+    /// @param packets_count The number of packets
+    /// @param in_dirties_buffer An array of espmon_rect_ts, on out will be filled with the dirty areas that were updated (in pixels), merged the same way as Update
+    /// @param in_out_dirties_count On input, indicates the size of the dirty rect array. On output contains the count of dirty rectangles filled
+    EXPORT void UpdateBatch(espmon_handle_t handle, const espmon_packet_t* packets, uint32_t packets_count, espmon_rect_t* in_dirties_buffer, uint32_t* in_out_dirties_count);
+    /// @brief Creates a pool of worker threads that render many instances in parallel
+    /// @param threads The number of worker threads, or 0 for one per hardware thread
+    /// @return On success, a handle to the pool. Null if out of memory or the threads couldn't be started
+    EXPORT espmon_pool_handle_t CreatePool(uint32_t threads);
+    /// @brief Finishes the queued jobs and destroys a pool
+    /// @param pool The pool
+    EXPORT void DestroyPool(espmon_pool_handle_t pool);
+    /// @brief Queues jobs to render on the pool. Jobs for the same instance run one at a time in the order they were submitted. Don't call Update, UpdateBatch, or any other function on an instance while it has jobs queued
+    /// @param pool The pool
+    /// @param jobs The jobs to queue. They are copied
+    /// @param jobs_count The number of jobs
+    /// @return Non-zero on success, 0 if out of memory, in which case only the jobs before the failed one were queued
+    EXPORT uint8_t SubmitPool(espmon_pool_handle_t pool, const espmon_job_t* jobs, uint32_t jobs_count);
+    /// @brief Waits for every job queued on the pool to complete
+    /// @param pool The pool
+    EXPORT void WaitPool(espmon_pool_handle_t pool);
     /// @brief Indicates the part of the screen where the point lands
     /// @param handle The handle to the instance
     /// @param x The x in local coordinates (relative to the control itself, with top being 0,0)
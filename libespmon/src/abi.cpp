@@ -1,8 +1,11 @@
 #include "abi.hpp"
+#include <new>
 #define MONOXBOLD_IMPLEMENTATION
 #include <monoxbold.hpp>
 #undef MONOXBOLD_IMPLEMENTATION
 #include "espmon.hpp"
+#include "dirty_region.hpp"
+#include "render_pool.hpp"
 using namespace gfx;
 template <size_t BitDepth>
 using bgra_pixel = gfx::pixel<
@@ -15,6 +18,7 @@ using bgra_pixel = gfx::pixel<
 using espmon_t = espmon<bitmap<bgra_pixel<32>>>;
 espmon_handle_t Create() {
     espmon_t* result = new espmon_t();
+    result->graph_scrolling(true);
     result->initialize();
     result->dimensions({320, 240});
     return result;
@@ -38,47 +42,103 @@ void SetMonochrome(espmon_handle_t handle,uint8_t isEnabled) {
     espmon_t* ths = ((espmon_t*)handle);
     ths->is_monochrome(!!isEnabled);
 }
-void Update(espmon_handle_t handle, uint8_t cmd, const response_t* response, espmon_rect_t* in_dirties_buffer, uint32_t* in_out_dirties_count) {
-    espmon_t* ths = ((espmon_t*)handle);
-    typedef struct {
-        espmon_t* ths;
-        espmon_rect_t* in_dirties_buffer;
-        uint32_t* in_out_dirties_count;
-        size_t dirt_next;
-    } state_t;
-    state_t st;
+// the overhead of one more dirty rect for the caller, in pixels. coalescing
+// merges rects while that wastes fewer pixels than this
+static const uint32_t dirty_rect_cost = 1024;
+// collects the rectangles flushed during one update for the caller's array
+typedef struct {
+    espmon_t* ths;
+    dirty_region* region;
+} dirty_state_t;
+static void dirty_add(dirty_state_t& st, const uix::rect16& bounds) {
+    espmon_rect_t r;
+    r.x = bounds.left();
+    r.y = bounds.top();
+    r.width = bounds.width();
+    r.height = bounds.height();
+    st.region->add(r);
+}
+static void dirty_begin(dirty_state_t& st, espmon_t* ths, dirty_region& region) {
     st.ths = ths;
-    st.in_dirties_buffer = in_dirties_buffer;
-    st.in_out_dirties_count = in_out_dirties_count;
-    st.dirt_next = 0;
+    st.region = &region;
     ths->set_flush_callback([](const uix::rect16& bounds, const void* bmp, void* state) {
-        state_t& st = *(state_t*)state;
-        if (st.in_dirties_buffer != nullptr && st.in_out_dirties_count != nullptr && *st.in_out_dirties_count) {
-            if (st.dirt_next == 1) {
-                espmon_rect_t& r = *(espmon_rect_t*)st.in_dirties_buffer;
-                size16 dim =st.ths->dimensions();
-                if (r.x == 0 && r.y == 0 && r.width ==dim.width && r.height == dim.height) {
-                    st.ths->transfer_complete();
-                    return;
-                }
-            }
-            if (st.dirt_next >= *st.in_out_dirties_count) {
-                st.dirt_next = 1;
-                espmon_rect_t& r = *(espmon_rect_t*)st.in_dirties_buffer;
-                *st.in_out_dirties_count = 1;
-            } else {
-                espmon_rect_t r;
-                r.x = bounds.left();
-                r.y = bounds.top();
-                r.width = bounds.width();
-                r.height = bounds.height();
-                ((espmon_rect_t*)st.in_dirties_buffer)[st.dirt_next++] = r;
-                *st.in_out_dirties_count = st.dirt_next;
-            }   
+        dirty_state_t& st = *(dirty_state_t*)state;
+        // in direct mode the flush is the whole screen, so report what the
+        // frame actually painted instead
+        const damage_list& painted = st.ths->frame_rects();
+        if (painted.size() == 0) {
+            dirty_add(st, bounds);
+        }
+        for (size_t i = 0; i < painted.size(); ++i) {
+            dirty_add(st, painted[i]);
         }
         st.ths->transfer_complete();
-    },&st);
+    }, &st);
+}
+static void dirty_end(dirty_region& region, espmon_rect_t* in_dirties_buffer, uint32_t* in_out_dirties_count) {
+    if (in_dirties_buffer != nullptr && in_out_dirties_count != nullptr && *in_out_dirties_count) {
+        *in_out_dirties_count = region.coalesce(in_dirties_buffer, *in_out_dirties_count);
+    }
+}
+void Update(espmon_handle_t handle, uint8_t cmd, const response_t* response, espmon_rect_t* in_dirties_buffer, uint32_t* in_out_dirties_count) {
+    espmon_t* ths = ((espmon_t*)handle);
+    dirty_region region(dirty_rect_cost);
+    dirty_state_t st;
+    dirty_begin(st, ths, region);
     ths->accept_packet((command_t)cmd,*response);
+    dirty_end(region, in_dirties_buffer, in_out_dirties_count);
+}
+void UpdateBatch(espmon_handle_t handle, const espmon_packet_t* packets, uint32_t packets_count, espmon_rect_t* in_dirties_buffer, uint32_t* in_out_dirties_count) {
+    espmon_t* ths = ((espmon_t*)handle);
+    dirty_region region(dirty_rect_cost);
+    dirty_state_t st;
+    dirty_begin(st, ths, region);
+    // the controls accumulate their invalidated areas, so the whole batch
+    // paints and flushes once. A data frame the next packet replaces only
+    // needs to go into the graph
+    for (uint32_t i = 0; i < packets_count; ++i) {
+        if (packets[i].response == nullptr) {
+            continue;
+        }
+        uint32_t next = i + 1;
+        while (next < packets_count && packets[next].response == nullptr) {
+            ++next;
+        }
+        if (packets[i].cmd == CMD_DATA && next < packets_count && packets[next].cmd == CMD_DATA && ths->connected()) {
+            ths->fold_data(packets[i].response->data);
+        } else {
+            ths->accept_packet((command_t)packets[i].cmd, *packets[i].response, false);
+        }
+    }
+    ths->refresh();
+    dirty_end(region, in_dirties_buffer, in_out_dirties_count);
+}
+static uint32_t run_job(const espmon_job_t& job) {
+    uint32_t count = job.dirties_size;
+    UpdateBatch(job.handle, job.packets, job.packets_count, job.dirties_buffer, &count);
+    return job.dirties_buffer != nullptr ? count : 0;
+}
+espmon_pool_handle_t CreatePool(uint32_t threads) {
+    render_pool* result = new (std::nothrow) render_pool(run_job);
+    if (result == nullptr) {
+        return nullptr;
+    }
+    if (!result->start(threads)) {
+        delete result;
+        return nullptr;
+    }
+    return result;
+}
+void DestroyPool(espmon_pool_handle_t pool) {
+    delete ((render_pool*)pool);
+}
+uint8_t SubmitPool(espmon_pool_handle_t pool, const espmon_job_t* jobs, uint32_t jobs_count) {
+    render_pool* ths = ((render_pool*)pool);
+    return ths->submit(jobs, jobs_count);
+}
+void WaitPool(espmon_pool_handle_t pool) {
+    render_pool* ths = ((render_pool*)pool);
+    ths->wait();
 }
 void HitTest(espmon_handle_t handle,int32_t x, int32_t y, int8_t* out_hit_index) {
     espmon_t* ths = ((espmon_t*)handle);
@@ -0,0 +1,108 @@
+#pragma once
+// Collects flushed rectangles and coalesces them into as few as are worth
+// uploading separately
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include "abi.hpp"
+
+class dirty_region {
+   public:
+    // beyond this many rects, new ones are folded in as they arrive
+    static constexpr const size_t max_rects = 64;
+
+   private:
+    std::vector<espmon_rect_t> m_rects;
+    int64_t m_rect_cost;
+    static int64_t area(const espmon_rect_t& rect) {
+        return (int64_t)rect.width * rect.height;
+    }
+    static espmon_rect_t unite(const espmon_rect_t& lhs, const espmon_rect_t& rhs) {
+        espmon_rect_t result;
+        result.x = std::min(lhs.x, rhs.x);
+        result.y = std::min(lhs.y, rhs.y);
+        result.width = std::max(lhs.x + lhs.width, rhs.x + rhs.width) - result.x;
+        result.height = std::max(lhs.y + lhs.height, rhs.y + rhs.height) - result.y;
+        return result;
+    }
+    static bool contains(const espmon_rect_t& outer, const espmon_rect_t& inner) {
+        return inner.x >= outer.x && inner.y >= outer.y &&
+               inner.x + inner.width <= outer.x + outer.width &&
+               inner.y + inner.height <= outer.y + outer.height;
+    }
+    // the pixels a merge adds to the upload. negative when the two overlap
+    // enough that uploading them separately copies more
+    static int64_t waste(const espmon_rect_t& lhs, const espmon_rect_t& rhs) {
+        return area(unite(lhs, rhs)) - area(lhs) - area(rhs);
+    }
+    void merge(size_t i, size_t j) {
+        m_rects[i] = unite(m_rects[i], m_rects[j]);
+        m_rects[j] = m_rects.back();
+        m_rects.pop_back();
+    }
+
+   public:
+    // rect_cost is the overhead of uploading one more rect, in pixels
+    dirty_region(uint32_t rect_cost) : m_rect_cost(rect_cost) {
+    }
+    size_t size() const {
+        return m_rects.size();
+    }
+    void clear() {
+        m_rects.clear();
+    }
+    void add(const espmon_rect_t& rect) {
+        if (rect.width <= 0 || rect.height <= 0) {
+            return;
+        }
+        for (espmon_rect_t& r : m_rects) {
+            if (contains(r, rect)) {
+                return;
+            }
+        }
+        if (m_rects.size() >= max_rects) {
+            // fold it into whichever rect grows least
+            size_t best = 0;
+            int64_t best_waste = waste(m_rects[0], rect);
+            for (size_t i = 1; i < m_rects.size(); ++i) {
+                const int64_t w = waste(m_rects[i], rect);
+                if (w < best_waste) {
+                    best_waste = w;
+                    best = i;
+                }
+            }
+            m_rects[best] = unite(m_rects[best], rect);
+            return;
+        }
+        m_rects.push_back(rect);
+    }
+    // merges the pair that wastes the fewest pixels for as long as that
+    // costs less than uploading the rect separately, or until the rects fit
+    // in capacity. a rect inside another always merges away.
+    // writes them to out_rects and returns the count
+    uint32_t coalesce(espmon_rect_t* out_rects, uint32_t capacity) {
+        if (capacity == 0) {
+            return 0;
+        }
+        while (m_rects.size() > 1) {
+            size_t best_i = 0, best_j = 1;
+            int64_t best_waste = INT64_MAX;
+            for (size_t i = 0; i < m_rects.size(); ++i) {
+                for (size_t j = i + 1; j < m_rects.size(); ++j) {
+                    const int64_t w = waste(m_rects[i], m_rects[j]);
+                    if (w < best_waste) {
+                        best_waste = w;
+                        best_i = i;
+                        best_j = j;
+                    }
+                }
+            }
+            if (m_rects.size() <= capacity && best_waste > m_rect_cost) {
+                break;
+            }
+            merge(best_i, best_j);
+        }
+        std::copy(m_rects.begin(), m_rects.end(), out_rects);
+        return (uint32_t)m_rects.size();
+    }
+};
@@ -0,0 +1,145 @@
+#pragma once
+// Worker threads that run UpdateBatch() jobs for many instances at once
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "abi.hpp"
+
+class render_pool {
+   public:
+    // renders one job and returns the count of dirty rects written
+    typedef uint32_t (*run_callback_type)(const espmon_job_t& job);
+
+   private:
+    run_callback_type m_run;
+    std::vector<std::thread> m_threads;
+    std::mutex m_lock;
+    // signaled when a job is queued or an instance frees up
+    std::condition_variable m_ready;
+    // signaled when the last job finishes
+    std::condition_variable m_idle;
+    std::deque<espmon_job_t> m_queue;
+    // instances a worker is rendering right now. one instance never renders
+    // on two threads, and its jobs run in the order they were submitted
+    std::vector<espmon_handle_t> m_busy;
+    size_t m_pending;
+    bool m_stopping;
+    render_pool(const render_pool& rhs) = delete;
+    render_pool& operator=(const render_pool& rhs) = delete;
+    bool is_busy(espmon_handle_t handle) const {
+        for (espmon_handle_t h : m_busy) {
+            if (h == handle) return true;
+        }
+        return false;
+    }
+    void unbusy(espmon_handle_t handle) {
+        for (size_t i = 0; i < m_busy.size(); ++i) {
+            if (m_busy[i] == handle) {
+                m_busy[i] = m_busy.back();
+                m_busy.pop_back();
+                return;
+            }
+        }
+    }
+    // finds the oldest job whose instance isn't already being rendered
+    bool take(espmon_job_t* out_job) {
+        for (auto it = m_queue.begin(); it != m_queue.end(); ++it) {
+            if (!is_busy(it->handle)) {
+                *out_job = *it;
+                m_queue.erase(it);
+                m_busy.push_back(out_job->handle);
+                return true;
+            }
+        }
+        return false;
+    }
+    void worker() {
+        std::unique_lock<std::mutex> lock(m_lock);
+        while (true) {
+            espmon_job_t job;
+            job.handle = nullptr;
+            m_ready.wait(lock, [&] { return take(&job) || m_stopping; });
+            if (job.handle == nullptr) {
+                return;
+            }
+            lock.unlock();
+            const uint32_t count = m_run(job);
+            if (job.on_complete != nullptr) {
+                job.on_complete(job.handle, job.dirties_buffer, count, job.on_complete_state);
+            }
+            lock.lock();
+            unbusy(job.handle);
+            if (--m_pending == 0) {
+                m_idle.notify_all();
+            }
+            // a job held back behind this instance may be runnable now
+            m_ready.notify_all();
+        }
+    }
+
+   public:
+    render_pool(run_callback_type run) : m_run(run), m_pending(0), m_stopping(false) {
+    }
+    ~render_pool() {
+        stop();
+    }
+    // starts the workers. 0 uses one per hardware thread
+    bool start(size_t thread_count) {
+        if (thread_count == 0) {
+            thread_count = std::thread::hardware_concurrency();
+            if (thread_count == 0) thread_count = 1;
+        }
+        try {
+            m_threads.reserve(thread_count);
+            // so take() never allocates
+            m_busy.reserve(thread_count);
+            for (size_t i = 0; i < thread_count; ++i) {
+                m_threads.emplace_back(&render_pool::worker, this);
+            }
+        } catch (...) {
+            stop();
+            return false;
+        }
+        return true;
+    }
+    // runs what's queued, then joins the workers
+    void stop() {
+        wait();
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_stopping = true;
+        }
+        m_ready.notify_all();
+        for (std::thread& t : m_threads) {
+            t.join();
+        }
+        m_threads.clear();
+    }
+    // queues jobs. false if it ran out of memory, in which case only the
+    // jobs before the failed one were queued
+    bool submit(const espmon_job_t* jobs, size_t count) {
+        bool result = true;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            try {
+                for (size_t i = 0; i < count; ++i) {
+                    if (jobs[i].handle != nullptr) {
+                        m_queue.push_back(jobs[i]);
+                        ++m_pending;
+                    }
+                }
+            } catch (...) {
+                result = false;
+            }
+        }
+        m_ready.notify_all();
+        return result;
+    }
+    // blocks until every submitted job has completed
+    void wait() {
+        std::unique_lock<std::mutex> lock(m_lock);
+        m_idle.wait(lock, [&] { return m_pending == 0; });
+    }
+};
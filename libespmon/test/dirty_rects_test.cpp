@@ -0,0 +1,117 @@
+// Checks that Update() and UpdateBatch() report the areas a frame changed
+// rather than the whole screen, which direct mode flushes every time.
+// Exits non-zero on the first failure. Run through ctest
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "abi.hpp"
+
+static const uint16_t width = 320;
+static const uint16_t height = 240;
+static const uint32_t max_dirties = 16;
+
+static void set_color(response_color_t* col, uint8_t r, uint8_t g, uint8_t b) {
+    col->a = 255;
+    col->r = r;
+    col->g = g;
+    col->b = b;
+}
+static void make_screen(response_t* resp) {
+    memset(resp, 0, sizeof(response_t));
+    response_screen_t& scr = resp->screen;
+    scr.header.index = 0;
+    strcpy(scr.top.label, "CPU");
+    set_color(&scr.top.color, 0, 255, 255);
+    set_color(&scr.top.value1.color, 0, 255, 0);
+    strcpy(scr.top.value1.suffix, "%");
+    set_color(&scr.top.value2.color, 255, 165, 0);
+    strcpy(scr.top.value2.suffix, "C");
+    strcpy(scr.bottom.label, "RAM");
+    set_color(&scr.bottom.color, 255, 0, 255);
+    set_color(&scr.bottom.value1.color, 255, 255, 255);
+    strcpy(scr.bottom.value1.suffix, "%");
+    set_color(&scr.bottom.value2.color, 128, 0, 128);
+    strcpy(scr.bottom.value2.suffix, "MHz");
+}
+static void make_data(response_t* resp) {
+    memset(resp, 0, sizeof(response_t));
+    response_data_t& data = resp->data;
+    data.top.value1 = {50.f, .5f};
+    data.top.value2 = {60.f, .6f};
+    data.bottom.value1 = {25.f, .25f};
+    data.bottom.value2 = {3000.f, .75f};
+}
+static bool intersects(const espmon_rect_t& lhs, const espmon_rect_t& rhs) {
+    return lhs.x < rhs.x + rhs.width && rhs.x < lhs.x + lhs.width &&
+           lhs.y < rhs.y + rhs.height && rhs.y < lhs.y + lhs.height;
+}
+static int fail(const char* message) {
+    fprintf(stderr, "FAIL: %s\n", message);
+    return 1;
+}
+int main() {
+    espmon_handle_t handle = Create();
+    if (handle == nullptr) {
+        return fail("out of memory");
+    }
+    std::vector<uint8_t> buffer((size_t)width * height * 4);
+    SetDimensions(handle, width, height);
+    // no graph, so only the labels and bars are left to change
+    SetGraph(handle, 0);
+    // after Create() has initialized the screens, like the host does
+    SetTransfer(handle, buffer.data(), (uint32_t)buffer.size());
+    espmon_rect_t dirties[max_dirties];
+    uint32_t count;
+    response_t screen;
+    make_screen(&screen);
+    count = max_dirties;
+    Update(handle, CMD_SCREEN, &screen, dirties, &count);
+    // fill the sparkline histories with the same frame, so they stop moving
+    response_t data;
+    make_data(&data);
+    for (int i = 0; i < 256; ++i) {
+        count = max_dirties;
+        Update(handle, CMD_DATA, &data, dirties, &count);
+    }
+
+    // one label's text changes
+    data.data.top.value1.value = 51.f;
+    count = max_dirties;
+    Update(handle, CMD_DATA, &data, dirties, &count);
+    if (count == 0) {
+        Destroy(handle);
+        return fail("Update() reported nothing for a changed value");
+    }
+    int64_t area = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        area += (int64_t)dirties[i].width * dirties[i].height;
+    }
+    if (area >= (int64_t)width * height) {
+        Destroy(handle);
+        return fail("Update() reported the whole screen for one changed value");
+    }
+
+    // two labels at opposite corners change in one batch. The first frame
+    // is folded away
+    response_t frames[2];
+    frames[0] = data;
+    frames[0].data.top.value1.value = 52.f;
+    frames[1] = data;
+    frames[1].data.top.value1.value = 53.f;
+    frames[1].data.bottom.value2.value = 3001.f;
+    const espmon_packet_t packets[] = {{CMD_DATA, &frames[0]}, {CMD_DATA, &frames[1]}};
+    count = max_dirties;
+    UpdateBatch(handle, packets, 2, dirties, &count);
+    if (count != 2) {
+        fprintf(stderr, "UpdateBatch() reported %u rects\n", (unsigned)count);
+        Destroy(handle);
+        return fail("UpdateBatch() should report one rect per changed label");
+    }
+    if (intersects(dirties[0], dirties[1])) {
+        Destroy(handle);
+        return fail("UpdateBatch() reported overlapping rects for separate labels");
+    }
+    Destroy(handle);
+    puts("dirty_rects_test: ok");
+    return 0;
+}
@@ -0,0 +1,80 @@
+// Checks that folded data frames still go into the history on a board
+// without a graph, where the bars' sparklines draw it: a batch of N frames
+// has to move the history by N samples.
+// Exits non-zero on the first failure. Run through ctest
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#define MONOXBOLD_IMPLEMENTATION
+#include <monoxbold.hpp>
+#undef MONOXBOLD_IMPLEMENTATION
+#include <espmon.hpp>
+
+using espmon_t = espmon<gfx::bitmap<gfx::rgb_pixel<16>>>;
+static const uint16_t width = 320;
+static const uint16_t height = 240;
+static const size_t batch = 5;
+
+static void make_data(response_t* resp, float scaled) {
+    memset(resp, 0, sizeof(response_t));
+    response_value_t* values[] = {&resp->data.top.value1, &resp->data.top.value2, &resp->data.bottom.value1, &resp->data.bottom.value2};
+    for (response_value_t* value : values) {
+        value->value = scaled * 100.f;
+        value->scaled = scaled;
+    }
+}
+static int fail(const char* message) {
+    fprintf(stderr, "FAIL: %s\n", message);
+    return 1;
+}
+int main() {
+    espmon_t* app = new espmon_t();
+    std::vector<uint8_t> buffer((size_t)width * height * 2);
+    // same setup order as the firmware
+    app->dimensions({width, height});
+    app->set_flush_callback([](const uix::rect16& bounds, const void* bmp, void* state) {
+        ((espmon_t*)state)->transfer_complete();
+    }, app);
+    app->set_transfer(uix::screen_update_mode::direct, buffer.data(), buffer.size());
+    app->has_graph(false);
+    app->initialize();
+    response_t resp;
+    memset(&resp, 0, sizeof(resp));
+    strcpy(resp.screen.top.label, "CPU");
+    strcpy(resp.screen.bottom.label, "RAM");
+    app->accept_packet(CMD_SCREEN, resp);
+    make_data(&resp, .1f);
+    app->accept_packet(CMD_DATA, resp);
+    if (app->history(0).size() != 1) {
+        delete app;
+        return fail("a data frame didn't go into the history");
+    }
+    // what UpdateBatch() and the firmware do with a burst: all but the last
+    // frame are folded, and the last is drawn
+    for (size_t i = 0; i < batch; ++i) {
+        make_data(&resp, .2f + i * .1f);
+        if (i + 1 < batch) {
+            app->fold_data(resp.data);
+        } else {
+            app->accept_packet(CMD_DATA, resp);
+        }
+    }
+    for (size_t index = 0; index < 4; ++index) {
+        const auto& history = app->history(index);
+        if (history.size() != 1 + batch) {
+            fprintf(stderr, "value %d has %d samples\n", (int)index, (int)history.size());
+            delete app;
+            return fail("a batch of frames didn't move the history by as many samples");
+        }
+        for (size_t i = 0; i < batch; ++i) {
+            const uint8_t expected = (uint8_t)((.2f + i * .1f) * 255);
+            if (*history.peek(1 + i) != expected) {
+                delete app;
+                return fail("a folded frame went into the history out of order");
+            }
+        }
+    }
+    delete app;
+    puts("fold_data_test: ok");
+    return 0;
+}